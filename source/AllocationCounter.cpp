@@ -0,0 +1,52 @@
+#include "pch.h"
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace
+{
+	// Relaxed: only the total matters, not the order the threads counted in
+	std::atomic<uint64_t> NrAllocations{};
+
+	void* Allocate(size_t size)
+	{
+		NrAllocations.fetch_add(1, std::memory_order_relaxed);
+
+		// Zero bytes still has to give a unique pointer
+		if (void* pMemory{ std::malloc(size != 0 ? size : 1) })
+			return pMemory;
+		throw std::bad_alloc{};
+	}
+
+	void* AllocateAligned(size_t size, std::align_val_t alignment)
+	{
+		NrAllocations.fetch_add(1, std::memory_order_relaxed);
+
+		if (void* pMemory{ _aligned_malloc(size != 0 ? size : 1, size_t(alignment)) })
+			return pMemory;
+		throw std::bad_alloc{};
+	}
+}
+
+uint64_t dae::AllocationCounter::GetNrAllocations()
+{
+	return NrAllocations.load(std::memory_order_relaxed);
+}
+
+// The nothrow versions call these, so they get counted as well
+void* operator new(size_t size) { return Allocate(size); }
+void* operator new[](size_t size) { return Allocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+
+void operator delete(void* pMemory) noexcept { std::free(pMemory); }
+void operator delete[](void* pMemory) noexcept { std::free(pMemory); }
+void operator delete(void* pMemory, size_t) noexcept { std::free(pMemory); }
+void operator delete[](void* pMemory, size_t) noexcept { std::free(pMemory); }
+void operator delete(void* pMemory, std::align_val_t) noexcept { _aligned_free(pMemory); }
+void operator delete[](void* pMemory, std::align_val_t) noexcept { _aligned_free(pMemory); }
+void operator delete(void* pMemory, size_t, std::align_val_t) noexcept { _aligned_free(pMemory); }
+void operator delete[](void* pMemory, size_t, std::align_val_t) noexcept { _aligned_free(pMemory); }
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+
+namespace dae
+{
+	// The global operator new and delete are replaced, so every allocation through them is counted, on every thread
+	// Only the Tests project links it, the app and the benchmarks keep the allocator of the runtime
+	namespace AllocationCounter
+	{
+		uint64_t GetNrAllocations();
+	}
+}
@@ -0,0 +1,52 @@
+#include "pch.h"
+#include "Tests.h"
+#include "Renderer.h"
+#include "AllocationCounter.h"
+
+namespace dae
+{
+	bool Tests::RunAllocations(SDL_Window* pWindow)
+	{
+		// Once its buffers are warmed up the software renderer reuses them, a frame that allocates grew one past its peak size
+		// The validation allocates on purpose and stays off
+		Renderer renderer{ pWindow };
+		renderer.ToggleDirectX();
+		Timer timer{};
+
+		// Every one toggles a single setting of the one before
+		struct Configuration final
+		{
+			const char* pName;
+			void(Renderer::*pToggle)();
+		};
+		constexpr Configuration configurations[]
+		{
+			{ "forward shading, linear framebuffer", nullptr },
+			{ "deferred shading, linear framebuffer", &Renderer::ToggleDeferredShading },
+			{ "deferred shading, tiled framebuffer", &Renderer::ToggleFramebufferLayout },
+			{ "forward shading, tiled framebuffer", &Renderer::ToggleDeferredShading },
+		};
+
+		constexpr int nrWarmUpFrames{ 10 };
+		constexpr int nrFrames{ 100 };
+		bool hasPassed{ true };
+		for (const Configuration& configuration : configurations)
+		{
+			if (configuration.pToggle)
+				(renderer.*configuration.pToggle)();
+
+			if (!RenderFrames(renderer, timer, nrWarmUpFrames))
+				return false;
+
+			const uint64_t startAllocations{ AllocationCounter::GetNrAllocations() };
+			RenderFrames(renderer, timer, nrFrames);
+			const uint64_t nrAllocations{ AllocationCounter::GetNrAllocations() - startAllocations };
+
+			std::cout << configuration.pName << ": " << nrAllocations << " heap allocations in " << nrFrames << " frames\n";
+			if (nrAllocations > 0)
+				hasPassed = false;
+		}
+
+		return hasPassed;
+	}
+}
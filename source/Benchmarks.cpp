@@ -0,0 +1,114 @@
+#include "pch.h"
+#include "Benchmarks.h"
+#include "Renderer.h"
+#include <cstring>
+
+#undef main
+
+using namespace dae;
+
+namespace
+{
+	struct Benchmark final
+	{
+		const char* pName;
+		const char* pDescription;
+		void(*pRun)(SDL_Window* pWindow);
+	};
+
+	constexpr Benchmark BenchmarkList[]
+	{
+		{ "setup", "software triangle setup and raster time on vehicle.obj", &Benchmarks::RunTriangleSetup },
+		{ "lods", "software frame time of every level of detail of vehicle.obj while the camera backs away", &Benchmarks::RunLodSweep },
+		{ "vertices", "vertices/s of every vertex kernel on vehicle.obj and a 1M vertex grid", &Benchmarks::RunVertexTransform },
+		{ "loader", "parse MB/s, tangents, cook and cache load of vehicle.obj and a 250K vertex grid on one and every thread", &Benchmarks::RunLoader },
+		{ "samples", "samples/s of vehicle_diffuse.png through SDL_GetRGB like before, as RGBA8 and as floats", &Benchmarks::RunTextureSampling },
+		{ "filters", "samples/s and modelled L1 misses of minified vehicle_diffuse.png, software frame time of every filter at distance", &Benchmarks::RunFilterDistance },
+		{ "layouts", "software frame time of the linear and the tiled texel layout with every filter while the vehicle turns", &Benchmarks::RunTexelLayouts },
+		{ "bc", "decode blocks/s, samples/s and memory of the vehicle textures block compressed against RGBA8", &Benchmarks::RunBlockCompression },
+	};
+
+	constexpr int NrWarmUpFrames{ 10 };
+}
+
+double dae::Benchmarks::GetMilliseconds(uint64_t startCounter)
+{
+	return (SDL_GetPerformanceCounter() - startCounter) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+bool dae::Benchmarks::RenderFrames(Renderer& renderer, Timer& timer, int nrFrames)
+{
+	for (int frameIdx{}; frameIdx < NrWarmUpFrames + nrFrames; ++frameIdx)
+	{
+		if (frameIdx == NrWarmUpFrames)
+			renderer.ResetStatistics();
+
+		timer.Update();
+		renderer.Update(&timer);
+		renderer.Render();
+	}
+
+	if (renderer.GetStatistics().nrFrames > 0)
+		return true;
+
+	std::cout << "No software frames were rendered\n";
+	return false;
+}
+
+dae::Benchmarks::SilencedOutput::SilencedOutput()
+	: m_pBuffer{ std::cout.rdbuf(nullptr) }
+{
+}
+
+dae::Benchmarks::SilencedOutput::~SilencedOutput()
+{
+	// Writing without a buffer set the bad bit
+	std::cout.rdbuf(m_pBuffer);
+	std::cout.clear();
+}
+
+int main(int argc, char* args[])
+{
+	const auto isNamed{ [&](const char* pName)
+		{
+			return std::any_of(args + 1, args + argc, [&](const char* pArg) { return std::strcmp(pArg, pName) == 0; });
+		} };
+
+	for (int argIdx{ 1 }; argIdx < argc; ++argIdx)
+	{
+		if (std::none_of(std::begin(BenchmarkList), std::end(BenchmarkList), [&](const Benchmark& benchmark) { return std::strcmp(benchmark.pName, args[argIdx]) == 0; }))
+		{
+			std::cout << "Unknown benchmark " << args[argIdx] << ", expected one of:\n";
+			for (const Benchmark& benchmark : BenchmarkList)
+			{
+				std::cout << "  " << benchmark.pName << ": " << benchmark.pDescription << '\n';
+			}
+			return 1;
+		}
+	}
+
+	SDL_Init(SDL_INIT_VIDEO);
+
+	// Hidden, the software frames are still presented to its surface and DirectX still creates its swap chain
+	SDL_Window* pWindow = SDL_CreateWindow(
+		"DualRasterizer - Benchmarks",
+		SDL_WINDOWPOS_UNDEFINED,
+		SDL_WINDOWPOS_UNDEFINED,
+		640, 480, SDL_WINDOW_HIDDEN);
+
+	if (!pWindow)
+		return 1;
+
+	for (const Benchmark& benchmark : BenchmarkList)
+	{
+		if (argc > 1 && !isNamed(benchmark.pName))
+			continue;
+
+		std::cout << "\n=== " << benchmark.pName << ": " << benchmark.pDescription << '\n';
+		benchmark.pRun(pWindow);
+	}
+
+	SDL_DestroyWindow(pWindow);
+	SDL_Quit();
+	return 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+
+struct SDL_Window;
+
+namespace dae
+{
+	class Renderer;
+	class Timer;
+
+	// Each benchmark prints its own results, the Benchmarks project runs the ones named on its command line or all of them
+	// The ones that render create their own renderer in the hidden window, DirectX still has to initialize for the meshes
+	namespace Benchmarks
+	{
+		// From the SDL performance counter, like the renderer statistics
+		double GetMilliseconds(uint64_t startCounter);
+		// Renders a few frames to warm up the buffers and caches, then nrFrames that the statistics are reset for
+		// False when no software frame was rendered
+		bool RenderFrames(Renderer& renderer, Timer& timer, int nrFrames);
+
+		// Drops everything written to std::cout while it exists
+		class SilencedOutput final
+		{
+		public:
+			SilencedOutput();
+			~SilencedOutput();
+
+			SilencedOutput(const SilencedOutput& other) = delete;
+			SilencedOutput(SilencedOutput&& other) = delete;
+			SilencedOutput& operator=(const SilencedOutput& other) = delete;
+			SilencedOutput& operator=(SilencedOutput&& other) = delete;
+
+		private:
+			std::streambuf* m_pBuffer;
+		};
+
+		void RunTriangleSetup(SDL_Window* pWindow);
+		void RunLodSweep(SDL_Window* pWindow);
+		void RunVertexTransform(SDL_Window* pWindow);
+		void RunLoader(SDL_Window* pWindow);
+		void RunTextureSampling(SDL_Window* pWindow);
+		void RunFilterDistance(SDL_Window* pWindow);
+		void RunTexelLayouts(SDL_Window* pWindow);
+		void RunBlockCompression(SDL_Window* pWindow);
+	}
+}
@@ -0,0 +1,885 @@
+#include "pch.h"
+#include "BlockCompression.h"
+
+#include <array>
+#include <cfloat>
+#include <cstring>
+
+namespace dae
+{
+	namespace
+	{
+		using BlockCompression::TexelsPerBlock;
+
+		// A texel with its channels as floats in [0, 255], the encoders work on these
+		using Channels = std::array<float, 4>;
+		using BlockTexels = std::array<Channels, TexelsPerBlock>;
+
+		uint32_t PackTexel(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha)
+		{
+			return red | green << 8 | blue << 16 | alpha << 24;
+		}
+
+		uint8_t GetChannel(uint32_t texel, int channel)
+		{
+			return uint8_t(texel >> (8 * channel));
+		}
+
+		// The 128 bits of a BC7 block, read and written from the lowest bit of the first byte up
+		class BitReader final
+		{
+		public:
+			explicit BitReader(const uint8_t* pBlock)
+			{
+				std::memcpy(&m_Low, pBlock, sizeof(m_Low));
+				std::memcpy(&m_High, pBlock + sizeof(m_Low), sizeof(m_High));
+			}
+
+			uint32_t Read(int nrBits)
+			{
+				if (nrBits == 0)
+					return 0;
+
+				const uint32_t value{ uint32_t(m_Low & ((1ull << nrBits) - 1)) };
+				m_Low = m_Low >> nrBits | m_High << (64 - nrBits);
+				m_High >>= nrBits;
+				return value;
+			}
+
+		private:
+			uint64_t m_Low{};
+			uint64_t m_High{};
+		};
+
+		class BitWriter final
+		{
+		public:
+			void Write(uint32_t value, int nrBits)
+			{
+				const uint64_t bits{ value & ((1ull << nrBits) - 1) };
+				if (m_Position < 64)
+				{
+					m_Low |= bits << m_Position;
+					if (m_Position + nrBits > 64)
+						m_High |= bits >> (64 - m_Position);
+				}
+				else
+				{
+					m_High |= bits << (m_Position - 64);
+				}
+				m_Position += nrBits;
+			}
+
+			void Store(uint8_t* pBlock) const
+			{
+				std::memcpy(pBlock, &m_Low, sizeof(m_Low));
+				std::memcpy(pBlock + sizeof(m_Low), &m_High, sizeof(m_High));
+			}
+
+		private:
+			uint64_t m_Low{};
+			uint64_t m_High{};
+			int m_Position{};
+		};
+
+		// BC1 and BC3 colors
+
+		uint32_t Expand565(uint16_t color)
+		{
+			const uint32_t red{ uint32_t(color >> 11 & 0x1F) };
+			const uint32_t green{ uint32_t(color >> 5 & 0x3F) };
+			const uint32_t blue{ uint32_t(color & 0x1F) };
+			return PackTexel(red << 3 | red >> 2, green << 2 | green >> 4, blue << 3 | blue >> 2, 0xFF);
+		}
+
+		// Per channel (weight0 * color0 + weight1 * color1) / divisor rounded to nearest, the alpha of color0.
+		// The D3D spec interpolates in float, hardware may be a step off either way
+		uint32_t MixColors(uint32_t color0, uint32_t color1, uint32_t weight0, uint32_t weight1, uint32_t divisor)
+		{
+			uint32_t mixed{ color0 & 0xFF000000 };
+			for (int channel{}; channel < 3; ++channel)
+			{
+				mixed |= (weight0 * GetChannel(color0, channel) + weight1 * GetChannel(color1, channel) + divisor / 2) / divisor << (8 * channel);
+			}
+			return mixed;
+		}
+
+		// A BC1 block with color0 <= color1 has 3 colors and transparent black, BC3 always has 4 colors
+		int GetColorPalette(uint16_t color0, uint16_t color1, bool isBc1, uint32_t palette[4])
+		{
+			palette[0] = Expand565(color0);
+			palette[1] = Expand565(color1);
+			if (color0 > color1 || !isBc1)
+			{
+				palette[2] = MixColors(palette[0], palette[1], 2, 1, 3);
+				palette[3] = MixColors(palette[0], palette[1], 1, 2, 3);
+				return 4;
+			}
+
+			palette[2] = MixColors(palette[0], palette[1], 1, 1, 2);
+			palette[3] = 0;
+			return 3;
+		}
+
+		void DecodeColors(const uint8_t* pBlock, bool isBc1, uint32_t texels[TexelsPerBlock])
+		{
+			uint32_t palette[4];
+			GetColorPalette(uint16_t(pBlock[0] | pBlock[1] << 8), uint16_t(pBlock[2] | pBlock[3] << 8), isBc1, palette);
+
+			uint32_t indices;
+			std::memcpy(&indices, pBlock + 4, sizeof(indices));
+			for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+			{
+				texels[texelIdx] = palette[indices >> (2 * texelIdx) & 3];
+			}
+		}
+
+		// BC3 alpha and BC5 channels
+
+		// 8 values, or 6 plus 0 and 255 when value0 <= value1, rounded like the colors
+		void GetChannelPalette(uint8_t value0, uint8_t value1, uint8_t palette[8])
+		{
+			palette[0] = value0;
+			palette[1] = value1;
+			if (value0 > value1)
+			{
+				for (int idx{ 2 }; idx < 8; ++idx)
+				{
+					palette[idx] = uint8_t(((8 - idx) * value0 + (idx - 1) * value1 + 3) / 7);
+				}
+				return;
+			}
+
+			for (int idx{ 2 }; idx < 6; ++idx)
+			{
+				palette[idx] = uint8_t(((6 - idx) * value0 + (idx - 1) * value1 + 2) / 5);
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		// Two values and 16 indices of 3 bits
+		void DecodeChannel(const uint8_t* pBlock, uint32_t texels[TexelsPerBlock], int channel)
+		{
+			uint8_t values[8];
+			GetChannelPalette(pBlock[0], pBlock[1], values);
+			uint32_t palette[8];
+			for (int entry{}; entry < 8; ++entry)
+			{
+				palette[entry] = uint32_t(values[entry]) << (8 * channel);
+			}
+
+			uint64_t indices{};
+			std::memcpy(&indices, pBlock + 2, 6);
+			for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+			{
+				texels[texelIdx] |= palette[indices >> (3 * texelIdx) & 7];
+			}
+		}
+
+		// BC7
+
+		struct Bc7Mode final
+		{
+			int nrSubsets;
+			int partitionBits;
+			int rotationBits;
+			int indexSelectionBits;
+			int colorBits;
+			int alphaBits;
+			// One p-bit per endpoint or one per subset, the lowest bit of every channel of the endpoint
+			int endpointPBits;
+			int sharedPBits;
+			int indexBits;
+			// Modes 4 and 5 interpolate color and alpha with their own indices
+			int secondaryIndexBits;
+		};
+
+		constexpr Bc7Mode Bc7Modes[8]{
+			{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+			{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+			{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+			{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+			{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+			{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+			{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+			{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+		};
+
+		// Interpolation weights out of 64 for 2, 3 and 4 bit indices
+		constexpr uint32_t Bc7Weights2[4]{ 0, 21, 43, 64 };
+		constexpr uint32_t Bc7Weights3[8]{ 0, 9, 18, 27, 37, 46, 55, 64 };
+		constexpr uint32_t Bc7Weights4[16]{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		// The subset of every texel, one bit per texel for 2 subsets and two bits for 3
+		constexpr uint16_t Bc7Partitions2[64]{
+			0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+			0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+			0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+			0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+			0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+			0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+			0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+			0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+		};
+		constexpr uint32_t Bc7Partitions3[64]{
+			0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+			0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+			0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+			0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+			0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+			0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+			0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+			0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254
+		};
+
+		// The anchor texel of every subset after the first, its index is stored without the highest bit, which is 0.
+		// Subset 0 always anchors at texel 0
+		constexpr uint8_t Bc7Anchors2[64]{
+			15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+			15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+			15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+			6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15
+		};
+		constexpr uint8_t Bc7Anchors3Second[64]{
+			3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+			3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+			8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+			3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3
+		};
+		constexpr uint8_t Bc7Anchors3Third[64]{
+			15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+			15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+			15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+			15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8
+		};
+
+		const uint32_t* GetBc7Weights(int indexBits)
+		{
+			return indexBits == 2 ? Bc7Weights2 : indexBits == 3 ? Bc7Weights3 : Bc7Weights4;
+		}
+
+		uint32_t Bc7Interpolate(uint32_t value0, uint32_t value1, uint32_t weight)
+		{
+			return ((64 - weight) * value0 + weight * value1 + 32) >> 6;
+		}
+
+		// The bits of an endpoint channel, p-bit included, repeated down to 8 bits
+		uint32_t Bc7Expand(uint32_t value, int nrBits)
+		{
+			return value << (8 - nrBits) | value >> (2 * nrBits - 8);
+		}
+
+		// One RGBA line of 7 bit endpoints plus a p-bit each and 4 bit indices, the only mode the encoder below writes.
+		// The fields sit at fixed bits, so it skips the bit reader
+		void DecodeBc7Mode6(const uint8_t* pBlock, uint32_t texels[TexelsPerBlock])
+		{
+			uint64_t low;
+			uint64_t high;
+			std::memcpy(&low, pBlock, sizeof(low));
+			std::memcpy(&high, pBlock + sizeof(low), sizeof(high));
+
+			// Channel c of endpoint e is at bit 7 + 14 * c + 7 * e, the p-bits are bits 63 and 64
+			uint32_t palette[16]{};
+			for (int channel{}; channel < 4; ++channel)
+			{
+				const uint32_t value0{ uint32_t(low >> (7 + 14 * channel) & 0x7F) << 1 | uint32_t(low >> 63) };
+				const uint32_t value1{ uint32_t(low >> (14 + 14 * channel) & 0x7F) << 1 | uint32_t(high & 1) };
+				for (int entry{}; entry < 16; ++entry)
+				{
+					palette[entry] |= Bc7Interpolate(value0, value1, Bc7Weights4[entry]) << (8 * channel);
+				}
+			}
+
+			// Texel 0 has 3 bits from bit 65, texel i 4 bits from bit 64 + 4 * i
+			texels[0] = palette[high >> 1 & 7];
+			for (int texelIdx{ 1 }; texelIdx < TexelsPerBlock; ++texelIdx)
+			{
+				texels[texelIdx] = palette[high >> (4 * texelIdx) & 15];
+			}
+		}
+
+		void DecodeBc7(const uint8_t* pBlock, uint32_t texels[TexelsPerBlock])
+		{
+			if ((pBlock[0] & 0x7F) == 0x40)
+			{
+				DecodeBc7Mode6(pBlock, texels);
+				return;
+			}
+
+			BitReader reader{ pBlock };
+
+			// The mode is the amount of 0 bits before the first 1, a block without a 1 decodes to transparent black
+			int modeIdx{};
+			while (modeIdx < 8 && reader.Read(1) == 0)
+			{
+				++modeIdx;
+			}
+			if (modeIdx == 8)
+			{
+				std::fill_n(texels, TexelsPerBlock, 0u);
+				return;
+			}
+
+			const Bc7Mode& mode{ Bc7Modes[modeIdx] };
+			const uint32_t partition{ reader.Read(mode.partitionBits) };
+			const uint32_t rotation{ reader.Read(mode.rotationBits) };
+			const uint32_t indexSelection{ reader.Read(mode.indexSelectionBits) };
+
+			// Subset s has endpoints 2 * s and 2 * s + 1, stored channel by channel
+			const int nrEndpoints{ 2 * mode.nrSubsets };
+			uint32_t endpoints[6][4]{};
+			for (int channel{}; channel < 3; ++channel)
+			{
+				for (int endpoint{}; endpoint < nrEndpoints; ++endpoint)
+				{
+					endpoints[endpoint][channel] = reader.Read(mode.colorBits);
+				}
+			}
+			for (int endpoint{}; endpoint < nrEndpoints; ++endpoint)
+			{
+				endpoints[endpoint][3] = reader.Read(mode.alphaBits);
+			}
+
+			int colorBits{ mode.colorBits };
+			int alphaBits{ mode.alphaBits };
+			if (mode.endpointPBits != 0 || mode.sharedPBits != 0)
+			{
+				uint32_t pBits[6]{};
+				for (int endpoint{}; endpoint < nrEndpoints; ++endpoint)
+				{
+					pBits[endpoint] = mode.endpointPBits != 0 || endpoint % 2 == 0 ? reader.Read(1) : pBits[endpoint - 1];
+				}
+				for (int endpoint{}; endpoint < nrEndpoints; ++endpoint)
+				{
+					for (uint32_t& value : endpoints[endpoint])
+					{
+						value = value << 1 | pBits[endpoint];
+					}
+				}
+				++colorBits;
+				if (alphaBits != 0)
+					++alphaBits;
+			}
+			for (uint32_t(&endpoint)[4] : endpoints)
+			{
+				for (int channel{}; channel < 3; ++channel)
+				{
+					endpoint[channel] = Bc7Expand(endpoint[channel], colorBits);
+				}
+				endpoint[3] = alphaBits != 0 ? Bc7Expand(endpoint[3], alphaBits) : 255;
+			}
+
+			uint32_t subsets[TexelsPerBlock]{};
+			bool isAnchor[TexelsPerBlock]{ true };
+			for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+			{
+				if (mode.nrSubsets == 2)
+					subsets[texelIdx] = Bc7Partitions2[partition] >> texelIdx & 1;
+				else if (mode.nrSubsets == 3)
+					subsets[texelIdx] = Bc7Partitions3[partition] >> (2 * texelIdx) & 3;
+			}
+			if (mode.nrSubsets == 2)
+			{
+				isAnchor[Bc7Anchors2[partition]] = true;
+			}
+			else if (mode.nrSubsets == 3)
+			{
+				isAnchor[Bc7Anchors3Second[partition]] = true;
+				isAnchor[Bc7Anchors3Third[partition]] = true;
+			}
+
+			uint32_t indices[TexelsPerBlock];
+			for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+			{
+				indices[texelIdx] = reader.Read(mode.indexBits - isAnchor[texelIdx]);
+			}
+			uint32_t secondaryIndices[TexelsPerBlock]{};
+			if (mode.secondaryIndexBits != 0)
+			{
+				for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+				{
+					secondaryIndices[texelIdx] = reader.Read(mode.secondaryIndexBits - (texelIdx == 0));
+				}
+			}
+
+			// Without secondary indices both use the primary ones, the index selection bit of mode 4 swaps them
+			const bool hasSecondary{ mode.secondaryIndexBits != 0 };
+			const uint32_t* pColorIndices{ hasSecondary && indexSelection != 0 ? secondaryIndices : indices };
+			const uint32_t* pAlphaIndices{ hasSecondary && indexSelection == 0 ? secondaryIndices : indices };
+			const uint32_t* pColorWeights{ GetBc7Weights(pColorIndices == indices ? mode.indexBits : mode.secondaryIndexBits) };
+			const uint32_t* pAlphaWeights{ GetBc7Weights(pAlphaIndices == indices ? mode.indexBits : mode.secondaryIndexBits) };
+
+			for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+			{
+				const uint32_t* pEndpoint0{ endpoints[2 * subsets[texelIdx]] };
+				const uint32_t* pEndpoint1{ endpoints[2 * subsets[texelIdx] + 1] };
+				const uint32_t colorWeight{ pColorWeights[pColorIndices[texelIdx]] };
+				uint32_t channels[4];
+				for (int channel{}; channel < 3; ++channel)
+				{
+					channels[channel] = Bc7Interpolate(pEndpoint0[channel], pEndpoint1[channel], colorWeight);
+				}
+				channels[3] = Bc7Interpolate(pEndpoint0[3], pEndpoint1[3], pAlphaWeights[pAlphaIndices[texelIdx]]);
+
+				// Rotation 1 to 3 swaps alpha with red, green or blue
+				if (rotation != 0)
+					std::swap(channels[3], channels[rotation - 1]);
+				texels[texelIdx] = PackTexel(channels[0], channels[1], channels[2], channels[3]);
+			}
+		}
+
+		// Encoders
+
+		float GetSquaredDistance(const Channels& channels, uint32_t texel, int nrChannels)
+		{
+			float distance{};
+			for (int channel{}; channel < nrChannels; ++channel)
+			{
+				const float difference{ channels[channel] - GetChannel(texel, channel) };
+				distance += difference * difference;
+			}
+			return distance;
+		}
+
+		// Picks the closest palette entry for every texel, returns the total squared error
+		float FindIndices(const BlockTexels& texels, const uint32_t* pPalette, int nrEntries, int nrChannels, uint32_t indices[TexelsPerBlock])
+		{
+			float error{};
+			for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+			{
+				float closest{ FLT_MAX };
+				for (int entry{}; entry < nrEntries; ++entry)
+				{
+					const float distance{ GetSquaredDistance(texels[texelIdx], pPalette[entry], nrChannels) };
+					if (distance < closest)
+					{
+						closest = distance;
+						indices[texelIdx] = entry;
+					}
+				}
+				error += closest;
+			}
+			return error;
+		}
+
+		// The line through the texels with the most spread: the principal axis through their mean, by power iteration,
+		// cut off at the outermost texels
+		void FitLine(const BlockTexels& texels, int nrChannels, Channels& endpoint0, Channels& endpoint1)
+		{
+			Channels mean{};
+			for (const Channels& texel : texels)
+			{
+				for (int channel{}; channel < nrChannels; ++channel)
+				{
+					mean[channel] += texel[channel] / TexelsPerBlock;
+				}
+			}
+
+			float covariance[4][4]{};
+			for (const Channels& texel : texels)
+			{
+				for (int row{}; row < nrChannels; ++row)
+				{
+					for (int column{}; column < nrChannels; ++column)
+					{
+						covariance[row][column] += (texel[row] - mean[row]) * (texel[column] - mean[column]);
+					}
+				}
+			}
+
+			// Starting from the row of the channel with the most variance, it is never perpendicular to the axis
+			int widestChannel{};
+			for (int channel{ 1 }; channel < nrChannels; ++channel)
+			{
+				if (covariance[channel][channel] > covariance[widestChannel][widestChannel])
+					widestChannel = channel;
+			}
+			endpoint0 = mean;
+			endpoint1 = mean;
+			if (covariance[widestChannel][widestChannel] <= FLT_MIN)
+				return;
+
+			Channels axis{ covariance[widestChannel][0], covariance[widestChannel][1], covariance[widestChannel][2], covariance[widestChannel][3] };
+			for (int iteration{}; iteration < 8; ++iteration)
+			{
+				Channels next{};
+				float largest{};
+				for (int row{}; row < nrChannels; ++row)
+				{
+					for (int column{}; column < nrChannels; ++column)
+					{
+						next[row] += covariance[row][column] * axis[column];
+					}
+					largest = std::max(largest, std::abs(next[row]));
+				}
+				if (largest <= FLT_MIN)
+					break;
+				for (int channel{}; channel < nrChannels; ++channel)
+				{
+					axis[channel] = next[channel] / largest;
+				}
+			}
+
+			float squaredLength{};
+			for (int channel{}; channel < nrChannels; ++channel)
+			{
+				squaredLength += axis[channel] * axis[channel];
+			}
+			float minProjection{ FLT_MAX };
+			float maxProjection{ -FLT_MAX };
+			for (const Channels& texel : texels)
+			{
+				float projection{};
+				for (int channel{}; channel < nrChannels; ++channel)
+				{
+					projection += (texel[channel] - mean[channel]) * axis[channel];
+				}
+				minProjection = std::min(minProjection, projection / squaredLength);
+				maxProjection = std::max(maxProjection, projection / squaredLength);
+			}
+			for (int channel{}; channel < nrChannels; ++channel)
+			{
+				endpoint0[channel] = std::clamp(mean[channel] + axis[channel] * minProjection, 0.f, 255.f);
+				endpoint1[channel] = std::clamp(mean[channel] + axis[channel] * maxProjection, 0.f, 255.f);
+			}
+		}
+
+		// Least squares endpoints for the weights the indices picked, 0 is endpoint0 and 1 is endpoint1.
+		// False when every texel has the same weight, that gives no line
+		bool RefitLine(const BlockTexels& texels, const float weights[TexelsPerBlock], int nrChannels, Channels& endpoint0, Channels& endpoint1)
+		{
+			float sum00{};
+			float sum01{};
+			float sum11{};
+			Channels sum0{};
+			Channels sum1{};
+			for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+			{
+				const float weight1{ weights[texelIdx] };
+				const float weight0{ 1.f - weight1 };
+				sum00 += weight0 * weight0;
+				sum01 += weight0 * weight1;
+				sum11 += weight1 * weight1;
+				for (int channel{}; channel < nrChannels; ++channel)
+				{
+					sum0[channel] += weight0 * texels[texelIdx][channel];
+					sum1[channel] += weight1 * texels[texelIdx][channel];
+				}
+			}
+
+			const float determinant{ sum00 * sum11 - sum01 * sum01 };
+			if (determinant < 1e-3f)
+				return false;
+
+			for (int channel{}; channel < nrChannels; ++channel)
+			{
+				endpoint0[channel] = std::clamp((sum0[channel] * sum11 - sum1[channel] * sum01) / determinant, 0.f, 255.f);
+				endpoint1[channel] = std::clamp((sum1[channel] * sum00 - sum0[channel] * sum01) / determinant, 0.f, 255.f);
+			}
+			return true;
+		}
+
+		uint16_t QuantizeTo565(const Channels& color)
+		{
+			const uint32_t red{ uint32_t(color[0] * 31.f / 255.f + 0.5f) };
+			const uint32_t green{ uint32_t(color[1] * 63.f / 255.f + 0.5f) };
+			const uint32_t blue{ uint32_t(color[2] * 31.f / 255.f + 0.5f) };
+			return uint16_t(red << 11 | green << 5 | blue);
+		}
+
+		// Always 4 colors, color0 > color1, so the block reads the same in BC1 and BC3.
+		// Endpoints on the principal axis, then refit twice to the indices they gave
+		void EncodeColors(const BlockTexels& texels, uint8_t* pBlock)
+		{
+			// The weight of color1 for every index
+			constexpr float IndexWeights[4]{ 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+
+			Channels endpoint0;
+			Channels endpoint1;
+			FitLine(texels, 3, endpoint0, endpoint1);
+
+			float bestError{ FLT_MAX };
+			for (int iteration{}; iteration < 3; ++iteration)
+			{
+				uint16_t color0{ QuantizeTo565(endpoint1) };
+				uint16_t color1{ QuantizeTo565(endpoint0) };
+				if (color0 < color1)
+					std::swap(color0, color1);
+
+				uint32_t palette[4];
+				uint32_t indices[TexelsPerBlock]{};
+				// Equal colors would give the 3 color mode, index 0 covers the whole block then
+				const int nrEntries{ color0 == color1 ? 1 : GetColorPalette(color0, color1, false, palette) };
+				palette[0] = Expand565(color0);
+				const float error{ FindIndices(texels, palette, nrEntries, 3, indices) };
+				if (error < bestError)
+				{
+					bestError = error;
+					uint32_t packedIndices{};
+					for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+					{
+						packedIndices |= indices[texelIdx] << (2 * texelIdx);
+					}
+					pBlock[0] = uint8_t(color0);
+					pBlock[1] = uint8_t(color0 >> 8);
+					pBlock[2] = uint8_t(color1);
+					pBlock[3] = uint8_t(color1 >> 8);
+					std::memcpy(pBlock + 4, &packedIndices, sizeof(packedIndices));
+				}
+
+				float weights[TexelsPerBlock];
+				for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+				{
+					weights[texelIdx] = IndexWeights[indices[texelIdx]];
+				}
+				if (bestError == 0.f || !RefitLine(texels, weights, 3, endpoint0, endpoint1))
+					break;
+			}
+		}
+
+		// The 8 value mode between the lowest and highest value of the channel
+		void EncodeChannel(const BlockTexels& texels, int channel, uint8_t* pBlock)
+		{
+			float lowest{ 255.f };
+			float highest{ 0.f };
+			for (const Channels& texel : texels)
+			{
+				lowest = std::min(lowest, texel[channel]);
+				highest = std::max(highest, texel[channel]);
+			}
+
+			const uint8_t value0{ uint8_t(highest + 0.5f) };
+			const uint8_t value1{ uint8_t(lowest + 0.5f) };
+			uint8_t palette[8];
+			GetChannelPalette(value0, value1, palette);
+
+			uint64_t indices{};
+			for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+			{
+				float closest{ FLT_MAX };
+				uint64_t closestIdx{};
+				for (int entry{}; entry < 8; ++entry)
+				{
+					const float distance{ std::abs(texels[texelIdx][channel] - palette[entry]) };
+					if (distance < closest)
+					{
+						closest = distance;
+						closestIdx = entry;
+					}
+				}
+				indices |= closestIdx << (3 * texelIdx);
+			}
+			pBlock[0] = value0;
+			pBlock[1] = value1;
+			std::memcpy(pBlock + 2, &indices, 6);
+		}
+
+		// BC7 mode 6 only: one RGBA line with 7 bit endpoints plus a p-bit each and 4 bit indices.
+		// It fits the smooth textures we ship well, the partitioned modes would need a search over 64 partitions per block
+		void EncodeBc7(const BlockTexels& texels, uint8_t* pBlock)
+		{
+			Channels line0;
+			Channels line1;
+			FitLine(texels, 4, line0, line1);
+
+			float bestError{ FLT_MAX };
+			uint32_t bestEndpoints[2][4]{};
+			uint32_t bestIndices[TexelsPerBlock]{};
+			for (int iteration{}; iteration < 2; ++iteration)
+			{
+				// Every combination of the two p-bits, they move the whole endpoint by one step
+				for (uint32_t pBits{}; pBits < 4; ++pBits)
+				{
+					uint32_t endpoints[2][4];
+					for (int channel{}; channel < 4; ++channel)
+					{
+						const uint32_t pBit0{ pBits & 1 };
+						const uint32_t pBit1{ pBits >> 1 };
+						endpoints[0][channel] = std::min(uint32_t(std::max((line0[channel] - pBit0) * 0.5f + 0.5f, 0.f)), 127u) << 1 | pBit0;
+						endpoints[1][channel] = std::min(uint32_t(std::max((line1[channel] - pBit1) * 0.5f + 0.5f, 0.f)), 127u) << 1 | pBit1;
+					}
+
+					uint32_t palette[16];
+					for (int entry{}; entry < 16; ++entry)
+					{
+						palette[entry] = PackTexel(Bc7Interpolate(endpoints[0][0], endpoints[1][0], Bc7Weights4[entry]),
+							Bc7Interpolate(endpoints[0][1], endpoints[1][1], Bc7Weights4[entry]),
+							Bc7Interpolate(endpoints[0][2], endpoints[1][2], Bc7Weights4[entry]),
+							Bc7Interpolate(endpoints[0][3], endpoints[1][3], Bc7Weights4[entry]));
+					}
+
+					uint32_t indices[TexelsPerBlock];
+					const float error{ FindIndices(texels, palette, 16, 4, indices) };
+					if (error < bestError)
+					{
+						bestError = error;
+						std::memcpy(bestEndpoints, endpoints, sizeof(endpoints));
+						std::memcpy(bestIndices, indices, sizeof(indices));
+					}
+				}
+
+				float weights[TexelsPerBlock];
+				for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+				{
+					weights[texelIdx] = Bc7Weights4[bestIndices[texelIdx]] / 64.f;
+				}
+				if (bestError == 0.f || !RefitLine(texels, weights, 4, line0, line1))
+					break;
+			}
+
+			// Texel 0 is stored without its highest index bit, swapping the endpoints makes that bit 0
+			if (bestIndices[0] >= 8)
+			{
+				std::swap(bestEndpoints[0], bestEndpoints[1]);
+				for (uint32_t& index : bestIndices)
+				{
+					index = 15 - index;
+				}
+			}
+
+			BitWriter writer{};
+			writer.Write(1 << 6, 7);
+			for (int channel{}; channel < 4; ++channel)
+			{
+				writer.Write(bestEndpoints[0][channel] >> 1, 7);
+				writer.Write(bestEndpoints[1][channel] >> 1, 7);
+			}
+			writer.Write(bestEndpoints[0][0] & 1, 1);
+			writer.Write(bestEndpoints[1][0] & 1, 1);
+			for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+			{
+				writer.Write(bestIndices[texelIdx], texelIdx == 0 ? 3 : 4);
+			}
+			writer.Store(pBlock);
+		}
+
+		void EncodeBlock(BlockCompression::Format format, const BlockTexels& texels, uint8_t* pBlock)
+		{
+			switch (format)
+			{
+			case BlockCompression::Format::BC1:
+				EncodeColors(texels, pBlock);
+				break;
+			case BlockCompression::Format::BC3:
+				EncodeChannel(texels, 3, pBlock);
+				EncodeColors(texels, pBlock + 8);
+				break;
+			case BlockCompression::Format::BC5:
+				EncodeChannel(texels, 0, pBlock);
+				EncodeChannel(texels, 1, pBlock + 8);
+				break;
+			case BlockCompression::Format::BC7:
+				EncodeBc7(texels, pBlock);
+				break;
+			}
+		}
+	}
+
+	namespace BlockCompression
+	{
+		const char* GetName(Format format)
+		{
+			switch (format)
+			{
+			case Format::BC1: return "BC1";
+			case Format::BC3: return "BC3";
+			case Format::BC5: return "BC5";
+			case Format::BC7: return "BC7";
+			}
+			return "unknown";
+		}
+
+		bool GetFormat(const std::string& name, Format& format)
+		{
+			for (const Format candidate : { Format::BC1, Format::BC3, Format::BC5, Format::BC7 })
+			{
+				if (name == GetName(candidate))
+				{
+					format = candidate;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		DXGI_FORMAT GetDxgiFormat(Format format)
+		{
+			switch (format)
+			{
+			case Format::BC1: return DXGI_FORMAT_BC1_UNORM;
+			case Format::BC3: return DXGI_FORMAT_BC3_UNORM;
+			case Format::BC5: return DXGI_FORMAT_BC5_UNORM;
+			case Format::BC7: return DXGI_FORMAT_BC7_UNORM;
+			}
+			return DXGI_FORMAT_UNKNOWN;
+		}
+
+		size_t GetBlockSize(Format format)
+		{
+			return format == Format::BC1 ? 8 : 16;
+		}
+
+		size_t GetLevelSize(Format format, int width, int height)
+		{
+			const size_t nrBlocks{ size_t((width + BlockDimension - 1) / BlockDimension) * ((height + BlockDimension - 1) / BlockDimension) };
+			return nrBlocks * GetBlockSize(format);
+		}
+
+		void DecodeBlock(Format format, const uint8_t* pBlock, uint32_t texels[TexelsPerBlock])
+		{
+			switch (format)
+			{
+			case Format::BC1:
+				DecodeColors(pBlock, true, texels);
+				break;
+			case Format::BC3:
+				DecodeColors(pBlock + 8, false, texels);
+				for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+				{
+					texels[texelIdx] &= 0x00FFFFFF;
+				}
+				DecodeChannel(pBlock, texels, 3);
+				break;
+			case Format::BC5:
+				std::fill_n(texels, TexelsPerBlock, 0xFF000000u);
+				DecodeChannel(pBlock, texels, 0);
+				DecodeChannel(pBlock + 8, texels, 1);
+				break;
+			case Format::BC7:
+				DecodeBc7(pBlock, texels);
+				break;
+			}
+		}
+
+		std::vector<uint8_t> Encode(Format format, const uint32_t* pTexels, int width, int height)
+		{
+			const int nrBlocksX{ (width + BlockDimension - 1) / BlockDimension };
+			const int nrBlocksY{ (height + BlockDimension - 1) / BlockDimension };
+			const size_t blockSize{ GetBlockSize(format) };
+
+			std::vector<uint8_t> blocks(GetLevelSize(format, width, height));
+			uint8_t* pBlock{ blocks.data() };
+			for (int blockY{}; blockY < nrBlocksY; ++blockY)
+			{
+				for (int blockX{}; blockX < nrBlocksX; ++blockX)
+				{
+					BlockTexels texels;
+					for (int texelIdx{}; texelIdx < TexelsPerBlock; ++texelIdx)
+					{
+						const int x{ std::min(blockX * BlockDimension + texelIdx % BlockDimension, width - 1) };
+						const int y{ std::min(blockY * BlockDimension + texelIdx / BlockDimension, height - 1) };
+						const uint32_t texel{ pTexels[size_t(y) * width + x] };
+						for (int channel{}; channel < 4; ++channel)
+						{
+							texels[texelIdx][channel] = GetChannel(texel, channel);
+						}
+					}
+					EncodeBlock(format, texels, pBlock);
+					pBlock += blockSize;
+				}
+			}
+			return blocks;
+		}
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+namespace dae
+{
+	// The BCn formats of D3D11, 4x4 texels per block. Texels are RGBA8 with red in the lowest byte,
+	// the same as Texture, and a block always holds its texels row after row
+	namespace BlockCompression
+	{
+		enum class Format : uint32_t
+		{
+			// RGB 565 endpoints and 2 bit indices, 4 bits per texel, no alpha
+			BC1,
+			// BC1 colors plus an interpolated alpha, 8 bits per texel
+			BC3,
+			// Two interpolated channels, red and green, 8 bits per texel, blue reads 0. For normal maps, z is rebuilt from x and y
+			BC5,
+			// RGBA with 8 modes of up to 3 line segments per block, 8 bits per texel
+			BC7
+		};
+
+		constexpr int BlockDimension{ 4 };
+		constexpr int TexelsPerBlock{ BlockDimension * BlockDimension };
+
+		const char* GetName(Format format);
+		// Parses GetName, case sensitive
+		bool GetFormat(const std::string& name, Format& format);
+		DXGI_FORMAT GetDxgiFormat(Format format);
+		// 8 or 16 bytes
+		size_t GetBlockSize(Format format);
+		// Bytes of a mip level, partial blocks at the right and bottom edge count as whole ones
+		size_t GetLevelSize(Format format, int width, int height);
+
+		void DecodeBlock(Format format, const uint8_t* pBlock, uint32_t texels[TexelsPerBlock]);
+		// Every block of a width x height image of rows of texels, edge blocks repeat the last row and column
+		std::vector<uint8_t> Encode(Format format, const uint32_t* pTexels, int width, int height);
+	}
+}
@@ -81,9 +81,20 @@ namespace dae
 		constexpr float mouseMovementSpeed = movementSpeed / 300;
 		constexpr float mouseSens = 0.006f;
 
-		DoKeyboardInput(deltaTime, movementSpeed);
+		if (isFlyingThrough)
+		{
+			// A fixed step every frame instead of the frame time, so every fly-through renders the exact same frames
+			constexpr float flyThroughLength{ 80.f };
+			constexpr float flyThroughStep{ 0.5f };
+			flyThroughDistance = fmodf(flyThroughDistance + flyThroughStep, flyThroughLength);
+			origin = Vector3{ 0.f, 1.f, flyThroughDistance };
+		}
+		else
+		{
+			DoKeyboardInput(deltaTime, movementSpeed);
 
-		DoMouseInput(mouseMovementSpeed, mouseSens);
+			DoMouseInput(mouseMovementSpeed, mouseSens);
+		}
 
 		const Matrix finalRotation{ Matrix::CreateRotation(totalPitch, totalYaw, 0) };
 
@@ -98,6 +109,14 @@ namespace dae
 		CalculateProjectionMatrix(); //Try to optimize this - should only be called once or when fov/aspectRatio changes
 	}
 
+	void Camera::ToggleFlyThrough()
+	{
+		isFlyingThrough = !isFlyingThrough;
+		flyThroughDistance = 0.f;
+		totalPitch = 0.f;
+		totalYaw = 0.f;
+	}
+
 	void dae::Camera::DoKeyboardInput(float deltaTime, float moveSpeed)
 	{
 		//Keyboard Input
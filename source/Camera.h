@@ -23,6 +23,10 @@ namespace dae
 		Matrix* GetInvViewMatrix();
 
 		void Update(const Timer* pTimer);
+		void ToggleFlyThrough();
+		bool IsFlyingThrough() const { return isFlyingThrough; }
+		// Moves the camera without turning it, the matrices follow on the next update
+		void SetOrigin(const Vector3& _origin) { origin = _origin; }
 
 	private:
 		float nearClip{ 0.1f };
@@ -40,6 +44,10 @@ namespace dae
 		float totalPitch{};
 		float totalYaw{};
 
+		// Flies straight through the vehicle and back to the start, to check the near plane clipping
+		bool isFlyingThrough{ false };
+		float flyThroughDistance{};
+
 		Matrix invViewMatrix{};
 		Matrix viewMatrix{};
 		Matrix projectionMatrix{};
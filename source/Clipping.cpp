@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "Clipping.h"
+
+namespace dae
+{
+	namespace
+	{
+		// Positive inside of the plane, the distances are linear in clip space
+		float GetPlaneDistance(const Vector4& position, int planeIdx, float guardBand)
+		{
+			switch (planeIdx)
+			{
+			case 0: return position.z;
+			case 1: return position.w - position.z;
+			case 2: return position.x + guardBand * position.w;
+			case 3: return guardBand * position.w - position.x;
+			case 4: return position.y + guardBand * position.w;
+			case 5: return guardBand * position.w - position.y;
+			}
+			return 0.f;
+		}
+
+		Vertex_Out LerpVertex(const Vertex_Out& from, const Vertex_Out& to, float factor)
+		{
+			Vertex_Out vertex{};
+			vertex.position = from.position + (to.position - from.position) * factor;
+			vertex.uv = from.uv + (to.uv - from.uv) * factor;
+			vertex.normal = from.normal + (to.normal - from.normal) * factor;
+			vertex.tangent = from.tangent + (to.tangent - from.tangent) * factor;
+			vertex.viewDirection = from.viewDirection + (to.viewDirection - from.viewDirection) * factor;
+			return vertex;
+		}
+	}
+
+	uint32_t Clipping::GetOutCode(const Vector4& position, float guardBand)
+	{
+		uint32_t outCode{};
+		for (int planeIdx{}; planeIdx < NrPlanes; ++planeIdx)
+		{
+			if (GetPlaneDistance(position, planeIdx, guardBand) < 0.f)
+				outCode |= 1u << planeIdx;
+		}
+		return outCode;
+	}
+
+	Clipping::Frustum Clipping::GetFrustum(const Matrix& toClipSpace)
+	{
+		// The plane distances are linear in clip space, so every row of the matrix gives one coefficient of the plane
+		Frustum frustum{};
+		for (int planeIdx{}; planeIdx < NrPlanes; ++planeIdx)
+		{
+			frustum.planes[planeIdx] = Vector4{
+				GetPlaneDistance(toClipSpace[0], planeIdx, 1.f),
+				GetPlaneDistance(toClipSpace[1], planeIdx, 1.f),
+				GetPlaneDistance(toClipSpace[2], planeIdx, 1.f),
+				GetPlaneDistance(toClipSpace[3], planeIdx, 1.f) };
+		}
+		return frustum;
+	}
+
+	bool Clipping::IsVisible(const Frustum& frustum, const MeshBounds& bounds)
+	{
+		for (const Vector4& plane : frustum.planes)
+		{
+			// The sphere decides when it is completely on one side, the planes are not normalized
+			const Vector3 normal{ plane.x, plane.y, plane.z };
+			const float radius{ bounds.radius * normal.Magnitude() };
+			const float centerDistance{ Vector3::Dot(normal, bounds.center) + plane.w };
+			if (centerDistance < -radius)
+				return false;
+			if (centerDistance >= radius)
+				continue;
+
+			// The corner of the box farthest along the normal
+			const Vector3 corner{
+				normal.x >= 0.f ? bounds.max.x : bounds.min.x,
+				normal.y >= 0.f ? bounds.max.y : bounds.min.y,
+				normal.z >= 0.f ? bounds.max.z : bounds.min.z };
+			if (Vector3::Dot(normal, corner) + plane.w < 0.f)
+				return false;
+		}
+		return true;
+	}
+
+	int Clipping::ClipPolygon(Vertex_Out(&vertices)[MaxClippedVertices], int nrVertices, uint32_t planes, float guardBand)
+	{
+		Vertex_Out clipped[MaxClippedVertices]{};
+
+		for (int planeIdx{}; planeIdx < NrPlanes && nrVertices >= 3; ++planeIdx)
+		{
+			if ((planes & (1u << planeIdx)) == 0)
+				continue;
+
+			int nrClipped{};
+			for (int i{}; i < nrVertices; ++i)
+			{
+				const Vertex_Out& current{ vertices[i] };
+				const Vertex_Out& next{ vertices[(i + 1) % nrVertices] };
+				const float currentDistance{ GetPlaneDistance(current.position, planeIdx, guardBand) };
+				const float nextDistance{ GetPlaneDistance(next.position, planeIdx, guardBand) };
+
+				if (currentDistance >= 0.f)
+					clipped[nrClipped++] = current;
+
+				// Always interpolate from the inside to the outside vertex,
+				// so the triangles sharing this edge get the exact same new vertex
+				if ((currentDistance >= 0.f) != (nextDistance >= 0.f))
+				{
+					if (currentDistance >= 0.f)
+						clipped[nrClipped++] = LerpVertex(current, next, currentDistance / (currentDistance - nextDistance));
+					else
+						clipped[nrClipped++] = LerpVertex(next, current, nextDistance / (nextDistance - currentDistance));
+				}
+			}
+
+			std::copy_n(clipped, nrClipped, vertices);
+			nrVertices = nrClipped;
+		}
+
+		return nrVertices >= 3 ? nrVertices : 0;
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "DataTypes.h"
+
+namespace dae
+{
+	// Homogeneous clipping in clip space, before the perspective divide
+	// The side planes are pushed out to the guard band, the rasterizer scissors everything between the guard band and the screen
+	namespace Clipping
+	{
+		constexpr uint32_t NearPlane{ 1 << 0 };
+		constexpr uint32_t FarPlane{ 1 << 1 };
+		constexpr uint32_t LeftPlane{ 1 << 2 };
+		constexpr uint32_t RightPlane{ 1 << 3 };
+		constexpr uint32_t BottomPlane{ 1 << 4 };
+		constexpr uint32_t TopPlane{ 1 << 5 };
+		constexpr int NrPlanes{ 6 };
+
+		// Every plane adds one vertex at most
+		constexpr int MaxClippedVertices{ 3 + NrPlanes };
+
+		// A bit for every plane the position is outside of
+		uint32_t GetOutCode(const Vector4& position, float guardBand);
+
+		// Clips the convex polygon against the given planes in place, returns the amount of vertices left
+		int ClipPolygon(Vertex_Out(&vertices)[MaxClippedVertices], int nrVertices, uint32_t planes, float guardBand);
+
+		// The clip planes without guard band, in the space the matrix transforms to clip space from
+		// A point is inside a plane when Dot(plane, Vector4{ point, 1 }) >= 0, the planes are in the order of the plane bits
+		struct Frustum final
+		{
+			Vector4 planes[NrPlanes]{};
+		};
+		Frustum GetFrustum(const Matrix& toClipSpace);
+
+		// Conservative, only false when the bounding sphere or box is completely outside of one of the planes
+		bool IsVisible(const Frustum& frustum, const MeshBounds& bounds);
+	}
+}
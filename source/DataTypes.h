@@ -8,7 +8,8 @@ namespace dae
 		Vector3 position{};
 		Vector2 uv{};
 		Vector3 normal{};
-		Vector3 tangent{};
+		// w is the handedness, the bitangent is Cross(normal, tangent.xyz) * w
+		Vector4 tangent{};
 		Vector3 viewDirection{};
 	};
 
@@ -17,7 +18,89 @@ namespace dae
 		Vector4 position{};
 		Vector2 uv{};
 		Vector3 normal{};
-		Vector3 tangent{};
+		Vector4 tangent{};
 		Vector3 viewDirection{};
 	};
+
+	struct MeshBounds
+	{
+		// Object space box around the vertices and the sphere around its center
+		Vector3 min{};
+		Vector3 max{};
+		Vector3 center{};
+		float radius{};
+	};
+
+	struct Meshlet
+	{
+		// A run of triangles in the index buffer of the mesh, see MeshOptimizer::BuildMeshlets
+		uint32_t firstIndex{};
+		uint32_t nrIndices{};
+		MeshBounds bounds{};
+		// The face normals are within the cone around the axis, coneCutoff is the sine of its half angle, 1 when it is 90 degrees or wider
+		Vector3 coneAxis{};
+		float coneCutoff{};
+	};
+
+	struct MeshLod
+	{
+		// A run of the index buffer and one of the meshlets, LOD 0 is the full mesh
+		uint32_t firstIndex{};
+		uint32_t nrIndices{};
+		uint32_t firstMeshlet{};
+		uint32_t nrMeshlets{};
+		// The level only uses the first nrVertices vertices of the mesh
+		uint32_t nrVertices{};
+		// How far the positions of this level moved off the triangles of the full mesh at most, in object space, see MeshOptimizer::Simplify
+		float error{};
+	};
+
+	struct VertexSetup //SOFTWARE
+	{
+		// Depth and 1/w are interpolated linearly in screen space, the others with perspective correct weights
+		float depth{};
+		float invW{};
+		Vector2 uv{};
+		Vector3 normal{};
+		Vector4 tangent{};
+		Vector3 viewDirection{};
+	};
+
+	struct TriangleSetup //SOFTWARE
+	{
+		// Edge functions, one component per vertex weight (the edge opposite to that vertex)
+		// weights(x, y) = edgeStart + (x - left) * edgeStepX + (y - bottom) * edgeStepY
+		Vector3 edgeStart{};
+		Vector3 edgeStepX{};
+		Vector3 edgeStepY{};
+		float invArea{};
+
+		// Fixed point edge functions, only set up for the fixed point kernels
+		// Snapped to 1/256th of a pixel and biased by the top-left rule, a pixel is covered when all three are >= 0
+		int64_t fixedEdgeStart[3]{};
+		int64_t fixedEdgeStepX[3]{};
+		int64_t fixedEdgeStepY[3]{};
+
+		// Depth range of the vertices, the interpolated depth is clamped to it
+		float minDepth{};
+		float maxDepth{};
+
+		VertexSetup vertices[3]{};
+
+		// Bounding box in pixels, [left, right[ x [bottom, top[
+		int left{};
+		int right{};
+		int bottom{};
+		int top{};
+	};
+
+	struct VisibilitySample //SOFTWARE
+	{
+		// Triangle that is visible in the pixel and its perspective correct barycentrics
+		uint32_t triangleIdx{};
+		float interpolatedW{};
+		float weightV0{};
+		float weightV1{};
+		float weightV2{};
+	};
 }
\ No newline at end of file
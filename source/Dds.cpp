@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "Dds.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace dae
+{
+	namespace
+	{
+		constexpr uint32_t MakeFourCC(char c0, char c1, char c2, char c3)
+		{
+			return uint32_t(uint8_t(c0)) | uint32_t(uint8_t(c1)) << 8 | uint32_t(uint8_t(c2)) << 16 | uint32_t(uint8_t(c3)) << 24;
+		}
+
+		constexpr uint32_t DdsMagic{ MakeFourCC('D', 'D', 'S', ' ') };
+		// In the first reserved word of the header when the next two hold the source hash, other tools use the last ones
+		constexpr uint32_t SourceHashTag{ MakeFourCC('S', 'R', 'C', 'H') };
+
+		// The flags and caps every texture we write has, readers only look at the fourCC and the sizes
+		enum HeaderFlags : uint32_t
+		{
+			Caps = 0x1,
+			Height = 0x2,
+			Width = 0x4,
+			PixelFormat = 0x1000,
+			MipMapCount = 0x20000,
+			LinearSize = 0x80000
+		};
+		constexpr uint32_t PixelFormatFourCC{ 0x4 };
+		constexpr uint32_t CapsComplex{ 0x8 };
+		constexpr uint32_t CapsTexture{ 0x1000 };
+		constexpr uint32_t CapsMipMap{ 0x400000 };
+		constexpr uint32_t ResourceDimensionTexture2D{ 3 };
+
+		struct DdsPixelFormat final
+		{
+			uint32_t size{ sizeof(DdsPixelFormat) };
+			uint32_t flags{};
+			uint32_t fourCC{};
+			uint32_t rgbBitCount{};
+			uint32_t bitMasks[4]{};
+		};
+
+		struct DdsHeader final
+		{
+			uint32_t size{ sizeof(DdsHeader) };
+			uint32_t flags{};
+			uint32_t height{};
+			uint32_t width{};
+			uint32_t pitchOrLinearSize{};
+			uint32_t depth{};
+			uint32_t mipMapCount{};
+			uint32_t reserved[11]{};
+			DdsPixelFormat pixelFormat{};
+			uint32_t caps[4]{};
+			uint32_t reserved2{};
+		};
+
+		// Follows the header when the fourCC is DX10
+		struct DdsHeaderDx10 final
+		{
+			uint32_t dxgiFormat{};
+			uint32_t resourceDimension{};
+			uint32_t miscFlag{};
+			uint32_t arraySize{};
+			uint32_t miscFlags2{};
+		};
+		static_assert(sizeof(DdsHeader) == 124 && sizeof(DdsHeaderDx10) == 20, "the headers are read and written as is");
+
+		uint64_t GetSourceHash(const DdsHeader& header)
+		{
+			return header.reserved[0] == SourceHashTag ? header.reserved[1] | uint64_t(header.reserved[2]) << 32 : 0;
+		}
+
+		bool GetFormat(uint32_t fourCC, uint32_t dxgiFormat, BlockCompression::Format& format)
+		{
+			switch (fourCC)
+			{
+			case MakeFourCC('D', 'X', 'T', '1'): format = BlockCompression::Format::BC1; return true;
+			case MakeFourCC('D', 'X', 'T', '5'): format = BlockCompression::Format::BC3; return true;
+			case MakeFourCC('A', 'T', 'I', '2'):
+			case MakeFourCC('B', 'C', '5', 'U'): format = BlockCompression::Format::BC5; return true;
+			case MakeFourCC('D', 'X', '1', '0'): break;
+			default: return false;
+			}
+
+			// Typeless and sRGB files are read as unorm, like the images: the shaders light the stored values as they are
+			switch (DXGI_FORMAT(dxgiFormat))
+			{
+			case DXGI_FORMAT_BC1_TYPELESS:
+			case DXGI_FORMAT_BC1_UNORM:
+			case DXGI_FORMAT_BC1_UNORM_SRGB: format = BlockCompression::Format::BC1; return true;
+			case DXGI_FORMAT_BC3_TYPELESS:
+			case DXGI_FORMAT_BC3_UNORM:
+			case DXGI_FORMAT_BC3_UNORM_SRGB: format = BlockCompression::Format::BC3; return true;
+			case DXGI_FORMAT_BC5_TYPELESS:
+			case DXGI_FORMAT_BC5_UNORM: format = BlockCompression::Format::BC5; return true;
+			case DXGI_FORMAT_BC7_TYPELESS:
+			case DXGI_FORMAT_BC7_UNORM:
+			case DXGI_FORMAT_BC7_UNORM_SRGB: format = BlockCompression::Format::BC7; return true;
+			default: return false;
+			}
+		}
+	}
+
+	namespace Dds
+	{
+		bool Read(const std::string& filename, Image& image)
+		{
+			const MappedFile file{ filename };
+			const std::string_view data{ file.GetData() };
+			if (!file.IsOpen() || data.size() < sizeof(DdsMagic) + sizeof(DdsHeader))
+				return false;
+
+			uint32_t magic{};
+			DdsHeader header{};
+			std::memcpy(&magic, data.data(), sizeof(magic));
+			std::memcpy(&header, data.data() + sizeof(magic), sizeof(DdsHeader));
+			constexpr uint32_t blockDimension{ BlockCompression::BlockDimension };
+			if (magic != DdsMagic || header.size != sizeof(DdsHeader) || header.width == 0 || header.height == 0
+				|| header.width % blockDimension != 0 || header.height % blockDimension != 0)
+				return false;
+
+			size_t offset{ sizeof(magic) + sizeof(DdsHeader) };
+			DdsHeaderDx10 headerDx10{};
+			if (header.pixelFormat.fourCC == MakeFourCC('D', 'X', '1', '0'))
+			{
+				if (data.size() < offset + sizeof(DdsHeaderDx10))
+					return false;
+
+				std::memcpy(&headerDx10, data.data() + offset, sizeof(DdsHeaderDx10));
+				offset += sizeof(DdsHeaderDx10);
+				if (headerDx10.resourceDimension != ResourceDimensionTexture2D || headerDx10.arraySize > 1)
+					return false;
+			}
+			if (!GetFormat(header.pixelFormat.fourCC, headerDx10.dxgiFormat, image.format))
+				return false;
+
+			image.width = int(header.width);
+			image.height = int(header.height);
+			image.sourceHash = GetSourceHash(header);
+			image.levels.clear();
+			const uint32_t nrLevels{ std::max(header.mipMapCount, 1u) };
+			for (uint32_t levelIdx{}; levelIdx < nrLevels && levelIdx < 32; ++levelIdx)
+			{
+				const size_t levelSize{ BlockCompression::GetLevelSize(image.format, std::max(image.width >> levelIdx, 1), std::max(image.height >> levelIdx, 1)) };
+				if (data.size() < offset + levelSize)
+					return false;
+
+				image.levels.emplace_back(data.data() + offset, data.data() + offset + levelSize);
+				offset += levelSize;
+			}
+			return true;
+		}
+
+		bool ReadSourceHash(const std::string& filename, uint64_t& sourceHash)
+		{
+			const MappedFile file{ filename };
+			const std::string_view data{ file.GetData() };
+			if (!file.IsOpen() || data.size() < sizeof(DdsMagic) + sizeof(DdsHeader))
+				return false;
+
+			uint32_t magic{};
+			DdsHeader header{};
+			std::memcpy(&magic, data.data(), sizeof(magic));
+			std::memcpy(&header, data.data() + sizeof(magic), sizeof(DdsHeader));
+			if (magic != DdsMagic || header.size != sizeof(DdsHeader))
+				return false;
+
+			sourceHash = GetSourceHash(header);
+			return true;
+		}
+
+		bool Write(const std::string& filename, const Image& image)
+		{
+			std::ofstream file{ filename, std::ios::binary | std::ios::trunc };
+			if (!file || image.levels.empty())
+				return false;
+
+			DdsHeader header{};
+			header.flags = Caps | Height | Width | PixelFormat | MipMapCount | LinearSize;
+			header.height = uint32_t(image.height);
+			header.width = uint32_t(image.width);
+			header.pitchOrLinearSize = uint32_t(image.levels.front().size());
+			header.mipMapCount = uint32_t(image.levels.size());
+			header.reserved[0] = SourceHashTag;
+			header.reserved[1] = uint32_t(image.sourceHash);
+			header.reserved[2] = uint32_t(image.sourceHash >> 32);
+			header.pixelFormat.flags = PixelFormatFourCC;
+			header.pixelFormat.fourCC = MakeFourCC('D', 'X', '1', '0');
+			header.caps[0] = CapsTexture | (image.levels.size() > 1 ? CapsComplex | CapsMipMap : 0);
+
+			DdsHeaderDx10 headerDx10{};
+			headerDx10.dxgiFormat = uint32_t(BlockCompression::GetDxgiFormat(image.format));
+			headerDx10.resourceDimension = ResourceDimensionTexture2D;
+			headerDx10.arraySize = 1;
+
+			file.write(reinterpret_cast<const char*>(&DdsMagic), sizeof(DdsMagic));
+			file.write(reinterpret_cast<const char*>(&header), sizeof(DdsHeader));
+			file.write(reinterpret_cast<const char*>(&headerDx10), sizeof(DdsHeaderDx10));
+			for (const std::vector<uint8_t>& level : image.levels)
+			{
+				file.write(reinterpret_cast<const char*>(level.data()), std::streamsize(level.size()));
+			}
+			return bool(file);
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "BlockCompression.h"
+
+namespace dae
+{
+	// DirectDraw Surface files holding the block compressed mip levels of a 2D texture, as texture tools write them
+	namespace Dds
+	{
+		struct Image final
+		{
+			BlockCompression::Format format{};
+			int width{};
+			int height{};
+			// Full resolution first, every level is its blocks row after row, the way D3D11 takes them
+			std::vector<std::vector<uint8_t>> levels{};
+			// MappedFile::GetHash of the image it was compressed from, 0 for files other tools wrote
+			uint64_t sourceHash{};
+		};
+
+		// Reads the DX10 header and the older DXT1, DXT5, ATI2 and BC5U codes, false for anything else, a short file
+		// or a full resolution level that is not a whole number of blocks wide and high, which D3D11 can not create
+		bool Read(const std::string& filename, Image& image);
+		// Only the source hash from the header, without reading the levels. False when it is not a DDS file
+		bool ReadSourceHash(const std::string& filename, uint64_t& sourceHash);
+		// Always writes the DX10 header, the source hash goes in the reserved words of the header
+		bool Write(const std::string& filename, const Image& image);
+	}
+}
@@ -13,10 +13,22 @@ namespace dae
 		if (!m_pTechnique->IsValid())
 			std::cout << "Technique not valid\n";
 
+		m_pQuantizedTechnique = m_pEffect->GetTechniqueByName("QuantizedTechnique");
+		if (!m_pQuantizedTechnique->IsValid())
+			std::cout << "Quantized technique not valid\n";
+
 		m_pWorldViewProjMatrixVariable = m_pEffect->GetVariableByName("gWorldViewProj")->AsMatrix();
 		if (!m_pWorldViewProjMatrixVariable->IsValid())
 			std::cout << "m_pMatWorldViewProjVariable not valid!\n";
 
+		m_pPositionOffsetVariable = m_pEffect->GetVariableByName("gPositionOffset")->AsVector();
+		if (!m_pPositionOffsetVariable->IsValid())
+			std::cout << "m_pPositionOffsetVariable not valid!\n";
+
+		m_pPositionExtentVariable = m_pEffect->GetVariableByName("gPositionExtent")->AsVector();
+		if (!m_pPositionExtentVariable->IsValid())
+			std::cout << "m_pPositionExtentVariable not valid!\n";
+
 		m_pSamplerStateVariable = m_pEffect->GetVariableByName("gSamState")->AsSampler();
 		if (!m_pSamplerStateVariable->IsValid())
 			std::cout << "m_pSamplerStateVariable not valid\n";
@@ -46,6 +58,19 @@ namespace dae
 		return m_pTechnique;
 	}
 
+	ID3DX11EffectTechnique* Effect::GetQuantizedTechnique() const
+	{
+		return m_pQuantizedTechnique;
+	}
+
+	void Effect::SetPositionDequantization(const Vector3& offset, const Vector3& extent)
+	{
+		const float offsetVector[4]{ offset.x, offset.y, offset.z, 0.f };
+		const float extentVector[4]{ extent.x, extent.y, extent.z, 0.f };
+		m_pPositionOffsetVariable->SetFloatVector(offsetVector);
+		m_pPositionExtentVariable->SetFloatVector(extentVector);
+	}
+
 	ID3D11InputLayout* Effect::LoadInputLayout(ID3D11Device* pDevice)
 	{
 		//Create Vertex Layout
@@ -68,20 +93,55 @@ namespace dae
 		vertexDesc[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
 		vertexDesc[3].SemanticName = "TANGENT";
-		vertexDesc[3].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+		vertexDesc[3].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
 		vertexDesc[3].AlignedByteOffset = 32;
 		vertexDesc[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
 
 
+		return CreateInputLayout(pDevice, m_pTechnique, vertexDesc, numElements);
+	}
+
+	ID3D11InputLayout* Effect::LoadQuantizedInputLayout(ID3D11Device* pDevice)
+	{
+		//Create Vertex Layout, 20 bytes per vertex
+		static constexpr uint32_t numElements{ 4 };
+		D3D11_INPUT_ELEMENT_DESC vertexDesc[numElements]{};
+
+		vertexDesc[0].SemanticName = "POSITION";
+		vertexDesc[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+		vertexDesc[0].AlignedByteOffset = 0;
+		vertexDesc[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+
+		vertexDesc[1].SemanticName = "NORMAL";
+		vertexDesc[1].Format = DXGI_FORMAT_R16G16_SNORM;
+		vertexDesc[1].AlignedByteOffset = 8;
+		vertexDesc[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+
+		vertexDesc[2].SemanticName = "TANGENT";
+		vertexDesc[2].Format = DXGI_FORMAT_R16G16_SNORM;
+		vertexDesc[2].AlignedByteOffset = 12;
+		vertexDesc[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+
+		vertexDesc[3].SemanticName = "TEXCOORD";
+		vertexDesc[3].Format = DXGI_FORMAT_R16G16_FLOAT;
+		vertexDesc[3].AlignedByteOffset = 16;
+		vertexDesc[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+
+		return CreateInputLayout(pDevice, m_pQuantizedTechnique, vertexDesc, numElements);
+	}
+
+	ID3D11InputLayout* Effect::CreateInputLayout(ID3D11Device* pDevice, ID3DX11EffectTechnique* pTechnique,
+		const D3D11_INPUT_ELEMENT_DESC* pVertexDesc, uint32_t numElements) const
+	{
 		//Create Input Layout
 		D3DX11_PASS_DESC passDesc{};
-		m_pTechnique->GetPassByIndex(0)->GetDesc(&passDesc);
+		pTechnique->GetPassByIndex(0)->GetDesc(&passDesc);
 
 		ID3D11InputLayout* pInputLayout;
 
 		HRESULT result = pDevice->CreateInputLayout(
-			vertexDesc,
+			pVertexDesc,
 			numElements,
 			passDesc.pIAInputSignature,
 			passDesc.IAInputSignatureSize,
@@ -19,6 +19,11 @@ namespace dae
 		ID3DX11EffectTechnique* GetTechnique() const;
 		ID3D11InputLayout* LoadInputLayout(ID3D11Device* pDevice);
 
+		// Takes VertexD11Quantized, the vertex shader decodes it
+		ID3DX11EffectTechnique* GetQuantizedTechnique() const;
+		ID3D11InputLayout* LoadQuantizedInputLayout(ID3D11Device* pDevice);
+		void SetPositionDequantization(const Vector3& offset, const Vector3& extent);
+
 		void SetWorldViewProjMatrix(const float* matrix);
 
 		// pure virtuals
@@ -34,14 +39,19 @@ namespace dae
 		void SetSampleState(ID3D11SamplerState* pSampleState);
 	protected:
 		ID3DX11Effect* LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile) const;
+		ID3D11InputLayout* CreateInputLayout(ID3D11Device* pDevice, ID3DX11EffectTechnique* pTechnique,
+			const D3D11_INPUT_ELEMENT_DESC* pVertexDesc, uint32_t numElements) const;
 
 		
 		ID3DX11Effect* m_pEffect{ nullptr };
 
 		//Create Input Layout part
 		ID3DX11EffectTechnique* m_pTechnique{ nullptr };
+		ID3DX11EffectTechnique* m_pQuantizedTechnique{ nullptr };
 
 		ID3DX11EffectMatrixVariable* m_pWorldViewProjMatrixVariable{ nullptr };
+		ID3DX11EffectVectorVariable* m_pPositionOffsetVariable{ nullptr };
+		ID3DX11EffectVectorVariable* m_pPositionExtentVariable{ nullptr };
 		ID3DX11EffectRasterizerVariable* m_pRasterizerVariable{ nullptr };
 
 		ID3DX11EffectSamplerVariable* m_pSamplerStateVariable{ nullptr };
@@ -23,6 +23,10 @@ EffectShaded::EffectShaded(ID3D11Device* pDevice, const std::wstring& assetFile)
 	if (!m_pGlossinessMapVariable->IsValid())
 		std::wcout << L"m_pGlossinessMapVariable not valid!\n";
 
+	m_pNormalMapHasTwoChannelsVariable = m_pEffect->GetVariableByName("gNormalMapHasTwoChannels")->AsScalar();
+	if (!m_pNormalMapHasTwoChannelsVariable->IsValid())
+		std::wcout << L"m_pNormalMapHasTwoChannelsVariable not valid!\n";
+
 	m_pWorldMatrixVariable = m_pEffect->GetVariableByName("gWorldMatrix")->AsMatrix();
 	if (!m_pWorldMatrixVariable->IsValid())
 		std::wcout << L"m_pWorldMatrixVariable not valid\n";
@@ -51,6 +55,8 @@ void EffectShaded::SetNormalMap(const Texture* texture)
 {
 	if (m_pNormalMapVariable)
 		m_pNormalMapVariable->SetResource(texture->GetSRV());
+	if (m_pNormalMapHasTwoChannelsVariable)
+		m_pNormalMapHasTwoChannelsVariable->SetBool(texture->HasTwoChannels());
 }
 
 void EffectShaded::SetSpecularMap(const Texture* texture)
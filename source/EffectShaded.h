@@ -30,6 +30,7 @@ namespace dae
 		ID3DX11EffectShaderResourceVariable* m_pNormalMapVariable{ nullptr };
 		ID3DX11EffectShaderResourceVariable* m_pSpecularMapVariable{ nullptr };
 		ID3DX11EffectShaderResourceVariable* m_pGlossinessMapVariable{ nullptr };
+		ID3DX11EffectScalarVariable* m_pNormalMapHasTwoChannelsVariable{ nullptr };
 
 		ID3DX11EffectMatrixVariable* m_pWorldMatrixVariable{};
 		ID3DX11EffectMatrixVariable* m_pInverseViewMatrixVariable{};
@@ -0,0 +1,18 @@
+#include "pch.h"
+#include "Framebuffer.h"
+
+namespace dae
+{
+	Framebuffer::Framebuffer(int width, int height, FramebufferLayout layout) :
+		m_Width{ width },
+		m_Height{ height },
+		m_NrBlocksX{ (width + TiledLayout::BlockMask) >> TiledLayout::BlockShift },
+		m_Layout{ layout }
+	{
+		const int nrBlocksY{ (height + TiledLayout::BlockMask) >> TiledLayout::BlockShift };
+		const size_t nrPixels{ size_t(m_NrBlocksX) * nrBlocksY * TiledLayout::BlockSize * TiledLayout::BlockSize };
+
+		m_ColorPixels.resize(nrPixels);
+		m_DepthPixels.resize(nrPixels, FLT_MAX);
+	}
+}
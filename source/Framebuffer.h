@@ -0,0 +1,100 @@
+#pragma once
+
+namespace dae
+{
+	// Maps a pixel to its index in the color and depth buffers
+	// The rasterizer is templated on these, so the index calculation inlines into the pixel loops
+
+	// Row-major, like the SDL surface
+	struct LinearLayout final
+	{
+		static constexpr const char* Name{ "linear" };
+
+		int width{};
+
+		size_t GetIndex(int px, int py) const { return px + size_t(py) * width; }
+	};
+
+	// 8x8 pixel blocks stored one after the other, row-major inside a block and across blocks
+	// A block covers exactly one hierarchical depth cell and a 2x2 quad never leaves its block
+	struct TiledLayout final
+	{
+		static constexpr const char* Name{ "tiled" };
+		static constexpr int BlockShift{ 3 };
+		static constexpr int BlockSize{ 1 << BlockShift };
+		static constexpr int BlockMask{ BlockSize - 1 };
+
+		int nrBlocksX{};
+
+		size_t GetIndex(int px, int py) const
+		{
+			const size_t blockIdx{ size_t(px >> BlockShift) + size_t(py >> BlockShift) * nrBlocksX };
+			return (blockIdx << (2 * BlockShift)) | ((py & BlockMask) << BlockShift) | (px & BlockMask);
+		}
+	};
+
+	enum class FramebufferLayout
+	{
+		Linear = 0,
+		Tiled = 1
+	};
+
+	// Color and depth of the software rasterizer, always stored in the same layout
+	// Colors are in the format of the SDL surface they get resolved to
+	class Framebuffer final
+	{
+	public:
+		Framebuffer(int width, int height, FramebufferLayout layout);
+		~Framebuffer() = default;
+
+		// rule of 5 copypasta
+		Framebuffer(const Framebuffer& other) = delete;
+		Framebuffer(Framebuffer&& other) = delete;
+		Framebuffer& operator=(const Framebuffer& other) = delete;
+		Framebuffer& operator=(Framebuffer&& other) = delete;
+
+		// The contents are undefined after switching, the rasterizer clears every pixel each frame anyway
+		void SetLayout(FramebufferLayout layout) { m_Layout = layout; }
+		FramebufferLayout GetLayout() const { return m_Layout; }
+
+		LinearLayout GetLinearLayout() const { return { m_Width }; }
+		TiledLayout GetTiledLayout() const { return { m_NrBlocksX }; }
+
+		int GetWidth() const { return m_Width; }
+		int GetHeight() const { return m_Height; }
+		// Padded to whole blocks
+		size_t GetNrPixels() const { return m_DepthPixels.size(); }
+
+		uint32_t* GetColorPixels() { return m_ColorPixels.data(); }
+		const uint32_t* GetColorPixels() const { return m_ColorPixels.data(); }
+		float* GetDepthPixels() { return m_DepthPixels.data(); }
+		const float* GetDepthPixels() const { return m_DepthPixels.data(); }
+
+		// Copies [left, right[ x [bottom, top[ of the color buffer to row-major pixels, pitch is in pixels
+		template<typename Layout>
+		void Resolve(const Layout& layout, int left, int right, int bottom, int top, uint32_t* pPixels, int pitch) const;
+
+	private:
+		int m_Width{};
+		int m_Height{};
+		int m_NrBlocksX{};
+		FramebufferLayout m_Layout{ FramebufferLayout::Linear };
+
+		// Sized for whole blocks, so both layouts fit
+		std::vector<uint32_t> m_ColorPixels{};
+		std::vector<float> m_DepthPixels{};
+	};
+
+	template<typename Layout>
+	void Framebuffer::Resolve(const Layout& layout, int left, int right, int bottom, int top, uint32_t* pPixels, int pitch) const
+	{
+		for (int py{ bottom }; py < top; ++py)
+		{
+			uint32_t* pRow{ pPixels + size_t(py) * pitch };
+			for (int px{ left }; px < right; ++px)
+			{
+				pRow[px] = m_ColorPixels[layout.GetIndex(px, py)];
+			}
+		}
+	}
+}
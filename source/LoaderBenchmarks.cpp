@@ -0,0 +1,117 @@
+#include "pch.h"
+#include "Benchmarks.h"
+#include "MeshCache.h"
+#include "ThreadPool.h"
+#include "Utils.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace dae
+{
+	namespace
+	{
+		// A flat grid of quads with normals and uvs, big enough to be split over every thread of the parser and the tangents
+		bool WriteGridOBJ(const std::string& filename, int gridSize)
+		{
+			std::ofstream file{ filename };
+			for (int y{}; y < gridSize; ++y)
+			{
+				for (int x{}; x < gridSize; ++x)
+				{
+					const float u{ float(x) / (gridSize - 1) };
+					const float v{ float(y) / (gridSize - 1) };
+					file << "v " << u * 40.f - 20.f << ' ' << v * 40.f - 20.f << " 0\nvt " << u << ' ' << v << "\nvn 0 0 -1\n";
+				}
+			}
+			for (int y{}; y < gridSize - 1; ++y)
+			{
+				for (int x{}; x < gridSize - 1; ++x)
+				{
+					const int corners[]{ y * gridSize + x + 1, y * gridSize + x + 2, (y + 1) * gridSize + x + 2, (y + 1) * gridSize + x + 1 };
+					file << 'f';
+					for (const int corner : corners)
+					{
+						file << ' ' << corner << '/' << corner << '/' << corner;
+					}
+					file << '\n';
+				}
+			}
+			return bool(file);
+		}
+
+		// Parse and tangents of the file on the pool, with the cook and the cache load when isCooked
+		void LoadFile(const std::string& filename, ThreadPool& threadPool, bool isCooked, int nrRepeats)
+		{
+			const double fileMB{ std::filesystem::file_size(filename) / (1024.0 * 1024.0) };
+
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			double parseMs{};
+			double tangentMs{};
+			double cookMs{};
+			double cacheMs{};
+			{
+				// Parsing and cooking print a line per call, the repeats would drown the results
+				const Benchmarks::SilencedOutput silencedOutput{};
+				for (int repeatIdx{}; repeatIdx < nrRepeats; ++repeatIdx)
+				{
+					const uint64_t parseStartCounter{ SDL_GetPerformanceCounter() };
+					Utils::ParseOBJ(filename, vertices, indices, true, &threadPool);
+					parseMs += Benchmarks::GetMilliseconds(parseStartCounter);
+
+					const uint64_t tangentStartCounter{ SDL_GetPerformanceCounter() };
+					Tangents::Generate(Tangents::Method::MikkTSpace, indices, vertices, &threadPool);
+					tangentMs += Benchmarks::GetMilliseconds(tangentStartCounter);
+
+					if (!isCooked)
+						continue;
+
+					MeshCache::CookedMesh mesh{};
+					const uint64_t cookStartCounter{ SDL_GetPerformanceCounter() };
+					MeshCache::Cook(filename, {}, mesh, &threadPool);
+					cookMs += Benchmarks::GetMilliseconds(cookStartCounter);
+
+					// The first load writes the cache, the next one maps it
+					MeshCache::LoadOrCook(filename, {}, mesh, &threadPool);
+					const uint64_t cacheStartCounter{ SDL_GetPerformanceCounter() };
+					MeshCache::LoadOrCook(filename, {}, mesh, &threadPool);
+					cacheMs += Benchmarks::GetMilliseconds(cacheStartCounter);
+				}
+			}
+
+			std::cout << filename << " (" << fileMB << "MB) on " << threadPool.GetThreadCount() << " threads:"
+				<< " parse " << parseMs / nrRepeats << "ms (" << fileMB * nrRepeats / parseMs * 1000.0 << "MB/s)"
+				<< " | tangents " << tangentMs / nrRepeats << "ms";
+			if (isCooked)
+				std::cout << " | cook " << cookMs / nrRepeats << "ms | cache load " << cacheMs / nrRepeats << "ms";
+			std::cout << '\n';
+		}
+	}
+
+	void Benchmarks::RunLoader(SDL_Window*)
+	{
+		const std::string gridPath{ (std::filesystem::temp_directory_path() / "DualRasterizerGrid.obj").string() };
+		if (!WriteGridOBJ(gridPath, 500))
+		{
+			std::cout << "Could not write " << gridPath << '\n';
+			return;
+		}
+
+		// One pool for every load like the renderer, on one thread and then on every thread
+		ThreadPool threadPool{ 1 };
+		const auto loadFiles{ [&](uint32_t nrThreads)
+			{
+				threadPool.SetThreadCount(nrThreads);
+				LoadFile("Resources/vehicle.obj", threadPool, true, 5);
+				LoadFile(gridPath, threadPool, false, 3);
+			} };
+
+		loadFiles(1);
+		const uint32_t maxThreads{ std::max(std::thread::hardware_concurrency(), 1u) };
+		if (maxThreads > 1)
+			loadFiles(maxThreads);
+
+		std::filesystem::remove(gridPath);
+	}
+}
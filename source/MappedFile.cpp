@@ -0,0 +1,51 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+using namespace dae;
+
+MappedFile::MappedFile(const std::string& filename)
+{
+	m_File = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_File == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(m_File, &size))
+		return;
+
+	// An empty file cannot be mapped, it is open without data
+	if (size.QuadPart == 0)
+	{
+		m_IsOpen = true;
+		return;
+	}
+
+	m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_Mapping == nullptr)
+		return;
+
+	m_pData = static_cast<const char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_pData == nullptr)
+		return;
+
+	m_Size = size_t(size.QuadPart);
+	m_IsOpen = true;
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_pData != nullptr) UnmapViewOfFile(m_pData);
+	if (m_Mapping != nullptr) CloseHandle(m_Mapping);
+	if (m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+}
+
+uint64_t MappedFile::GetHash() const
+{
+	uint64_t hash{ 14695981039346656037ull };
+	for (const char c : GetData())
+	{
+		hash ^= uint8_t(c);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
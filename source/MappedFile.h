@@ -0,0 +1,32 @@
+#pragma once
+#include <string_view>
+
+namespace dae
+{
+	// Read-only view of a whole file, mapped into memory instead of copied
+	class MappedFile final
+	{
+	public:
+		explicit MappedFile(const std::string& filename);
+		~MappedFile();
+
+		// rule of 5 copypasta
+		MappedFile(const MappedFile& other) = delete;
+		MappedFile(MappedFile&& other) = delete;
+		MappedFile& operator=(const MappedFile& other) = delete;
+		MappedFile& operator=(MappedFile&& other) = delete;
+
+		// An empty file is open but has no data, a file whose size or view could not be read is not open
+		bool IsOpen() const { return m_IsOpen; }
+		std::string_view GetData() const { return { m_pData, m_Size }; }
+		// 64 bit FNV-1a of the data, the caches built from a file keep it to notice when the file changed
+		uint64_t GetHash() const;
+
+	private:
+		HANDLE m_File{ INVALID_HANDLE_VALUE };
+		HANDLE m_Mapping{ nullptr };
+		const char* m_pData{ nullptr };
+		size_t m_Size{};
+		bool m_IsOpen{ false };
+	};
+}
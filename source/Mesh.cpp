@@ -2,69 +2,95 @@
 #include "Mesh.h"
 #include "Effect.h"
 #include <cassert>
-#include "utils.h"
 #include "Texture.h"
+#include "ThreadPool.h"
 
 using namespace dae;
 
 Mesh::Mesh(ID3D11Device* pDevice, const std::string& objectPath, Effect* pEffect,
-			Texture* pDiffuse, Texture* pNormal, Texture* pSpecular, Texture* pGlossiness)
+			Texture* pDiffuse, Texture* pNormal, Texture* pSpecular, Texture* pGlossiness, const MeshCache::LoadOptions& loadOptions,
+			ThreadPool* pThreadPool)
 	: m_pEffect{ pEffect }
 	, m_pDiffuse{ pDiffuse }
 	, m_pNormalMap{ pNormal }
 	, m_pSpecularMap{ pSpecular }
 	, m_pGlossinessMap{ pGlossiness }
 {
-	Utils::ParseOBJ(objectPath, vertices, indices);
+	// Cooked once, later launches load the binary cache next to the OBJ file
+	MeshCache::CookedMesh cookedMesh{};
+	if (!MeshCache::LoadOrCook(objectPath, loadOptions, cookedMesh, pThreadPool))
+		std::cout << objectPath << ": could not be loaded\n";
+	vertices = std::move(cookedMesh.vertices);
+	indices = std::move(cookedMesh.indices);
+	m_Bounds = cookedMesh.bounds;
+	m_Meshlets = std::move(cookedMesh.meshlets);
+	m_Lods = std::move(cookedMesh.lods);
+	if (m_Lods.empty())
+		m_Lods.push_back(MeshLod{ 0, uint32_t(indices.size()), 0, uint32_t(m_Meshlets.size()), uint32_t(vertices.size()) });
+
+	m_VertexStreams.Assign(vertices);
+	m_QuantizedVertexStreams.Assign(vertices, m_Bounds);
+	vertices_out.resize(vertices.size());
 
 	std::vector<VertexD11> verticesD11{};
+	verticesD11.reserve(vertices.size());
 	for (const Vertex& vtx : vertices)
 	{
 		verticesD11.push_back(VertexD11{ vtx.position, vtx.uv, vtx.normal, vtx.tangent });
 	}
 
+	// Same encoding as the software streams
+	const QuantizedVertexStreams& streams{ m_QuantizedVertexStreams };
+	std::vector<VertexD11Quantized> quantizedVerticesD11{};
+	quantizedVerticesD11.reserve(vertices.size());
+	for (size_t vertexIdx{}; vertexIdx < vertices.size(); ++vertexIdx)
+	{
+		quantizedVerticesD11.push_back(VertexD11Quantized{
+			{ streams.positionX[vertexIdx], streams.positionY[vertexIdx], streams.positionZ[vertexIdx], uint16_t(streams.tangentSigns[vertexIdx] < 0 ? 0 : 65535) },
+			{ streams.normalU[vertexIdx], streams.normalV[vertexIdx] },
+			{ streams.tangentU[vertexIdx], streams.tangentV[vertexIdx] },
+			{ streams.uvU[vertexIdx], streams.uvV[vertexIdx] } });
+	}
+
+	std::cout << objectPath << ": vertex memory " << m_VertexStreams.GetMemorySize() / 1024 << "KB software, "
+		<< verticesD11.size() * sizeof(VertexD11) / 1024 << "KB hardware, quantized "
+		<< m_QuantizedVertexStreams.GetMemorySize() / 1024 << "KB software, "
+		<< quantizedVerticesD11.size() * sizeof(VertexD11Quantized) / 1024 << "KB hardware\n";
+
 	m_pInputLayout = m_pEffect->LoadInputLayout(pDevice);
+	m_pQuantizedInputLayout = m_pEffect->LoadQuantizedInputLayout(pDevice);
+	// The input assembler already divides the unorms by 65535
+	m_pEffect->SetPositionDequantization(m_QuantizedVertexStreams.positionOffset, m_QuantizedVertexStreams.positionScale * 65535.f);
 	m_pEffect->SetDiffuseMap(pDiffuse);
 	m_pEffect->SetNormalMap(pNormal);
 	m_pEffect->SetSpecularMap(pSpecular);
 	m_pEffect->SetGlossinessMap(pGlossiness);
 
-	InitMesh(pDevice, verticesD11, indices);
+	InitMesh(pDevice, verticesD11, quantizedVerticesD11, indices);
 }
 
-void Mesh::VertexTransformationFunction()
+void Mesh::VertexTransformationFunction(ThreadPool& threadPool, const VertexKernel& kernel)
 {
-	vertices_out.clear();
-	vertices_out.reserve(vertices.size());
-
-	for (const Vertex& vtx : vertices)
-	{
-
-		Vertex_Out vertexOut{};
-
-		// to NDC-Space
-		vertexOut.position = m_WorldViewProjectionMatrix.TransformPoint({ vtx.position, 1.0f });
-
-		// The viewdirection is just the coordinates of the vertex after being transformed to viewspace
-		vertexOut.viewDirection = vertexOut.position.GetXYZ();
-		vertexOut.viewDirection.Normalize();
-
-		vertexOut.position.x /= vertexOut.position.w;
-		vertexOut.position.y /= vertexOut.position.w;
-		vertexOut.position.z /= vertexOut.position.w;
-
-		vertexOut.uv = vtx.uv;
-		vertexOut.normal = m_WorldMatrix.TransformVector(vtx.normal);
-		//vertexOut.normal.Normalize();
-		vertexOut.tangent = m_WorldMatrix.TransformVector(vtx.tangent);
-		//vertexOut.tangent.Normalize();
-
-		vertices_out.emplace_back(vertexOut);
-
-	}
+	// Big meshes are split over the workers, every chunk is a whole number of SIMD blocks
+	constexpr size_t chunkSize{ 4096 };
+	static_assert(chunkSize % VertexStreams::MaxLanes == 0);
+
+	// Only the vertices the current level of detail uses
+	const size_t nrVertices{ GetLod().nrVertices };
+	const uint32_t nrChunks{ static_cast<uint32_t>((nrVertices + chunkSize - 1) / chunkSize) };
+	threadPool.ParallelFor(nrChunks, [&](uint32_t chunkIdx)
+		{
+			const size_t first{ chunkIdx * chunkSize };
+			const size_t last{ std::min(first + chunkSize, nrVertices) };
+			if (m_UseQuantizedVertices)
+				kernel.pTransformQuantizedVertices(m_QuantizedVertexStreams, m_WorldViewProjectionMatrix, m_WorldMatrix, vertices_out.data(), first, last);
+			else
+				kernel.pTransformVertices(m_VertexStreams, m_WorldViewProjectionMatrix, m_WorldMatrix, vertices_out.data(), first, last);
+		});
 }
 
-void Mesh::InitMesh(ID3D11Device* pDevice, const std::vector<VertexD11>& vertices, const std::vector<uint32_t>& indices)
+void Mesh::InitMesh(ID3D11Device* pDevice, const std::vector<VertexD11>& vertices,
+	const std::vector<VertexD11Quantized>& quantizedVertices, const std::vector<uint32_t>& indices)
 {
 	//Create Vertex buffer
 	D3D11_BUFFER_DESC bd{};
@@ -81,6 +107,12 @@ void Mesh::InitMesh(ID3D11Device* pDevice, const std::vector<VertexD11>& vertice
 	if (FAILED(result))
 		return;
 
+	bd.ByteWidth = sizeof(VertexD11Quantized) * static_cast<uint32_t>(quantizedVertices.size());
+	initData.pSysMem = quantizedVertices.data();
+	result = pDevice->CreateBuffer(&bd, &initData, &m_pQuantizedVertexBuffer);
+	if (FAILED(result))
+		return;
+
 
 	//Create Index Buffer
 	m_NumIndices = static_cast<uint32_t>(indices.size());
@@ -105,6 +137,9 @@ Mesh::~Mesh()
 	delete m_pEffect;
 
 	if (m_pVertexBuffer) m_pVertexBuffer->Release();
+	if (m_pQuantizedVertexBuffer) m_pQuantizedVertexBuffer->Release();
+	if (m_pInputLayout) m_pInputLayout->Release();
+	if (m_pQuantizedInputLayout) m_pQuantizedInputLayout->Release();
 
 	if (m_pIndexBuffer) m_pIndexBuffer->Release();
 }
@@ -125,23 +160,24 @@ void Mesh::RenderDirectX(ID3D11DeviceContext* pDeviceContext) const
 	pDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	//2. Set Input Layout
-	pDeviceContext->IASetInputLayout(m_pInputLayout);
+	pDeviceContext->IASetInputLayout(m_UseQuantizedVertices ? m_pQuantizedInputLayout : m_pInputLayout);
 
 	//3. Set VertexBuffer
-	constexpr UINT stride = sizeof(VertexD11);
+	const UINT stride = m_UseQuantizedVertices ? sizeof(VertexD11Quantized) : sizeof(VertexD11);
 	constexpr UINT offset = 0;
-	pDeviceContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
+	pDeviceContext->IASetVertexBuffers(0, 1, m_UseQuantizedVertices ? &m_pQuantizedVertexBuffer : &m_pVertexBuffer, &stride, &offset);
 
 	//4. Set IndexBuffer
 	pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
 
 	//5. Draw
+	ID3DX11EffectTechnique* pTechnique{ m_UseQuantizedVertices ? m_pEffect->GetQuantizedTechnique() : m_pEffect->GetTechnique() };
 	D3DX11_TECHNIQUE_DESC techDesc{};
-	m_pEffect->GetTechnique()->GetDesc(&techDesc);
+	pTechnique->GetDesc(&techDesc);
 	for (UINT p = 0; p < techDesc.Passes; ++p)
 	{
-		m_pEffect->GetTechnique()->GetPassByIndex(p)->Apply(0, pDeviceContext);
-		pDeviceContext->DrawIndexed(m_NumIndices, 0, 0);
+		pTechnique->GetPassByIndex(p)->Apply(0, pDeviceContext);
+		pDeviceContext->DrawIndexed(GetLod().nrIndices, GetLod().firstIndex, 0);
 	}
 
 
@@ -151,11 +187,43 @@ void Mesh::SetMatrix(const Matrix& matrix, Matrix* invViewMatrix)
 {
 	m_ViewInverse = *invViewMatrix;
 	m_WorldViewProjectionMatrix = m_WorldMatrix * matrix;
+	m_CameraPosition = Matrix::Inverse(m_WorldMatrix).TransformPoint(m_ViewInverse.GetTranslation());
 	m_pEffect->SetWorldViewProjMatrix(reinterpret_cast<float*>(&m_WorldViewProjectionMatrix));
 	m_pEffect->SetWorldMatrix(reinterpret_cast<float*>(&m_WorldMatrix));
 	m_pEffect->SetInverseViewMatrix(reinterpret_cast<float*>(invViewMatrix));
 }
 
+bool Mesh::IsInFrustum() const
+{
+	// The planes are taken from the object to clip space matrix, so the bounds do not have to be transformed
+	return Clipping::IsVisible(GetFrustum(), m_Bounds);
+}
+
+Clipping::Frustum Mesh::GetFrustum() const
+{
+	return Clipping::GetFrustum(m_WorldViewProjectionMatrix);
+}
+
+void Mesh::SelectLod(float pixelsPerUnit, float maxPixelError)
+{
+	// The error is projected at the point of the bounding sphere closest to the camera, inside of it the full mesh is used
+	const float distance{ (m_CameraPosition - m_Bounds.center).Magnitude() - m_Bounds.radius };
+	m_LodIdx = 0;
+	if (distance <= 0.f)
+		return;
+
+	for (uint32_t lodIdx{ 1 }; lodIdx < m_Lods.size(); ++lodIdx)
+	{
+		if (m_Lods[lodIdx].error * pixelsPerUnit / distance <= maxPixelError)
+			m_LodIdx = lodIdx;
+	}
+}
+
+void Mesh::SetLod(uint32_t lodIdx)
+{
+	m_LodIdx = std::min(lodIdx, uint32_t(m_Lods.size()) - 1);
+}
+
 void Mesh::ToggleRotation()
 {
 	m_IsRotating = !m_IsRotating;
@@ -171,5 +239,19 @@ void Mesh::SetCullMode(ID3D11RasterizerState* newCullMode)
 	m_pEffect->SetCullMode(newCullMode);
 }
 
+void Mesh::SetQuantizedVertices(bool useQuantizedVertices)
+{
+	m_UseQuantizedVertices = useQuantizedVertices;
+}
+
+void Mesh::SetTexelLayout(Texture::TexelLayout layout)
+{
+	for (Texture* pTexture : { m_pDiffuse, m_pNormalMap, m_pSpecularMap, m_pGlossinessMap })
+	{
+		if (pTexture)
+			pTexture->SetLayout(layout);
+	}
+}
+
 
  
\ No newline at end of file
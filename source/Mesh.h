@@ -1,5 +1,9 @@
 #pragma once
 #include "DataTypes.h"
+#include "VertexKernels.h"
+#include "Clipping.h"
+#include "MeshCache.h"
+#include "Texture.h"
 
 namespace dae
 {
@@ -8,18 +12,32 @@ namespace dae
 		Vector3 position;
 		Vector2 uv;
 		Vector3 normal;
-		Vector3 tangent;
+		// w is the handedness of the tangent frame
+		Vector4 tangent;
+	};
+
+	struct VertexD11Quantized final //HARDWARE
+	{
+		// Unorm over the mesh bounds, w is the tangent handedness, 0 for -1 and 65535 for +1
+		uint16_t position[4];
+		// Octahedral snorm
+		int16_t normal[2];
+		int16_t tangent[2];
+		// Half floats
+		uint16_t uv[2];
 	};
 
 	class SoftwareShader;
 	class Effect;
-	class Texture;
+	class ThreadPool;
 
 	class Mesh final
 	{
 	public:
+		// The pool is only used while loading, see MeshCache::LoadOrCook
 		Mesh(ID3D11Device* pDevice, const std::string& objectPath, Effect* pEffect,
-			Texture* pDiffuse, Texture* pNormal, Texture* pSpecular, Texture* pGlossiness);
+			Texture* pDiffuse, Texture* pNormal, Texture* pSpecular, Texture* pGlossiness, const MeshCache::LoadOptions& loadOptions = {},
+			ThreadPool* pThreadPool = nullptr);
 		~Mesh();
 
 		// rule of 5 copypasta
@@ -33,24 +51,53 @@ namespace dae
 		void ToggleRotation();
 		void SetSamplerState(ID3D11SamplerState* pSampleState);
 		void SetCullMode(ID3D11RasterizerState* newCullMode);
+		// Switches both the software vertex streams and the hardware vertex buffer to the compact format
+		void SetQuantizedVertices(bool useQuantizedVertices);
+		// Reorders the texels of every texture for the software sampler
+		void SetTexelLayout(Texture::TexelLayout layout);
+		// The address modes and border color of this material, the renderer mirrors them in the D3D11 sampler state
+		void SetSampler(const Texture::Sampler& sampler) { m_Sampler = sampler; }
+		void SetTextureFilter(Texture::Filter filter) { m_Sampler.filter = filter; }
+		// Picks the coarsest level of detail whose error stays below maxPixelError on screen, for the camera of the last SetMatrix
+		// pixelsPerUnit is how many pixels one unit covers at a distance of one unit
+		void SelectLod(float pixelsPerUnit, float maxPixelError);
+		void SetLod(uint32_t lodIdx);
 
 		void RenderDirectX(ID3D11DeviceContext* pDeviceContext) const;
 
-		void VertexTransformationFunction();
-		const std::vector<uint32_t>& GetIndices() const { return indices; }
-		const std::vector<Vertex_Out>& GetVerticesOut() const { return vertices_out; }
+		// Overwrites the transformed vertices in place, the buffer is allocated once with the mesh
+		void VertexTransformationFunction(ThreadPool& threadPool, const VertexKernel& kernel);
+		// The indices of all levels of detail, the current one is a range of it
+		std::span<const uint32_t> GetIndices() const { return indices; }
+		std::span<const Vertex_Out> GetVerticesOut() const { return vertices_out; }
+		const MeshBounds& GetBounds() const { return m_Bounds; }
+		// The meshlets of the current level of detail
+		std::span<const Meshlet> GetMeshlets() const { return std::span<const Meshlet>{ m_Meshlets }.subspan(GetLod().firstMeshlet, GetLod().nrMeshlets); }
+		const MeshLod& GetLod() const { return m_Lods[m_LodIdx]; }
+		uint32_t GetLodIdx() const { return m_LodIdx; }
+		uint32_t GetNrLods() const { return uint32_t(m_Lods.size()); }
+		// Tests the bounds against the frustum of the last SetMatrix
+		bool IsInFrustum() const;
+		// The frustum planes and the camera of the last SetMatrix, in object space
+		Clipping::Frustum GetFrustum() const;
+		const Vector3& GetCameraPosition() const { return m_CameraPosition; }
 
 		const Texture* GetDiffuse() const { return m_pDiffuse; }
 		const Texture* GetNormal() const { return m_pNormalMap; }
 		const Texture* GetSpecular() const { return m_pSpecularMap; }
 		const Texture* GetGlossiness() const { return m_pGlossinessMap; }
+		const Texture::Sampler& GetSampler() const { return m_Sampler; }
 	private:
-		void InitMesh(ID3D11Device* pDevice, const std::vector<VertexD11>& vertices, const std::vector<uint32_t>& indices);
+		void InitMesh(ID3D11Device* pDevice, const std::vector<VertexD11>& vertices,
+			const std::vector<VertexD11Quantized>& quantizedVertices, const std::vector<uint32_t>& indices);
 
 
 		Effect* m_pEffect{ nullptr };
 		ID3D11InputLayout* m_pInputLayout{ nullptr };
 		ID3D11Buffer* m_pVertexBuffer{ nullptr };
+		ID3D11InputLayout* m_pQuantizedInputLayout{ nullptr };
+		ID3D11Buffer* m_pQuantizedVertexBuffer{ nullptr };
+		bool m_UseQuantizedVertices{ false };
 
 		uint32_t m_NumIndices{};
 		ID3D11Buffer* m_pIndexBuffer{ nullptr };
@@ -59,18 +106,27 @@ namespace dae
 		Matrix m_WorldMatrix{ m_StartWorldMatrix };
 		Matrix m_ViewInverse{};
 		Matrix m_WorldViewProjectionMatrix{};
+		Vector3 m_CameraPosition{};
+
+		MeshBounds m_Bounds{};
+		std::vector<Meshlet> m_Meshlets{};
+		std::vector<MeshLod> m_Lods{};
+		uint32_t m_LodIdx{};
 
 		bool m_IsRotating{ false };
 		float m_Rotation{};
 
 		//SOFTWARE
 		std::vector<Vertex> vertices{};
+		VertexStreams m_VertexStreams{};
+		QuantizedVertexStreams m_QuantizedVertexStreams{};
 		std::vector<uint32_t> indices{};
 		std::vector<Vertex_Out> vertices_out{};
 		Texture* m_pDiffuse{ nullptr };
 		Texture* m_pNormalMap{ nullptr };
 		Texture* m_pSpecularMap{ nullptr };
 		Texture* m_pGlossinessMap{ nullptr };
+		Texture::Sampler m_Sampler{};
 	};
 }
 
@@ -0,0 +1,270 @@
+#include "pch.h"
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "Meshlets.h"
+#include "Utils.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace dae
+{
+	namespace
+	{
+		constexpr uint32_t CacheMagic{ 'D' | 'M' << 8 | 'S' << 16 | 'H' << 24 };
+
+		// Loader options that change the cooked data, they are part of the cache key
+		enum CookOptions : uint32_t
+		{
+			FlipAxisAndWinding = 1 << 0,
+			PreserveTriangleOrder = 1 << 1,
+			// The Tangents::Method in bits 8 to 15
+			TangentMethodShift = 8,
+			// The amount of levels of detail in bits 16 and up
+			NrLodsShift = 16
+		};
+
+		// A level of detail may move the surface by this much of the bounding sphere radius at most,
+		// and it has to leave out at least this much of the triangles of the one before it to be kept
+		constexpr float MaxLodError{ 0.02f };
+		constexpr float MinLodReduction{ 0.15f };
+
+		// Followed by the vertices, the indices, the meshlets and the levels of detail, their sizes are checked against the file size on load
+		struct CacheHeader final
+		{
+			uint32_t magic{ CacheMagic };
+			uint32_t version{ MeshCache::FormatVersion };
+			uint32_t vertexSize{ sizeof(Vertex) };
+			uint32_t options{};
+			uint64_t sourceHash{};
+			uint64_t sourceSize{};
+			uint32_t nrVertices{};
+			uint32_t nrIndices{};
+			MeshBounds bounds{};
+			// How long the text path took when the cache was written
+			float cookMs{};
+			uint32_t nrMeshlets{};
+			uint32_t nrLods{};
+			uint32_t padding{};
+		};
+		static_assert(std::is_trivially_copyable_v<Vertex>);
+		static_assert(std::is_trivially_copyable_v<Meshlet>);
+		static_assert(std::is_trivially_copyable_v<MeshLod>);
+		static_assert(sizeof(CacheHeader) == 96, "the header is written as is, it can not have hidden padding");
+
+		double GetMilliseconds(uint64_t startTime)
+		{
+			return (SDL_GetPerformanceCounter() - startTime) * 1000.0 / SDL_GetPerformanceFrequency();
+		}
+
+		bool ReadCache(const std::string& cachePath, const CacheHeader& key, MeshCache::CookedMesh& mesh, float& cookMs)
+		{
+			const MappedFile file{ cachePath };
+			const std::string_view data{ file.GetData() };
+			if (!file.IsOpen() || data.size() < sizeof(CacheHeader))
+				return false;
+
+			CacheHeader header{};
+			std::memcpy(&header, data.data(), sizeof(CacheHeader));
+			if (header.magic != key.magic || header.version != key.version || header.vertexSize != key.vertexSize
+				|| header.options != key.options || header.sourceHash != key.sourceHash || header.sourceSize != key.sourceSize)
+				return false;
+
+			const size_t verticesSize{ size_t(header.nrVertices) * sizeof(Vertex) };
+			const size_t indicesSize{ size_t(header.nrIndices) * sizeof(uint32_t) };
+			const size_t meshletsSize{ size_t(header.nrMeshlets) * sizeof(Meshlet) };
+			const size_t lodsSize{ size_t(header.nrLods) * sizeof(MeshLod) };
+			if (data.size() != sizeof(CacheHeader) + verticesSize + indicesSize + meshletsSize + lodsSize || header.nrIndices % 3 != 0)
+				return false;
+
+			mesh.vertices.resize(header.nrVertices);
+			mesh.indices.resize(header.nrIndices);
+			std::memcpy(mesh.vertices.data(), data.data() + sizeof(CacheHeader), verticesSize);
+			std::memcpy(mesh.indices.data(), data.data() + sizeof(CacheHeader) + verticesSize, indicesSize);
+			mesh.meshlets.resize(header.nrMeshlets);
+			std::memcpy(mesh.meshlets.data(), data.data() + sizeof(CacheHeader) + verticesSize + indicesSize, meshletsSize);
+			mesh.lods.resize(header.nrLods);
+			std::memcpy(mesh.lods.data(), data.data() + sizeof(CacheHeader) + verticesSize + indicesSize + meshletsSize, lodsSize);
+			mesh.bounds = header.bounds;
+			cookMs = header.cookMs;
+
+			// A damaged file must not make the renderer read out of bounds
+			return std::all_of(mesh.indices.begin(), mesh.indices.end(), [&](uint32_t vertexIdx) { return vertexIdx < header.nrVertices; })
+				&& std::all_of(mesh.meshlets.begin(), mesh.meshlets.end(), [&](const Meshlet& meshlet)
+					{ return meshlet.nrIndices % 3 == 0 && meshlet.firstIndex % 3 == 0 && uint64_t(meshlet.firstIndex) + meshlet.nrIndices <= header.nrIndices; })
+				&& !mesh.lods.empty() && std::all_of(mesh.lods.begin(), mesh.lods.end(), [&](const MeshLod& lod)
+					{
+						return lod.nrIndices % 3 == 0 && lod.firstIndex % 3 == 0 && uint64_t(lod.firstIndex) + lod.nrIndices <= header.nrIndices
+							&& uint64_t(lod.firstMeshlet) + lod.nrMeshlets <= header.nrMeshlets && lod.nrVertices <= header.nrVertices
+							&& std::all_of(mesh.indices.begin() + lod.firstIndex, mesh.indices.begin() + lod.firstIndex + lod.nrIndices,
+								[&](uint32_t vertexIdx) { return vertexIdx < lod.nrVertices; });
+					});
+		}
+
+		bool WriteCache(const std::string& cachePath, const CacheHeader& header, const MeshCache::CookedMesh& mesh)
+		{
+			std::ofstream file{ cachePath, std::ios::binary | std::ios::trunc };
+			if (!file)
+				return false;
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+			file.write(reinterpret_cast<const char*>(mesh.vertices.data()), std::streamsize(mesh.vertices.size() * sizeof(Vertex)));
+			file.write(reinterpret_cast<const char*>(mesh.indices.data()), std::streamsize(mesh.indices.size() * sizeof(uint32_t)));
+			file.write(reinterpret_cast<const char*>(mesh.meshlets.data()), std::streamsize(mesh.meshlets.size() * sizeof(Meshlet)));
+			file.write(reinterpret_cast<const char*>(mesh.lods.data()), std::streamsize(mesh.lods.size() * sizeof(MeshLod)));
+			return bool(file);
+		}
+	}
+
+	namespace MeshCache
+	{
+		bool LoadOrCook(const std::string& sourcePath, const LoadOptions& options, CookedMesh& mesh, ThreadPool* pThreadPool)
+		{
+			const uint64_t startTime{ SDL_GetPerformanceCounter() };
+
+			CacheHeader key{};
+			key.options = (options.flipAxisAndWinding ? FlipAxisAndWinding : 0) | (options.preserveTriangleOrder ? PreserveTriangleOrder : 0)
+				| uint32_t(options.tangentMethod) << TangentMethodShift | options.nrLods << NrLodsShift;
+			{
+				const MappedFile source{ sourcePath };
+				if (!source.IsOpen())
+					return false;
+
+				key.sourceHash = source.GetHash();
+				key.sourceSize = source.GetData().size();
+			}
+
+			const std::string cachePath{ sourcePath + ".meshcache" };
+			float cookMs{};
+			if (ReadCache(cachePath, key, mesh, cookMs))
+			{
+				std::cout << sourcePath << ": loaded " << mesh.vertices.size() << " vertices and " << mesh.indices.size() / 3 << " triangles from "
+					<< cachePath << " in " << GetMilliseconds(startTime) << "ms, the text path took " << cookMs << "ms\n";
+				return true;
+			}
+
+			if (!Cook(sourcePath, options, mesh, pThreadPool))
+				return false;
+
+			key.nrVertices = uint32_t(mesh.vertices.size());
+			key.nrIndices = uint32_t(mesh.indices.size());
+			key.nrMeshlets = uint32_t(mesh.meshlets.size());
+			key.nrLods = uint32_t(mesh.lods.size());
+			key.bounds = mesh.bounds;
+			key.cookMs = float(GetMilliseconds(startTime));
+			std::cout << sourcePath << ": cooked in " << key.cookMs << "ms";
+			if (WriteCache(cachePath, key, mesh))
+				std::cout << ", cached in " << cachePath << '\n';
+			else
+				std::cout << ", could not write " << cachePath << '\n';
+
+			return true;
+		}
+
+		bool Cook(const std::string& sourcePath, const LoadOptions& options, CookedMesh& mesh, ThreadPool* pThreadPool)
+		{
+			if (!Utils::ParseOBJ(sourcePath, mesh.vertices, mesh.indices, options.flipAxisAndWinding, pThreadPool))
+				return false;
+
+			// On the final axes and winding, before the optimizer, so split vertices get reordered with the others
+			const uint64_t tangentStartTime{ SDL_GetPerformanceCounter() };
+			const Tangents::Result tangents{ Tangents::Generate(options.tangentMethod, mesh.indices, mesh.vertices, pThreadPool) };
+			std::cout << sourcePath << ": " << Tangents::GetName(options.tangentMethod) << " tangents in " << GetMilliseconds(tangentStartTime)
+				<< "ms on " << tangents.nrThreads << " threads, " << tangents.nrSplitVertices << " vertices split on mirror seams\n";
+
+			// Every level aims for half the triangles of the one before it, the errors add up since each one starts from the last
+			const uint64_t lodStartTime{ SDL_GetPerformanceCounter() };
+			mesh.bounds = ComputeBounds(mesh.vertices);
+			const float maxError{ MaxLodError * mesh.bounds.radius };
+			std::vector<std::vector<uint32_t>> lodIndices{};
+			std::vector<float> lodErrors{ 0.f };
+			lodIndices.push_back(std::move(mesh.indices));
+			const uint32_t nrLods{ options.preserveTriangleOrder ? 1 : options.nrLods };
+			while (lodIndices.size() < nrLods)
+			{
+				const std::vector<uint32_t>& previous{ lodIndices.back() };
+				float error{};
+				std::vector<uint32_t> simplified{ MeshOptimizer::Simplify(previous, mesh.vertices, previous.size() / 6 * 3, maxError - lodErrors.back(), error) };
+				if (float(simplified.size()) > float(previous.size()) * (1.f - MinLodReduction))
+					break;
+
+				lodErrors.push_back(lodErrors.back() + error);
+				lodIndices.push_back(std::move(simplified));
+			}
+			std::cout << sourcePath << ": " << lodIndices.size() << " levels of detail in " << GetMilliseconds(lodStartTime) << "ms,";
+			for (size_t lodIdx{}; lodIdx < lodIndices.size(); ++lodIdx)
+			{
+				std::cout << (lodIdx == 0 ? " " : ", ") << lodIndices[lodIdx].size() / 3 << " triangles (error " << lodErrors[lodIdx] << ")";
+			}
+			std::cout << '\n';
+
+			// Triangles of every level in post-transform cache order, clustered front to back and grouped into meshlets,
+			// the levels one after the other in the index buffer, then the vertices in order of first use
+			// The coarsest level goes first: a level only uses vertices of the one before it, so every level
+			// uses a prefix of the vertices and only that prefix has to be transformed
+			const float acmrBefore{ MeshOptimizer::ComputeACMR(lodIndices[0], mesh.vertices.size()) };
+			float acmrAfter{};
+			mesh.indices.clear();
+			mesh.meshlets.clear();
+			mesh.lods.assign(lodIndices.size(), MeshLod{});
+			for (size_t lodIdx{ lodIndices.size() }; lodIdx-- > 0;)
+			{
+				std::vector<uint32_t>& indices{ lodIndices[lodIdx] };
+				if (!options.preserveTriangleOrder)
+				{
+					MeshOptimizer::OptimizeVertexCache(indices, mesh.vertices.size());
+					MeshOptimizer::OptimizeOverdraw(indices, mesh.vertices);
+				}
+				std::vector<Meshlet> meshlets{ options.preserveTriangleOrder
+					? MeshOptimizer::BuildOrderedMeshlets(indices, mesh.vertices)
+					: MeshOptimizer::BuildMeshlets(indices, mesh.vertices) };
+				if (lodIdx == 0)
+					acmrAfter = MeshOptimizer::ComputeACMR(indices, mesh.vertices.size());
+
+				MeshLod& lod{ mesh.lods[lodIdx] };
+				lod = MeshLod{ uint32_t(mesh.indices.size()), uint32_t(indices.size()), uint32_t(mesh.meshlets.size()), uint32_t(meshlets.size()), 0, lodErrors[lodIdx] };
+				for (Meshlet& meshlet : meshlets)
+				{
+					meshlet.firstIndex += lod.firstIndex;
+				}
+				mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+				mesh.meshlets.insert(mesh.meshlets.end(), meshlets.begin(), meshlets.end());
+			}
+			MeshOptimizer::OptimizeVertexFetch(mesh.vertices, mesh.indices);
+			for (MeshLod& lod : mesh.lods)
+			{
+				const auto first{ mesh.indices.begin() + lod.firstIndex };
+				lod.nrVertices = lod.nrIndices > 0 ? *std::max_element(first, first + lod.nrIndices) + 1 : 0;
+			}
+			std::cout << sourcePath << ": ACMR " << acmrBefore << " -> " << acmrAfter << " with a " << MeshOptimizer::FifoCacheSize << " vertex FIFO cache\n";
+
+			mesh.bounds = ComputeBounds(mesh.vertices);
+			const MeshLod& fullLod{ mesh.lods[0] };
+			std::cout << sourcePath << ": " << mesh.meshlets.size() << " meshlets of at most " << Meshlets::MaxVertices << " vertices and "
+				<< Meshlets::MaxTriangles << " triangles, " << float(fullLod.nrIndices / 3) / std::max(fullLod.nrMeshlets, 1u) << " triangles on average in LOD 0\n";
+			return true;
+		}
+
+		MeshBounds ComputeBounds(const std::vector<Vertex>& vertices)
+		{
+			MeshBounds bounds{};
+			if (vertices.empty())
+				return bounds;
+
+			bounds.min = bounds.max = vertices[0].position;
+			for (const Vertex& vertex : vertices)
+			{
+				bounds.min = Vector3{ std::min(bounds.min.x, vertex.position.x), std::min(bounds.min.y, vertex.position.y), std::min(bounds.min.z, vertex.position.z) };
+				bounds.max = Vector3{ std::max(bounds.max.x, vertex.position.x), std::max(bounds.max.y, vertex.position.y), std::max(bounds.max.z, vertex.position.z) };
+			}
+
+			bounds.center = (bounds.min + bounds.max) * 0.5f;
+			for (const Vertex& vertex : vertices)
+			{
+				bounds.radius = std::max(bounds.radius, (vertex.position - bounds.center).Magnitude());
+			}
+			return bounds;
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "DataTypes.h"
+#include "Tangents.h"
+
+namespace dae
+{
+	class ThreadPool;
+
+	// Cooked meshes: parsed, optimized and ready to upload, stored next to the source file in a versioned binary format
+	// A later load maps the file and copies the arrays out of it, as long as the source and the loader options did not change
+	namespace MeshCache
+	{
+		// Bump this whenever the parser or the optimizer produces different output, older caches get cooked again
+		constexpr uint32_t FormatVersion{ 5 };
+
+		// Everything that changes the cooked data, so every field is part of the cache key
+		struct LoadOptions final
+		{
+			bool flipAxisAndWinding{ true };
+			Tangents::Method tangentMethod{ Tangents::Method::MikkTSpace };
+			// Levels of detail including the full mesh, fewer are kept when simplifying further does not pay off
+			uint32_t nrLods{ 4 };
+			// For blended meshes that are drawn in the order of their triangles: no vertex cache, overdraw or meshlet reordering
+			// and no levels of detail, the meshlets are cut from the triangles in file order
+			bool preserveTriangleOrder{ false };
+		};
+
+		struct CookedMesh final
+		{
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			MeshBounds bounds{};
+			std::vector<Meshlet> meshlets{};
+			std::vector<MeshLod> lods{};
+		};
+
+		// Loads the cache of the source file if it is still valid, cooks it and writes the cache otherwise
+		// The pool parses and generates the tangents, without one the calling thread does all of it
+		bool LoadOrCook(const std::string& sourcePath, const LoadOptions& options, CookedMesh& mesh, ThreadPool* pThreadPool = nullptr);
+
+		// Parses the OBJ file, generates the tangents and the levels of detail, reorders every level for the vertex cache and overdraw
+		// and cuts it into meshlets, then orders the vertices for the fetches of all of them
+		// With preserveTriangleOrder only the tangents, the meshlets and the vertex order are done
+		bool Cook(const std::string& sourcePath, const LoadOptions& options, CookedMesh& mesh, ThreadPool* pThreadPool = nullptr);
+
+		MeshBounds ComputeBounds(const std::vector<Vertex>& vertices);
+	}
+}
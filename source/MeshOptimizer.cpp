@@ -0,0 +1,844 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+#include "Meshlets.h"
+#include <map>
+#include <numeric>
+#include <tuple>
+
+namespace dae
+{
+	namespace
+	{
+		// Constants from "Linear-Speed Vertex Cache Optimisation", Tom Forsyth
+		constexpr int ForsythCacheSize{ 32 };
+		constexpr float CacheDecayPower{ 1.5f };
+		constexpr float LastTriangleScore{ 0.75f };
+		constexpr float ValenceBoostScale{ 2.f };
+		constexpr float ValenceBoostPower{ 0.5f };
+
+		// A triangle that faces more than about 37 degrees away from the first one of the meshlet is left for another one,
+		// otherwise the normal only breaks the tie between neighbours that add as many vertices
+		constexpr float MinMeshletFacing{ 0.8f };
+		constexpr float MeshletFacingWeight{ 1.f };
+
+		float GetVertexScore(int cachePosition, uint32_t nrRemainingTriangles)
+		{
+			// No triangles left, the vertex will never be needed again
+			if (nrRemainingTriangles == 0)
+				return -1.f;
+
+			float score{};
+			if (cachePosition >= 0)
+			{
+				// The vertices of the last triangle get a fixed score, so the next one does not simply reuse the same edge
+				if (cachePosition < 3)
+					score = LastTriangleScore;
+				else
+					score = powf(1.f - float(cachePosition - 3) / (ForsythCacheSize - 3), CacheDecayPower);
+			}
+
+			// Vertices with few triangles left get a boost, finishing them off frees up the cache
+			return score + ValenceBoostScale * powf(float(nrRemainingTriangles), -ValenceBoostPower);
+		}
+
+		// Edge collapses are tried cheapest first, a pass stops at the cost of the first quarter of its candidates,
+		// so the collapses it could not do because their neighbours moved get a fresh cost in the next pass
+		constexpr float SimplifyPassFraction{ 0.25f };
+		// A collapse may turn the normal of a surrounding triangle by about 75 degrees at most
+		constexpr float MinCollapseFacing{ 0.25f };
+		// Border edges get a plane perpendicular to their triangle, so the outline holds on to its shape
+		constexpr double BorderWeight{ 10.0 };
+
+		// The first vertex with the same position, vertices are split along the uv and normal seams
+		std::vector<uint32_t> GetPositionIds(const std::vector<Vertex>& vertices)
+		{
+			std::map<std::tuple<float, float, float>, uint32_t> firstVertices{};
+			std::vector<uint32_t> positionIds(vertices.size());
+			for (uint32_t vertexIdx{}; vertexIdx < vertices.size(); ++vertexIdx)
+			{
+				const Vector3& position{ vertices[vertexIdx].position };
+				positionIds[vertexIdx] = firstVertices.try_emplace({ position.x, position.y, position.z }, vertexIdx).first->second;
+			}
+			return positionIds;
+		}
+
+		// Sum of squared distances to a set of planes, weighted by the area they came from (Garland and Heckbert)
+		// Stored as the symmetric matrix A, the vector b and the scalar c of p * A * p + 2 * b * p + c
+		struct Quadric final
+		{
+			double a00{}, a01{}, a02{}, a11{}, a12{}, a22{};
+			double b0{}, b1{}, b2{};
+			double c{};
+			double weight{};
+
+			static Quadric FromPlane(const Vector3& normal, float distance, double weight)
+			{
+				const double x{ normal.x }, y{ normal.y }, z{ normal.z }, d{ distance };
+				return { x * x * weight, x * y * weight, x * z * weight, y * y * weight, y * z * weight, z * z * weight,
+					x * d * weight, y * d * weight, z * d * weight, d * d * weight, weight };
+			}
+
+			Quadric& operator+=(const Quadric& other)
+			{
+				a00 += other.a00; a01 += other.a01; a02 += other.a02; a11 += other.a11; a12 += other.a12; a22 += other.a22;
+				b0 += other.b0; b1 += other.b1; b2 += other.b2;
+				c += other.c;
+				weight += other.weight;
+				return *this;
+			}
+
+			// Mean squared distance of the point to the planes
+			double GetError(const Vector3& point) const
+			{
+				const double x{ point.x }, y{ point.y }, z{ point.z };
+				const double squaredDistance{ x * (a00 * x + a01 * y + a02 * z) + y * (a01 * x + a11 * y + a12 * z) + z * (a02 * x + a12 * y + a22 * z)
+					+ 2.0 * (b0 * x + b1 * y + b2 * z) + c };
+				return weight > 0.0 ? std::max(squaredDistance / weight, 0.0) : 0.0;
+			}
+		};
+
+		// Every triangle that still uses a vertex, removed ones are swapped out of the range
+		struct VertexAdjacency final
+		{
+			std::vector<uint32_t> offsets{};
+			std::vector<uint32_t> nrTriangles{};
+			std::vector<uint32_t> triangles{};
+
+			VertexAdjacency(const std::vector<uint32_t>& indices, size_t nrVertices) :
+				offsets(nrVertices + 1),
+				nrTriangles(nrVertices),
+				triangles(indices.size())
+			{
+				for (const uint32_t vertexIdx : indices)
+				{
+					++nrTriangles[vertexIdx];
+				}
+
+				for (size_t vertexIdx{}; vertexIdx < nrVertices; ++vertexIdx)
+				{
+					offsets[vertexIdx + 1] = offsets[vertexIdx] + nrTriangles[vertexIdx];
+				}
+
+				std::vector<uint32_t> nrAdded(nrVertices);
+				for (size_t idx{}; idx < indices.size(); ++idx)
+				{
+					const uint32_t vertexIdx{ indices[idx] };
+					triangles[offsets[vertexIdx] + nrAdded[vertexIdx]++] = uint32_t(idx / 3);
+				}
+			}
+
+			void Remove(uint32_t vertexIdx, uint32_t triangleIdx)
+			{
+				uint32_t* pTriangles{ &triangles[offsets[vertexIdx]] };
+				uint32_t& count{ nrTriangles[vertexIdx] };
+				for (uint32_t i{}; i < count; ++i)
+				{
+					if (pTriangles[i] == triangleIdx)
+					{
+						pTriangles[i] = pTriangles[--count];
+						return;
+					}
+				}
+			}
+		};
+
+		// The triangles around a position that also use the other one, 1 on a border edge and 2 inside the surface
+		uint32_t CountEdgeTriangles(const VertexAdjacency& adjacency, const std::vector<uint32_t>& positionIndices, uint32_t from, uint32_t to)
+		{
+			uint32_t nrEdgeTriangles{};
+			const uint32_t* pTriangles{ &adjacency.triangles[adjacency.offsets[from]] };
+			for (uint32_t i{}; i < adjacency.nrTriangles[from]; ++i)
+			{
+				const uint32_t* pPositions{ &positionIndices[pTriangles[i] * 3] };
+				if (pPositions[0] == to || pPositions[1] == to || pPositions[2] == to)
+					++nrEdgeTriangles;
+			}
+			return nrEdgeTriangles;
+		}
+
+		// The other positions of the triangles around a position, in no particular order and with repeats
+		void GetNeighbours(const VertexAdjacency& adjacency, const std::vector<uint32_t>& positionIndices, uint32_t positionIdx,
+			std::vector<uint32_t>& neighbours)
+		{
+			neighbours.clear();
+			const uint32_t* pTriangles{ &adjacency.triangles[adjacency.offsets[positionIdx]] };
+			for (uint32_t i{}; i < adjacency.nrTriangles[positionIdx]; ++i)
+			{
+				const uint32_t* pPositions{ &positionIndices[pTriangles[i] * 3] };
+				for (int corner{}; corner < 3; ++corner)
+				{
+					if (pPositions[corner] != positionIdx)
+						neighbours.push_back(pPositions[corner]);
+				}
+			}
+			std::sort(neighbours.begin(), neighbours.end());
+			neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+		}
+	}
+
+	namespace MeshOptimizer
+	{
+		float ComputeACMR(const std::vector<uint32_t>& indices, size_t nrVertices, uint32_t cacheSize)
+		{
+			if (indices.empty())
+				return 0.f;
+
+			// A vertex is in the cache when it was pushed less than cacheSize misses ago
+			std::vector<uint32_t> cacheTimestamps(nrVertices, 0);
+			uint32_t timestamp{ cacheSize + 1 };
+			uint32_t nrMisses{};
+			for (const uint32_t vertexIdx : indices)
+			{
+				if (timestamp - cacheTimestamps[vertexIdx] > cacheSize)
+				{
+					cacheTimestamps[vertexIdx] = timestamp++;
+					++nrMisses;
+				}
+			}
+
+			return float(nrMisses) / float(indices.size() / 3);
+		}
+
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t nrVertices)
+		{
+			const size_t nrTriangles{ indices.size() / 3 };
+			if (nrTriangles == 0)
+				return;
+
+			VertexAdjacency adjacency{ indices, nrVertices };
+
+			std::vector<int> cachePositions(nrVertices, -1);
+			std::vector<float> vertexScores(nrVertices);
+			for (size_t vertexIdx{}; vertexIdx < nrVertices; ++vertexIdx)
+			{
+				vertexScores[vertexIdx] = GetVertexScore(-1, adjacency.nrTriangles[vertexIdx]);
+			}
+
+			std::vector<float> triangleScores(nrTriangles);
+			std::vector<bool> isTriangleAdded(nrTriangles, false);
+			for (size_t triangleIdx{}; triangleIdx < nrTriangles; ++triangleIdx)
+			{
+				const uint32_t* pIndices{ &indices[triangleIdx * 3] };
+				triangleScores[triangleIdx] = vertexScores[pIndices[0]] + vertexScores[pIndices[1]] + vertexScores[pIndices[2]];
+			}
+
+			std::vector<uint32_t> optimizedIndices{};
+			optimizedIndices.reserve(indices.size());
+
+			// The last triangle pushes its vertices to the front, the cache holds 3 extra while it gets updated
+			std::vector<uint32_t> cache{};
+			std::vector<uint32_t> newCache{};
+			cache.reserve(ForsythCacheSize + 3);
+			newCache.reserve(ForsythCacheSize + 3);
+
+			uint32_t bestTriangle{ uint32_t(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin()) };
+			size_t nextUnaddedTriangle{};
+
+			for (size_t nrAdded{}; nrAdded < nrTriangles; ++nrAdded)
+			{
+				// Nothing in the cache has triangles left, continue with the first triangle that has not been added
+				if (bestTriangle == UINT32_MAX)
+				{
+					while (isTriangleAdded[nextUnaddedTriangle])
+					{
+						++nextUnaddedTriangle;
+					}
+					bestTriangle = uint32_t(nextUnaddedTriangle);
+				}
+
+				const uint32_t triangleVertices[3]{ indices[bestTriangle * 3], indices[bestTriangle * 3 + 1], indices[bestTriangle * 3 + 2] };
+				optimizedIndices.insert(optimizedIndices.end(), std::begin(triangleVertices), std::end(triangleVertices));
+				isTriangleAdded[bestTriangle] = true;
+
+				newCache.assign(std::begin(triangleVertices), std::end(triangleVertices));
+				for (const uint32_t vertexIdx : triangleVertices)
+				{
+					adjacency.Remove(vertexIdx, bestTriangle);
+				}
+				for (const uint32_t vertexIdx : cache)
+				{
+					if (vertexIdx != triangleVertices[0] && vertexIdx != triangleVertices[1] && vertexIdx != triangleVertices[2])
+						newCache.push_back(vertexIdx);
+				}
+
+				// Rescore the vertices that moved in or fell out of the cache, then every triangle that still uses them
+				for (size_t position{}; position < newCache.size(); ++position)
+				{
+					const uint32_t vertexIdx{ newCache[position] };
+					cachePositions[vertexIdx] = position < ForsythCacheSize ? int(position) : -1;
+					vertexScores[vertexIdx] = GetVertexScore(cachePositions[vertexIdx], adjacency.nrTriangles[vertexIdx]);
+				}
+
+				float bestScore{ -1.f };
+				bestTriangle = UINT32_MAX;
+				for (const uint32_t vertexIdx : newCache)
+				{
+					const uint32_t* pTriangles{ &adjacency.triangles[adjacency.offsets[vertexIdx]] };
+					for (uint32_t i{}; i < adjacency.nrTriangles[vertexIdx]; ++i)
+					{
+						const uint32_t triangleIdx{ pTriangles[i] };
+						const uint32_t* pIndices{ &indices[triangleIdx * 3] };
+						const float score{ vertexScores[pIndices[0]] + vertexScores[pIndices[1]] + vertexScores[pIndices[2]] };
+						triangleScores[triangleIdx] = score;
+						if (score > bestScore)
+						{
+							bestScore = score;
+							bestTriangle = triangleIdx;
+						}
+					}
+				}
+
+				if (newCache.size() > ForsythCacheSize)
+					newCache.resize(ForsythCacheSize);
+				std::swap(cache, newCache);
+			}
+
+			indices = std::move(optimizedIndices);
+		}
+
+		void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices)
+		{
+			const size_t nrTriangles{ indices.size() / 3 };
+			if (nrTriangles == 0)
+				return;
+
+			// A new cluster starts wherever the FIFO cache misses all three vertices, reordering those costs no cache hits
+			std::vector<size_t> clusterStarts{};
+			std::vector<uint32_t> cacheTimestamps(vertices.size(), 0);
+			uint32_t timestamp{ FifoCacheSize + 1 };
+			for (size_t triangleIdx{}; triangleIdx < nrTriangles; ++triangleIdx)
+			{
+				int nrMisses{};
+				for (int i{}; i < 3; ++i)
+				{
+					const uint32_t vertexIdx{ indices[triangleIdx * 3 + i] };
+					if (timestamp - cacheTimestamps[vertexIdx] > FifoCacheSize)
+					{
+						cacheTimestamps[vertexIdx] = timestamp++;
+						++nrMisses;
+					}
+				}
+
+				if (nrMisses == 3 || triangleIdx == 0)
+					clusterStarts.push_back(triangleIdx);
+			}
+			clusterStarts.push_back(nrTriangles);
+
+			// Area weighted centroid and normal of every cluster and of the whole mesh
+			// The normals come from the vertices, the winding of the faces depends on how the mesh was loaded
+			struct Cluster
+			{
+				size_t firstTriangle{};
+				size_t lastTriangle{};
+				Vector3 centroid{};
+				Vector3 normal{};
+				float area{};
+				float sortKey{};
+			};
+			std::vector<Cluster> clusters(clusterStarts.size() - 1);
+
+			Vector3 meshCentroid{};
+			float meshArea{};
+			for (size_t clusterIdx{}; clusterIdx < clusters.size(); ++clusterIdx)
+			{
+				Cluster& cluster{ clusters[clusterIdx] };
+				cluster.firstTriangle = clusterStarts[clusterIdx];
+				cluster.lastTriangle = clusterStarts[clusterIdx + 1];
+
+				for (size_t triangleIdx{ cluster.firstTriangle }; triangleIdx < cluster.lastTriangle; ++triangleIdx)
+				{
+					const Vertex& vertex0{ vertices[indices[triangleIdx * 3]] };
+					const Vertex& vertex1{ vertices[indices[triangleIdx * 3 + 1]] };
+					const Vertex& vertex2{ vertices[indices[triangleIdx * 3 + 2]] };
+
+					const float area{ Vector3::Cross(vertex1.position - vertex0.position, vertex2.position - vertex0.position).Magnitude() * 0.5f };
+					cluster.centroid += (vertex0.position + vertex1.position + vertex2.position) * (area / 3.f);
+					cluster.normal += (vertex0.normal + vertex1.normal + vertex2.normal) * area;
+					cluster.area += area;
+				}
+
+				meshCentroid += cluster.centroid;
+				meshArea += cluster.area;
+				if (cluster.area > 0.f)
+					cluster.centroid = cluster.centroid / cluster.area;
+			}
+			if (meshArea > 0.f)
+				meshCentroid = meshCentroid / meshArea;
+
+			for (Cluster& cluster : clusters)
+			{
+				const float normalLength{ cluster.normal.Magnitude() };
+				if (normalLength > 0.f)
+					cluster.sortKey = Vector3::Dot(cluster.centroid - meshCentroid, cluster.normal / normalLength);
+			}
+
+			std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+			std::vector<uint32_t> sortedIndices{};
+			sortedIndices.reserve(indices.size());
+			for (const Cluster& cluster : clusters)
+			{
+				sortedIndices.insert(sortedIndices.end(), indices.begin() + cluster.firstTriangle * 3, indices.begin() + cluster.lastTriangle * 3);
+			}
+			indices = std::move(sortedIndices);
+		}
+
+		std::vector<Meshlet> BuildMeshlets(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices)
+		{
+			const size_t nrTriangles{ indices.size() / 3 };
+			std::vector<Meshlet> meshlets{};
+			if (nrTriangles == 0)
+				return meshlets;
+
+			// Neighbours are found through the positions, the vertices are split along the uv and normal seams
+			std::vector<uint32_t> positionIndices(indices.size());
+			{
+				const std::vector<uint32_t> positionIds{ GetPositionIds(vertices) };
+				for (size_t idx{}; idx < indices.size(); ++idx)
+				{
+					positionIndices[idx] = positionIds[indices[idx]];
+				}
+			}
+			VertexAdjacency adjacency{ positionIndices, vertices.size() };
+
+			std::vector<Vector3> faceNormals(nrTriangles);
+			for (size_t triangleIdx{}; triangleIdx < nrTriangles; ++triangleIdx)
+			{
+				faceNormals[triangleIdx] = Meshlets::GetFaceNormal(vertices, &indices[triangleIdx * 3]);
+			}
+
+			// Which meshlet a vertex or position was last added to, so the sets never have to be cleared
+			std::vector<uint32_t> vertexMeshlets(vertices.size(), UINT32_MAX);
+			std::vector<uint32_t> positionMeshlets(vertices.size(), UINT32_MAX);
+			uint32_t nrMeshletVertices{};
+			std::vector<uint32_t> meshletPositions{};
+			meshletPositions.reserve(Meshlets::MaxVertices);
+			std::vector<bool> isTriangleAdded(nrTriangles, false);
+			std::vector<uint32_t> meshletSizes{};
+
+			std::vector<uint32_t> sortedIndices{};
+			sortedIndices.reserve(indices.size());
+
+			const auto countNewVertices{ [&](uint32_t triangleIdx, uint32_t meshletIdx)
+				{
+					const uint32_t* pIndices{ &indices[triangleIdx * 3] };
+					uint32_t nrNewVertices{};
+					for (int i{}; i < 3; ++i)
+					{
+						const bool isRepeated{ (i > 0 && pIndices[i] == pIndices[0]) || (i > 1 && pIndices[i] == pIndices[1]) };
+						if (!isRepeated && vertexMeshlets[pIndices[i]] != meshletIdx)
+							++nrNewVertices;
+					}
+					return nrNewVertices;
+				} };
+
+			size_t nextUnaddedTriangle{};
+			while (sortedIndices.size() < indices.size())
+			{
+				const uint32_t meshletIdx{ uint32_t(meshletSizes.size()) };
+				nrMeshletVertices = 0;
+				meshletPositions.clear();
+				uint32_t nrMeshletTriangles{};
+
+				while (isTriangleAdded[nextUnaddedTriangle])
+				{
+					++nextUnaddedTriangle;
+				}
+				uint32_t bestTriangle{ uint32_t(nextUnaddedTriangle) };
+				const Vector3 seedNormal{ faceNormals[bestTriangle] };
+
+				while (bestTriangle != UINT32_MAX)
+				{
+					const uint32_t* pIndices{ &indices[bestTriangle * 3] };
+					const uint32_t* pPositionIndices{ &positionIndices[bestTriangle * 3] };
+					for (int i{}; i < 3; ++i)
+					{
+						if (vertexMeshlets[pIndices[i]] != meshletIdx)
+						{
+							vertexMeshlets[pIndices[i]] = meshletIdx;
+							++nrMeshletVertices;
+						}
+
+						adjacency.Remove(pPositionIndices[i], bestTriangle);
+						if (positionMeshlets[pPositionIndices[i]] != meshletIdx)
+						{
+							positionMeshlets[pPositionIndices[i]] = meshletIdx;
+							meshletPositions.push_back(pPositionIndices[i]);
+						}
+					}
+					sortedIndices.insert(sortedIndices.end(), pIndices, pIndices + 3);
+					isTriangleAdded[bestTriangle] = true;
+					if (++nrMeshletTriangles == Meshlets::MaxTriangles)
+						break;
+
+					// The triangles left around the positions of the meshlet, degenerate ones fit anywhere
+					// Comparing with the first triangle instead of the average keeps the cone from drifting
+					float bestScore{ FLT_MAX };
+					bestTriangle = UINT32_MAX;
+					for (const uint32_t positionIdx : meshletPositions)
+					{
+						const uint32_t* pTriangles{ &adjacency.triangles[adjacency.offsets[positionIdx]] };
+						for (uint32_t i{}; i < adjacency.nrTriangles[positionIdx]; ++i)
+						{
+							const uint32_t triangleIdx{ pTriangles[i] };
+							const uint32_t nrNewVertices{ countNewVertices(triangleIdx, meshletIdx) };
+							if (nrMeshletVertices + nrNewVertices > Meshlets::MaxVertices)
+								continue;
+
+							const Vector3& normal{ faceNormals[triangleIdx] };
+							const float facing{ normal.SqrMagnitude() > 0.f && seedNormal.SqrMagnitude() > 0.f ? Vector3::Dot(normal, seedNormal) : 1.f };
+							if (facing < MinMeshletFacing)
+								continue;
+
+							const float score{ float(nrNewVertices) + MeshletFacingWeight * (1.f - facing) };
+							if (score < bestScore)
+							{
+								bestScore = score;
+								bestTriangle = triangleIdx;
+							}
+						}
+					}
+				}
+				meshletSizes.push_back(nrMeshletTriangles * 3);
+			}
+			indices = std::move(sortedIndices);
+
+			meshlets.reserve(meshletSizes.size());
+			uint32_t firstIndex{};
+			for (const uint32_t nrIndices : meshletSizes)
+			{
+				meshlets.push_back(Meshlets::Create(indices, vertices, firstIndex, nrIndices));
+				firstIndex += nrIndices;
+			}
+			return meshlets;
+		}
+
+		std::vector<Meshlet> BuildOrderedMeshlets(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices)
+		{
+			std::vector<Meshlet> meshlets{};
+
+			// Which meshlet a vertex was last added to, so the set never has to be cleared
+			std::vector<uint32_t> vertexMeshlets(vertices.size(), UINT32_MAX);
+			uint32_t nrMeshletVertices{};
+			uint32_t firstIndex{};
+			for (uint32_t idx{}; idx < indices.size(); idx += 3)
+			{
+				const uint32_t meshletIdx{ uint32_t(meshlets.size()) };
+				const uint32_t* pIndices{ &indices[idx] };
+				uint32_t nrNewVertices{};
+				for (int i{}; i < 3; ++i)
+				{
+					const bool isRepeated{ (i > 0 && pIndices[i] == pIndices[0]) || (i > 1 && pIndices[i] == pIndices[1]) };
+					if (!isRepeated && vertexMeshlets[pIndices[i]] != meshletIdx)
+						++nrNewVertices;
+				}
+
+				// The next triangle does not fit anymore, it starts the next meshlet
+				if (nrMeshletVertices + nrNewVertices > Meshlets::MaxVertices || (idx - firstIndex) / 3 == Meshlets::MaxTriangles)
+				{
+					meshlets.push_back(Meshlets::Create(indices, vertices, firstIndex, idx - firstIndex));
+					firstIndex = idx;
+					nrMeshletVertices = 0;
+				}
+
+				for (int i{}; i < 3; ++i)
+				{
+					if (vertexMeshlets[pIndices[i]] != uint32_t(meshlets.size()))
+					{
+						vertexMeshlets[pIndices[i]] = uint32_t(meshlets.size());
+						++nrMeshletVertices;
+					}
+				}
+			}
+
+			if (firstIndex < indices.size())
+				meshlets.push_back(Meshlets::Create(indices, vertices, firstIndex, uint32_t(indices.size()) - firstIndex));
+			return meshlets;
+		}
+
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+			std::vector<Vertex> sortedVertices{};
+			sortedVertices.reserve(vertices.size());
+
+			for (uint32_t& vertexIdx : indices)
+			{
+				if (remap[vertexIdx] == UINT32_MAX)
+				{
+					remap[vertexIdx] = uint32_t(sortedVertices.size());
+					sortedVertices.push_back(vertices[vertexIdx]);
+				}
+				vertexIdx = remap[vertexIdx];
+			}
+
+			// Vertices no triangle uses are dropped
+			vertices = std::move(sortedVertices);
+		}
+
+		std::vector<uint32_t> Simplify(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, size_t targetNrIndices,
+			float maxError, float& error)
+		{
+			error = 0.f;
+			std::vector<uint32_t> simplified{ indices };
+
+			// Collapses move a whole position, every vertex of it goes to the vertex on the other side of the collapsed edge
+			const std::vector<uint32_t> positionIds{ GetPositionIds(vertices) };
+			std::vector<uint32_t> positionIndices{};
+			const auto updatePositionIndices{ [&]()
+				{
+					positionIndices.resize(simplified.size());
+					for (size_t idx{}; idx < simplified.size(); ++idx)
+					{
+						positionIndices[idx] = positionIds[simplified[idx]];
+					}
+				} };
+			const auto getPosition{ [&](uint32_t positionIdx) -> const Vector3& { return vertices[positionIdx].position; } };
+			updatePositionIndices();
+
+			// The planes of the triangles around every position, and of the border edges
+			std::vector<Quadric> quadrics(vertices.size());
+			{
+				const VertexAdjacency adjacency{ positionIndices, vertices.size() };
+				for (size_t triangleIdx{}; triangleIdx < simplified.size() / 3; ++triangleIdx)
+				{
+					const uint32_t* pPositions{ &positionIndices[triangleIdx * 3] };
+					const Vector3& position0{ getPosition(pPositions[0]) };
+					Vector3 normal{ Vector3::Cross(getPosition(pPositions[1]) - position0, getPosition(pPositions[2]) - position0) };
+					const float doubleArea{ normal.Magnitude() };
+					if (doubleArea <= 0.f)
+						continue;
+
+					normal /= doubleArea;
+					const Quadric face{ Quadric::FromPlane(normal, -Vector3::Dot(normal, position0), doubleArea * 0.5) };
+					for (int corner{}; corner < 3; ++corner)
+					{
+						quadrics[pPositions[corner]] += face;
+					}
+
+					for (int corner{}; corner < 3; ++corner)
+					{
+						const uint32_t from{ pPositions[corner] };
+						const uint32_t to{ pPositions[(corner + 1) % 3] };
+						if (CountEdgeTriangles(adjacency, positionIndices, from, to) != 1)
+							continue;
+
+						const Vector3 edge{ getPosition(to) - getPosition(from) };
+						Vector3 borderNormal{ Vector3::Cross(edge, normal) };
+						const float length{ borderNormal.Magnitude() };
+						if (length <= 0.f)
+							continue;
+
+						borderNormal /= length;
+						const Quadric border{ Quadric::FromPlane(borderNormal, -Vector3::Dot(borderNormal, getPosition(from)), edge.SqrMagnitude() * BorderWeight) };
+						quadrics[from] += border;
+						quadrics[to] += border;
+					}
+				}
+			}
+
+			struct Collapse final
+			{
+				float cost{};
+				uint32_t from{};
+				uint32_t to{};
+			};
+			std::vector<Collapse> collapses{};
+			std::vector<Collapse> validCollapses{};
+			std::vector<bool> isBorder(vertices.size());
+			std::vector<bool> isLocked(vertices.size());
+			std::vector<uint32_t> remap(vertices.size());
+			std::vector<std::pair<uint32_t, uint32_t>> vertexPairs{};
+			std::vector<uint32_t> fromNeighbours{};
+			std::vector<uint32_t> toNeighbours{};
+			// How far every position is from the surface of the full mesh at most
+			std::vector<float> positionErrors(vertices.size());
+
+			while (simplified.size() > targetNrIndices)
+			{
+				// Every edge in both directions, costs are measured where the position would move to
+				const VertexAdjacency adjacency{ positionIndices, vertices.size() };
+				std::fill(isBorder.begin(), isBorder.end(), false);
+				collapses.clear();
+				for (size_t triangleIdx{}; triangleIdx < simplified.size() / 3; ++triangleIdx)
+				{
+					const uint32_t* pPositions{ &positionIndices[triangleIdx * 3] };
+					for (int corner{}; corner < 3; ++corner)
+					{
+						const uint32_t from{ pPositions[corner] };
+						const uint32_t to{ pPositions[(corner + 1) % 3] };
+						if (CountEdgeTriangles(adjacency, positionIndices, from, to) == 1)
+							isBorder[from] = isBorder[to] = true;
+
+						Quadric merged{ quadrics[from] };
+						merged += quadrics[to];
+						collapses.push_back({ float(merged.GetError(getPosition(to))), from, to });
+						collapses.push_back({ float(merged.GetError(getPosition(from))), to, from });
+					}
+				}
+				std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+					{
+						return std::tie(a.cost, a.from, a.to) < std::tie(b.cost, b.from, b.to);
+					});
+				// The amount of triangles the collapse removes, 0 when it can not be done
+				// Positions on a border only move along it, and only two triangles may share an edge afterwards
+				const auto validateCollapse{ [&](uint32_t from, uint32_t to) -> uint32_t
+					{
+						const uint32_t nrEdgeTriangles{ CountEdgeTriangles(adjacency, positionIndices, from, to) };
+						if (isBorder[from] && nrEdgeTriangles != 1)
+							return 0;
+
+						GetNeighbours(adjacency, positionIndices, from, fromNeighbours);
+						GetNeighbours(adjacency, positionIndices, to, toNeighbours);
+						uint32_t nrSharedNeighbours{};
+						for (const uint32_t neighbour : fromNeighbours)
+						{
+							if (neighbour != to && std::binary_search(toNeighbours.begin(), toNeighbours.end(), neighbour))
+								++nrSharedNeighbours;
+						}
+						if (nrSharedNeighbours != nrEdgeTriangles)
+							return 0;
+
+						// The triangles on the edge tell which vertex of the other position every vertex goes to,
+						// a seam can only be collapsed along itself, where both sides have such a triangle
+						const uint32_t* pTriangles{ &adjacency.triangles[adjacency.offsets[from]] };
+						const uint32_t nrFromTriangles{ adjacency.nrTriangles[from] };
+						const auto findCorner{ [&](uint32_t triangleIdx, uint32_t positionIdx)
+							{
+								const uint32_t* pPositions{ &positionIndices[triangleIdx * 3] };
+								return pPositions[0] == positionIdx ? 0 : pPositions[1] == positionIdx ? 1 : pPositions[2] == positionIdx ? 2 : -1;
+							} };
+
+						vertexPairs.clear();
+						for (uint32_t i{}; i < nrFromTriangles; ++i)
+						{
+							const uint32_t triangleIdx{ pTriangles[i] };
+							const int toCorner{ findCorner(triangleIdx, to) };
+							if (toCorner < 0)
+								continue;
+
+							const uint32_t vertexIdx{ simplified[triangleIdx * 3 + findCorner(triangleIdx, from)] };
+							const uint32_t targetIdx{ simplified[triangleIdx * 3 + toCorner] };
+							const auto it{ std::find_if(vertexPairs.begin(), vertexPairs.end(), [&](const auto& pair) { return pair.first == vertexIdx; }) };
+							if (it == vertexPairs.end())
+								vertexPairs.emplace_back(vertexIdx, targetIdx);
+							else if (it->second != targetIdx)
+								return 0;
+						}
+
+						// The other triangles only get stretched, they may not flip or collapse to a line
+						for (uint32_t i{}; i < nrFromTriangles; ++i)
+						{
+							const uint32_t triangleIdx{ pTriangles[i] };
+							if (findCorner(triangleIdx, to) >= 0)
+								continue;
+
+							const int fromCorner{ findCorner(triangleIdx, from) };
+							const uint32_t vertexIdx{ simplified[triangleIdx * 3 + fromCorner] };
+							if (std::none_of(vertexPairs.begin(), vertexPairs.end(), [&](const auto& pair) { return pair.first == vertexIdx; }))
+								return 0;
+
+							const uint32_t* pPositions{ &positionIndices[triangleIdx * 3] };
+							Vector3 positions[3]{ getPosition(pPositions[0]), getPosition(pPositions[1]), getPosition(pPositions[2]) };
+							const Vector3 normalBefore{ Vector3::Cross(positions[1] - positions[0], positions[2] - positions[0]) };
+							positions[fromCorner] = getPosition(to);
+							const Vector3 normalAfter{ Vector3::Cross(positions[1] - positions[0], positions[2] - positions[0]) };
+							if (Vector3::Dot(normalBefore, normalAfter) <= MinCollapseFacing * normalBefore.Magnitude() * normalAfter.Magnitude())
+								return 0;
+						}
+						return nrEdgeTriangles;
+					} };
+
+				// The quadric only orders the collapses, it averages the squared distances of all planes a position gathered
+				// The error is the distance of the new position to the plane of every triangle the old one was on,
+				// added to how far the old one already was, so a flat part can collapse further than a curved one
+				const auto getCollapseError{ [&](uint32_t from, uint32_t to)
+					{
+						const Vector3& target{ getPosition(to) };
+						float distance{};
+						for (uint32_t i{}; i < adjacency.nrTriangles[from]; ++i)
+						{
+							const uint32_t* pPositions{ &positionIndices[adjacency.triangles[adjacency.offsets[from] + i] * 3] };
+							const Vector3& position0{ getPosition(pPositions[0]) };
+							const Vector3 normal{ Vector3::Cross(getPosition(pPositions[1]) - position0, getPosition(pPositions[2]) - position0) };
+							const float doubleArea{ normal.Magnitude() };
+							if (doubleArea > 0.f)
+								distance = std::max(distance, std::abs(Vector3::Dot(normal, target - position0)) / doubleArea);
+						}
+						return positionErrors[from] + distance;
+					} };
+
+				// Only the collapses that can be done count for the cost limit of the pass
+				validCollapses.clear();
+				for (const Collapse& collapse : collapses)
+				{
+					if (validateCollapse(collapse.from, collapse.to) != 0)
+						validCollapses.push_back(collapse);
+				}
+				if (validCollapses.empty())
+					break;
+				const float passLimit{ validCollapses[size_t(float(validCollapses.size() - 1) * SimplifyPassFraction)].cost };
+
+				// A collapse locks the positions around it, the triangles of an unlocked position are still the ones of the adjacency
+				std::fill(isLocked.begin(), isLocked.end(), false);
+				std::iota(remap.begin(), remap.end(), 0);
+				size_t nrTriangles{ simplified.size() / 3 };
+				uint32_t nrCollapses{};
+				for (const Collapse& collapse : validCollapses)
+				{
+					if (nrTriangles * 3 <= targetNrIndices || collapse.cost > passLimit)
+						break;
+
+					const uint32_t from{ collapse.from };
+					const uint32_t to{ collapse.to };
+					if (isLocked[from] || isLocked[to])
+						continue;
+
+					const float collapseError{ getCollapseError(from, to) };
+					if (collapseError > maxError)
+						continue;
+
+					// Validated again for the vertex pairs and the neighbours, nothing around it changed since
+					const uint32_t nrEdgeTriangles{ validateCollapse(from, to) };
+					for (const auto& [vertexIdx, targetIdx] : vertexPairs)
+					{
+						remap[vertexIdx] = targetIdx;
+					}
+					quadrics[to] += quadrics[from];
+					nrTriangles -= nrEdgeTriangles;
+					positionErrors[to] = std::max(positionErrors[to], collapseError);
+					error = std::max(error, collapseError);
+					++nrCollapses;
+
+					isLocked[from] = isLocked[to] = true;
+					for (const uint32_t neighbour : fromNeighbours)
+					{
+						isLocked[neighbour] = true;
+					}
+				}
+
+				if (nrCollapses == 0)
+					break;
+
+				// The triangles on the collapsed edges now use a position twice
+				size_t nrIndices{};
+				for (size_t idx{}; idx < simplified.size(); idx += 3)
+				{
+					const uint32_t triangle[3]{ remap[simplified[idx]], remap[simplified[idx + 1]], remap[simplified[idx + 2]] };
+					const uint32_t position0{ positionIds[triangle[0]] };
+					const uint32_t position1{ positionIds[triangle[1]] };
+					const uint32_t position2{ positionIds[triangle[2]] };
+					if (position0 == position1 || position1 == position2 || position0 == position2)
+						continue;
+
+					std::copy(std::begin(triangle), std::end(triangle), simplified.begin() + nrIndices);
+					nrIndices += 3;
+				}
+				simplified.resize(nrIndices);
+				updatePositionIndices();
+			}
+
+			return simplified;
+		}
+	}
+}
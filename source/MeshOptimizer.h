@@ -0,0 +1,40 @@
+#pragma once
+#include "DataTypes.h"
+
+namespace dae
+{
+	// Load time reordering of indexed triangle lists, the triangles and vertices stay the same
+	// Except for Simplify, which builds a coarser triangle list on the same vertices for the levels of detail
+	namespace MeshOptimizer
+	{
+		// Size of the FIFO post-transform cache the ACMR and the overdraw clusters are measured with
+		constexpr uint32_t FifoCacheSize{ 16 };
+
+		// Average cache miss ratio: transformed vertices per triangle with a FIFO cache, 0.5 is about the best a grid can do, 3 the worst
+		float ComputeACMR(const std::vector<uint32_t>& indices, size_t nrVertices, uint32_t cacheSize = FifoCacheSize);
+
+		// Tom Forsyth's linear-speed vertex cache optimisation, greedily picks the next triangle with the best cached vertices
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t nrVertices);
+
+		// Splits the cache-ordered triangles into clusters where the cache restarts and sorts those so the
+		// outward facing ones on the outside of the mesh come first, they are the most likely to occlude the others
+		void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices);
+
+		// Regroups the triangles into meshlets and puts every meshlet in one run of the index buffer
+		// A meshlet starts at the first triangle left in the current order and grows over the neighbours that add the fewest vertices
+		// and face most like the meshlet, so the normal cones stay narrow enough to cull whole meshlets that face away
+		std::vector<Meshlet> BuildMeshlets(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices);
+		// Cuts the triangles into meshlets in their current order instead, for meshes that are drawn in the order of their triangles
+		std::vector<Meshlet> BuildOrderedMeshlets(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices);
+
+		// Renumbers the vertices in order of first use, so the vertex fetches walk through memory
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		// Collapses edges in order of their quadric error until at most targetNrIndices are left, or no edge can go without moving
+		// a position more than maxError away from the full mesh, tearing a seam, flipping a triangle or pinching the surface
+		// No vertices are added or moved, collapses only reuse them. error is the largest distance a collapsed position ended up from
+		// the planes of the triangles it was on, summed over the collapses that moved it, in the units of the positions
+		std::vector<uint32_t> Simplify(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, size_t targetNrIndices,
+			float maxError, float& error);
+	}
+}
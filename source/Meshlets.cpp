@@ -0,0 +1,90 @@
+#include "pch.h"
+#include "Meshlets.h"
+
+namespace dae
+{
+	namespace
+	{
+		// True when every winding normal, times the sign, points away from the camera
+		// Every point of the bounding sphere has to be within the cone around the axis that is 90 degrees minus the normal cone wide
+		bool IsFacingAway(const Meshlet& meshlet, const Vector3& cameraPosition, float sign)
+		{
+			const Vector3 toCenter{ meshlet.bounds.center - cameraPosition };
+			const float distance{ toCenter.Magnitude() };
+			const float radius{ meshlet.bounds.radius };
+			return sign * Vector3::Dot(toCenter, meshlet.coneAxis) > meshlet.coneCutoff * (distance + radius) + radius;
+		}
+	}
+
+	namespace Meshlets
+	{
+		Meshlet Create(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, uint32_t firstIndex, uint32_t nrIndices)
+		{
+			Meshlet meshlet{ firstIndex, nrIndices };
+			const uint32_t lastIndex{ firstIndex + nrIndices };
+
+			MeshBounds& bounds{ meshlet.bounds };
+			bounds.min = bounds.max = vertices[indices[firstIndex]].position;
+			for (uint32_t idx{ firstIndex }; idx < lastIndex; ++idx)
+			{
+				const Vector3& position{ vertices[indices[idx]].position };
+				bounds.min = Vector3{ std::min(bounds.min.x, position.x), std::min(bounds.min.y, position.y), std::min(bounds.min.z, position.z) };
+				bounds.max = Vector3{ std::max(bounds.max.x, position.x), std::max(bounds.max.y, position.y), std::max(bounds.max.z, position.z) };
+			}
+
+			bounds.center = (bounds.min + bounds.max) * 0.5f;
+			for (uint32_t idx{ firstIndex }; idx < lastIndex; ++idx)
+			{
+				bounds.radius = std::max(bounds.radius, (vertices[indices[idx]].position - bounds.center).Magnitude());
+			}
+
+			// The axis is the average of the face normals, the cutoff comes from the one that is furthest off
+			Vector3 axis{};
+			for (uint32_t idx{ firstIndex }; idx < lastIndex; idx += 3)
+			{
+				axis += GetFaceNormal(vertices, &indices[idx]);
+			}
+
+			meshlet.coneCutoff = 1.f;
+			const float axisLength{ axis.Magnitude() };
+			if (axisLength <= 0.f)
+				return meshlet;
+			meshlet.coneAxis = axis / axisLength;
+
+			float minDot{ 1.f };
+			for (uint32_t idx{ firstIndex }; idx < lastIndex; idx += 3)
+			{
+				const Vector3 normal{ GetFaceNormal(vertices, &indices[idx]) };
+				// Degenerate triangles are never rasterized, they can face any way
+				if (normal.SqrMagnitude() > 0.f)
+					minDot = std::min(minDot, Vector3::Dot(normal, meshlet.coneAxis));
+			}
+
+			// A cone of 90 degrees or more always has a normal that faces the camera
+			if (minDot > 0.f)
+				meshlet.coneCutoff = sqrtf(1.f - minDot * minDot);
+			return meshlet;
+		}
+
+		Vector3 GetFaceNormal(const std::vector<Vertex>& vertices, const uint32_t* pIndices)
+		{
+			const Vector3& position0{ vertices[pIndices[0]].position };
+			const Vector3& position1{ vertices[pIndices[1]].position };
+			const Vector3& position2{ vertices[pIndices[2]].position };
+
+			const Vector3 normal{ Vector3::Cross(position1 - position0, position2 - position0) };
+			const float length{ normal.Magnitude() };
+			return length > 0.f ? normal / length : Vector3{};
+		}
+
+		bool IsBackFacing(const Meshlet& meshlet, const Vector3& cameraPosition)
+		{
+			return IsFacingAway(meshlet, cameraPosition, 1.f);
+		}
+
+		bool IsFrontFacing(const Meshlet& meshlet, const Vector3& cameraPosition)
+		{
+			return IsFacingAway(meshlet, cameraPosition, -1.f);
+		}
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "DataTypes.h"
+
+namespace dae
+{
+	// Clusters of neighbouring triangles that get culled as a whole, before any of their triangles are set up
+	// MeshOptimizer::BuildMeshlets groups the triangles, every meshlet is a run of the index buffer
+	namespace Meshlets
+	{
+		constexpr uint32_t MaxVertices{ 64 };
+		constexpr uint32_t MaxTriangles{ 124 };
+
+		// Bounding box, sphere and normal cone of the triangles in the range
+		Meshlet Create(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, uint32_t firstIndex, uint32_t nrIndices);
+
+		// Unit normal of the winding, Cross(p1 - p0, p2 - p0), it points out of the front face, zero for degenerate triangles
+		Vector3 GetFaceNormal(const std::vector<Vertex>& vertices, const uint32_t* pIndices);
+
+		// Conservative, only true when every triangle of the meshlet faces away from (or towards) the object space camera position
+		bool IsBackFacing(const Meshlet& meshlet, const Vector3& cameraPosition);
+		bool IsFrontFacing(const Meshlet& meshlet, const Vector3& cameraPosition);
+	}
+}
@@ -0,0 +1,446 @@
+#include "pch.h"
+#include "RasterKernels.h"
+
+#include <intrin.h>
+#include <immintrin.h>
+
+namespace dae
+{
+	namespace
+	{
+		// Every kernel evaluates the lanes with the exact same sequence of float operations,
+		// so the SIMD kernels give bit-identical coverage, depth and weights to the scalar reference
+		// The edge functions are stepped per quad by the caller, which makes the result independent of the block size
+		// FixedPoint kernels take the coverage from the integer edge functions, the float ones only give the weights
+		template<int NrLanes, bool FixedPoint>
+		void RasterizeBlockScalar(const TriangleSetup& triangle, RasterBlock& block)
+		{
+			const VertexSetup& vertex0{ triangle.vertices[0] };
+			const VertexSetup& vertex1{ triangle.vertices[1] };
+			const VertexSetup& vertex2{ triangle.vertices[2] };
+
+			block.coverageMask = 0;
+			block.depthMask = 0;
+
+			for (int lane{}; lane < NrLanes; ++lane)
+			{
+				if ((block.laneMask & (1u << lane)) == 0)
+					continue;
+
+				const Vector3& quadWeights{ block.edgeWeights[lane / 4] };
+				const float offsetX{ float(lane & 1) };
+				const float offsetY{ float(RasterBlock::GetLaneY(lane)) };
+
+				const float edgeV0{ quadWeights.x + (triangle.edgeStepX.x * offsetX + triangle.edgeStepY.x * offsetY) };
+				const float edgeV1{ quadWeights.y + (triangle.edgeStepX.y * offsetX + triangle.edgeStepY.y * offsetY) };
+				const float edgeV2{ quadWeights.z + (triangle.edgeStepX.z * offsetX + triangle.edgeStepY.z * offsetY) };
+
+				if constexpr (FixedPoint)
+				{
+					const int64_t* pFixedEdges{ block.fixedEdges[lane / 4] };
+					int64_t fixedEdges[3]{};
+					for (int i{}; i < 3; ++i)
+					{
+						fixedEdges[i] = pFixedEdges[i] + (lane & 1 ? triangle.fixedEdgeStepX[i] : 0) + (RasterBlock::GetLaneY(lane) ? triangle.fixedEdgeStepY[i] : 0);
+					}
+
+					if ((fixedEdges[0] | fixedEdges[1] | fixedEdges[2]) < 0)
+						continue;
+				}
+				else
+				{
+					if (!(edgeV0 > 0.f && edgeV1 > 0.f && edgeV2 > 0.f))
+						continue;
+				}
+
+				block.coverageMask |= 1u << lane;
+
+				const float weightV0{ edgeV0 * triangle.invArea };
+				const float weightV1{ edgeV1 * triangle.invArea };
+				const float weightV2{ edgeV2 * triangle.invArea };
+
+				const float z{ std::min(std::max(vertex0.depth * weightV0 + vertex1.depth * weightV1 + vertex2.depth * weightV2, triangle.minDepth), triangle.maxDepth) };
+
+				if (z > block.depth[lane])
+					continue;
+
+				block.depthMask |= 1u << lane;
+				block.depth[lane] = z;
+
+				const float interpolatedW{ 1.f / (vertex0.invW * weightV0 + vertex1.invW * weightV1 + vertex2.invW * weightV2) };
+
+				block.z[lane] = z;
+				block.interpolatedW[lane] = interpolatedW;
+				block.weightV0[lane] = (weightV0 * vertex0.invW) * interpolatedW;
+				block.weightV1[lane] = (weightV1 * vertex1.invW) * interpolatedW;
+				block.weightV2[lane] = (weightV2 * vertex2.invW) * interpolatedW;
+			}
+		}
+
+		// One 2x2 quad per call
+		template<bool FixedPoint>
+		void RasterizeBlockSSE41(const TriangleSetup& triangle, RasterBlock& block)
+		{
+			const VertexSetup& vertex0{ triangle.vertices[0] };
+			const VertexSetup& vertex1{ triangle.vertices[1] };
+			const VertexSetup& vertex2{ triangle.vertices[2] };
+
+			const __m128i laneBits{ _mm_setr_epi32(1, 2, 4, 8) };
+			const __m128 laneMask{ _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(int(block.laneMask)), laneBits), laneBits)) };
+
+			const __m128 offsetX{ _mm_setr_ps(0.f, 1.f, 0.f, 1.f) };
+			const __m128 offsetY{ _mm_setr_ps(0.f, 0.f, 1.f, 1.f) };
+
+			const __m128 edgeV0{ _mm_add_ps(_mm_set1_ps(block.edgeWeights[0].x),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeStepX.x), offsetX), _mm_mul_ps(_mm_set1_ps(triangle.edgeStepY.x), offsetY))) };
+			const __m128 edgeV1{ _mm_add_ps(_mm_set1_ps(block.edgeWeights[0].y),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeStepX.y), offsetX), _mm_mul_ps(_mm_set1_ps(triangle.edgeStepY.y), offsetY))) };
+			const __m128 edgeV2{ _mm_add_ps(_mm_set1_ps(block.edgeWeights[0].z),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeStepX.z), offsetX), _mm_mul_ps(_mm_set1_ps(triangle.edgeStepY.z), offsetY))) };
+
+			__m128 covered{};
+			if constexpr (FixedPoint)
+			{
+				// Two 64 bit lanes per register, a lane is outside when the sign bit of any of its edges is set
+				__m128i outside01{ _mm_setzero_si128() };
+				__m128i outside23{ _mm_setzero_si128() };
+				for (int i{}; i < 3; ++i)
+				{
+					const __m128i edge01{ _mm_add_epi64(_mm_set1_epi64x(block.fixedEdges[0][i]), _mm_set_epi64x(triangle.fixedEdgeStepX[i], 0)) };
+					const __m128i edge23{ _mm_add_epi64(edge01, _mm_set1_epi64x(triangle.fixedEdgeStepY[i])) };
+					outside01 = _mm_or_si128(outside01, edge01);
+					outside23 = _mm_or_si128(outside23, edge23);
+				}
+
+				const int outsideMask{ _mm_movemask_pd(_mm_castsi128_pd(outside01)) | (_mm_movemask_pd(_mm_castsi128_pd(outside23)) << 2) };
+				const __m128i insideBits{ _mm_and_si128(_mm_set1_epi32(~outsideMask), laneBits) };
+				covered = _mm_and_ps(laneMask, _mm_castsi128_ps(_mm_cmpeq_epi32(insideBits, laneBits)));
+			}
+			else
+			{
+				const __m128 zero{ _mm_setzero_ps() };
+				covered = _mm_and_ps(laneMask,
+					_mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(edgeV0, zero), _mm_cmpgt_ps(edgeV1, zero)), _mm_cmpgt_ps(edgeV2, zero)));
+			}
+
+			block.coverageMask = uint32_t(_mm_movemask_ps(covered));
+			block.depthMask = 0;
+			if (block.coverageMask == 0)
+				return;
+
+			const __m128 invArea{ _mm_set1_ps(triangle.invArea) };
+			const __m128 weightV0{ _mm_mul_ps(edgeV0, invArea) };
+			const __m128 weightV1{ _mm_mul_ps(edgeV1, invArea) };
+			const __m128 weightV2{ _mm_mul_ps(edgeV2, invArea) };
+
+			const __m128 interpolatedZ{ _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_set1_ps(vertex0.depth), weightV0),
+				_mm_mul_ps(_mm_set1_ps(vertex1.depth), weightV1)),
+				_mm_mul_ps(_mm_set1_ps(vertex2.depth), weightV2)) };
+			const __m128 z{ _mm_min_ps(_mm_max_ps(interpolatedZ, _mm_set1_ps(triangle.minDepth)), _mm_set1_ps(triangle.maxDepth)) };
+
+			const __m128 depth{ _mm_load_ps(block.depth) };
+			const __m128 passed{ _mm_and_ps(covered, _mm_cmpngt_ps(z, depth)) };
+
+			block.depthMask = uint32_t(_mm_movemask_ps(passed));
+			if (block.depthMask == 0)
+				return;
+
+			_mm_store_ps(block.depth, _mm_blendv_ps(depth, z, passed));
+
+			const __m128 invW0{ _mm_set1_ps(vertex0.invW) };
+			const __m128 invW1{ _mm_set1_ps(vertex1.invW) };
+			const __m128 invW2{ _mm_set1_ps(vertex2.invW) };
+			const __m128 interpolatedW{ _mm_div_ps(_mm_set1_ps(1.f), _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(invW0, weightV0), _mm_mul_ps(invW1, weightV1)), _mm_mul_ps(invW2, weightV2))) };
+
+			_mm_store_ps(block.z, z);
+			_mm_store_ps(block.interpolatedW, interpolatedW);
+			_mm_store_ps(block.weightV0, _mm_mul_ps(_mm_mul_ps(weightV0, invW0), interpolatedW));
+			_mm_store_ps(block.weightV1, _mm_mul_ps(_mm_mul_ps(weightV1, invW1), interpolatedW));
+			_mm_store_ps(block.weightV2, _mm_mul_ps(_mm_mul_ps(weightV2, invW2), interpolatedW));
+		}
+
+		// Two 2x2 quads next to each other per call
+		template<bool FixedPoint>
+		void RasterizeBlockAVX2(const TriangleSetup& triangle, RasterBlock& block)
+		{
+			const VertexSetup& vertex0{ triangle.vertices[0] };
+			const VertexSetup& vertex1{ triangle.vertices[1] };
+			const VertexSetup& vertex2{ triangle.vertices[2] };
+
+			const __m256i laneBits{ _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128) };
+			const __m256 laneMask{ _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(int(block.laneMask)), laneBits), laneBits)) };
+
+			const __m256 offsetX{ _mm256_setr_ps(0.f, 1.f, 0.f, 1.f, 0.f, 1.f, 0.f, 1.f) };
+			const __m256 offsetY{ _mm256_setr_ps(0.f, 0.f, 1.f, 1.f, 0.f, 0.f, 1.f, 1.f) };
+
+			const Vector3& quad0{ block.edgeWeights[0] };
+			const Vector3& quad1{ block.edgeWeights[1] };
+			const __m256 edgeV0{ _mm256_add_ps(_mm256_setr_ps(quad0.x, quad0.x, quad0.x, quad0.x, quad1.x, quad1.x, quad1.x, quad1.x),
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.edgeStepX.x), offsetX), _mm256_mul_ps(_mm256_set1_ps(triangle.edgeStepY.x), offsetY))) };
+			const __m256 edgeV1{ _mm256_add_ps(_mm256_setr_ps(quad0.y, quad0.y, quad0.y, quad0.y, quad1.y, quad1.y, quad1.y, quad1.y),
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.edgeStepX.y), offsetX), _mm256_mul_ps(_mm256_set1_ps(triangle.edgeStepY.y), offsetY))) };
+			const __m256 edgeV2{ _mm256_add_ps(_mm256_setr_ps(quad0.z, quad0.z, quad0.z, quad0.z, quad1.z, quad1.z, quad1.z, quad1.z),
+				_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.edgeStepX.z), offsetX), _mm256_mul_ps(_mm256_set1_ps(triangle.edgeStepY.z), offsetY))) };
+
+			__m256 covered{};
+			if constexpr (FixedPoint)
+			{
+				// Four 64 bit lanes per register, one register per quad
+				int outsideMask{};
+				for (int quad{}; quad < 2; ++quad)
+				{
+					__m256i outside{ _mm256_setzero_si256() };
+					for (int i{}; i < 3; ++i)
+					{
+						const int64_t stepX{ triangle.fixedEdgeStepX[i] };
+						const int64_t stepY{ triangle.fixedEdgeStepY[i] };
+						const __m256i edge{ _mm256_add_epi64(_mm256_set1_epi64x(block.fixedEdges[quad][i]), _mm256_setr_epi64x(0, stepX, stepY, stepX + stepY)) };
+						outside = _mm256_or_si256(outside, edge);
+					}
+					outsideMask |= _mm256_movemask_pd(_mm256_castsi256_pd(outside)) << (quad * 4);
+				}
+
+				const __m256i insideBits{ _mm256_and_si256(_mm256_set1_epi32(~outsideMask), laneBits) };
+				covered = _mm256_and_ps(laneMask, _mm256_castsi256_ps(_mm256_cmpeq_epi32(insideBits, laneBits)));
+			}
+			else
+			{
+				const __m256 zero{ _mm256_setzero_ps() };
+				covered = _mm256_and_ps(laneMask, _mm256_and_ps(_mm256_and_ps(
+					_mm256_cmp_ps(edgeV0, zero, _CMP_GT_OQ), _mm256_cmp_ps(edgeV1, zero, _CMP_GT_OQ)), _mm256_cmp_ps(edgeV2, zero, _CMP_GT_OQ)));
+			}
+
+			block.coverageMask = uint32_t(_mm256_movemask_ps(covered));
+			block.depthMask = 0;
+			if (block.coverageMask == 0)
+				return;
+
+			const __m256 invArea{ _mm256_set1_ps(triangle.invArea) };
+			const __m256 weightV0{ _mm256_mul_ps(edgeV0, invArea) };
+			const __m256 weightV1{ _mm256_mul_ps(edgeV1, invArea) };
+			const __m256 weightV2{ _mm256_mul_ps(edgeV2, invArea) };
+
+			const __m256 interpolatedZ{ _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(_mm256_set1_ps(vertex0.depth), weightV0),
+				_mm256_mul_ps(_mm256_set1_ps(vertex1.depth), weightV1)),
+				_mm256_mul_ps(_mm256_set1_ps(vertex2.depth), weightV2)) };
+			const __m256 z{ _mm256_min_ps(_mm256_max_ps(interpolatedZ, _mm256_set1_ps(triangle.minDepth)), _mm256_set1_ps(triangle.maxDepth)) };
+
+			const __m256 depth{ _mm256_load_ps(block.depth) };
+			const __m256 passed{ _mm256_and_ps(covered, _mm256_cmp_ps(z, depth, _CMP_NGT_UQ)) };
+
+			block.depthMask = uint32_t(_mm256_movemask_ps(passed));
+			if (block.depthMask == 0)
+				return;
+
+			_mm256_store_ps(block.depth, _mm256_blendv_ps(depth, z, passed));
+
+			const __m256 invW0{ _mm256_set1_ps(vertex0.invW) };
+			const __m256 invW1{ _mm256_set1_ps(vertex1.invW) };
+			const __m256 invW2{ _mm256_set1_ps(vertex2.invW) };
+			const __m256 interpolatedW{ _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(invW0, weightV0), _mm256_mul_ps(invW1, weightV1)), _mm256_mul_ps(invW2, weightV2))) };
+
+			_mm256_store_ps(block.z, z);
+			_mm256_store_ps(block.interpolatedW, interpolatedW);
+			_mm256_store_ps(block.weightV0, _mm256_mul_ps(_mm256_mul_ps(weightV0, invW0), interpolatedW));
+			_mm256_store_ps(block.weightV1, _mm256_mul_ps(_mm256_mul_ps(weightV1, invW1), interpolatedW));
+			_mm256_store_ps(block.weightV2, _mm256_mul_ps(_mm256_mul_ps(weightV2, invW2), interpolatedW));
+		}
+
+		bool DetectAVX2()
+		{
+			int cpuInfo[4]{};
+			__cpuid(cpuInfo, 0);
+			if (cpuInfo[0] < 7)
+				return false;
+
+			// The OS has to save the YMM registers as well
+			__cpuid(cpuInfo, 1);
+			const bool hasOSXSave{ (cpuInfo[2] & (1 << 27)) != 0 };
+			const bool hasAVX{ (cpuInfo[2] & (1 << 28)) != 0 };
+			if (!hasOSXSave || !hasAVX || (_xgetbv(0) & 0x6) != 0x6)
+				return false;
+
+			__cpuidex(cpuInfo, 7, 0);
+			return (cpuInfo[1] & (1 << 5)) != 0;
+		}
+
+		bool DetectSSE41()
+		{
+			int cpuInfo[4]{};
+			__cpuid(cpuInfo, 1);
+			return (cpuInfo[2] & (1 << 19)) != 0;
+		}
+	}
+
+	namespace RasterKernels
+	{
+		bool IsSupported(RasterKernelType type)
+		{
+			static const bool hasSSE41{ DetectSSE41() };
+			static const bool hasAVX2{ DetectAVX2() };
+
+			switch (type)
+			{
+			case RasterKernelType::SSE41:
+				return hasSSE41;
+			case RasterKernelType::AVX2:
+				return hasAVX2;
+			default:
+				return true;
+			}
+		}
+
+		RasterKernelType GetBestSupportedType()
+		{
+			if (IsSupported(RasterKernelType::AVX2))
+				return RasterKernelType::AVX2;
+			if (IsSupported(RasterKernelType::SSE41))
+				return RasterKernelType::SSE41;
+			return RasterKernelType::Scalar;
+		}
+
+		const char* GetName(RasterKernelType type)
+		{
+			switch (type)
+			{
+			case RasterKernelType::SSE41:
+				return "SSE4.1";
+			case RasterKernelType::AVX2:
+				return "AVX2";
+			default:
+				return "Scalar";
+			}
+		}
+
+		RasterKernel GetKernel(RasterKernelType type, bool isFixedPoint)
+		{
+			switch (type)
+			{
+			case RasterKernelType::SSE41:
+				return RasterKernel{ type, 4, isFixedPoint, isFixedPoint ? &RasterizeBlockSSE41<true> : &RasterizeBlockSSE41<false> };
+			case RasterKernelType::AVX2:
+				return RasterKernel{ type, 8, isFixedPoint, isFixedPoint ? &RasterizeBlockAVX2<true> : &RasterizeBlockAVX2<false> };
+			default:
+				return RasterKernel{ type, 4, isFixedPoint, isFixedPoint ? &RasterizeBlockScalar<4, true> : &RasterizeBlockScalar<4, false> };
+			}
+		}
+
+		RasterKernel GetReferenceKernel(const RasterKernel& kernel)
+		{
+			if (kernel.nrLanes == 8)
+				return RasterKernel{ RasterKernelType::Scalar, 8, kernel.isFixedPoint, kernel.isFixedPoint ? &RasterizeBlockScalar<8, true> : &RasterizeBlockScalar<8, false> };
+
+			return RasterKernel{ RasterKernelType::Scalar, 4, kernel.isFixedPoint, kernel.isFixedPoint ? &RasterizeBlockScalar<4, true> : &RasterizeBlockScalar<4, false> };
+		}
+
+		bool SetupEdges(TriangleSetup& triangle, const Vector2 (&positions)[3], float windingSign, const ScissorRect& scissor)
+		{
+			const Vector2& v0{ positions[0] };
+			const Vector2& v1{ positions[1] };
+			const Vector2& v2{ positions[2] };
+
+			const float areaTriangle{ fabs(Vector2::Cross(v1 - v0, v2 - v0)) };
+
+			if (areaTriangle <= 0.01f)
+			{
+				return false;
+			}
+
+			// create bounding box for triangle
+			const int bottom = std::min(int(std::min(v0.y, v1.y)), int(v2.y));
+			const int top = std::max(int(std::max(v0.y, v1.y)), int(v2.y)) + 1;
+
+			const int left = std::min(int(std::min(v0.x, v1.x)), int(v2.x));
+			const int right = std::max(int(std::max(v0.x, v1.x)), int(v2.x)) + 1;
+
+			constexpr int offSet{ 1 };
+
+			// The guard band keeps the bounding box finite, the scissor clamps it to the pixels that get rasterized
+			triangle.left = std::max(left - offSet, scissor.left);
+			triangle.right = std::min(right + offSet, scissor.right);
+			triangle.bottom = std::max(bottom - offSet, scissor.bottom);
+			triangle.top = std::min(top + offSet, scissor.top);
+
+			if (triangle.left >= triangle.right || triangle.bottom >= triangle.top)
+				return false;
+
+			// Edge functions, evaluated once at the first pixel, every other pixel steps from there
+			const Vector2 edge01{ v1 - v0 };
+			const Vector2 edge12{ v2 - v1 };
+			const Vector2 edge20{ v0 - v2 };
+
+			const Vector2 firstPixel{ float(triangle.left), float(triangle.bottom) };
+			triangle.edgeStart = Vector3{
+				Vector2::Cross(edge12, firstPixel - v1),
+				Vector2::Cross(edge20, firstPixel - v2),
+				Vector2::Cross(edge01, firstPixel - v0) } * windingSign;
+			triangle.edgeStepX = Vector3{ -edge12.y, -edge20.y, -edge01.y } * windingSign;
+			triangle.edgeStepY = Vector3{ edge12.x, edge20.x, edge01.x } * windingSign;
+			triangle.invArea = 1.f / areaTriangle;
+			return true;
+		}
+
+		bool SetupFixedPointEdges(TriangleSetup& triangle, const Vector2 (&positions)[3], float windingSign, const ScissorRect& scissor)
+		{
+			// Snap to the subpixel grid, every calculation after this is exact
+			int64_t fixedX[3]{};
+			int64_t fixedY[3]{};
+			for (int i{}; i < 3; ++i)
+			{
+				fixedX[i] = std::llround(positions[i].x * FixedPointScale);
+				fixedY[i] = std::llround(positions[i].y * FixedPointScale);
+			}
+
+			// Snapping can collapse a tiny triangle or flip its winding, those cover no pixels
+			const int64_t area{ (fixedX[1] - fixedX[0]) * (fixedY[2] - fixedY[0]) - (fixedY[1] - fixedY[0]) * (fixedX[2] - fixedX[0]) };
+			if (area == 0 || (area > 0) != (windingSign > 0.f))
+				return false;
+
+			// Pixels are sampled on integer coordinates, so the bounding box is exact and needs no padding
+			const int64_t minX{ std::min(std::min(fixedX[0], fixedX[1]), fixedX[2]) };
+			const int64_t maxX{ std::max(std::max(fixedX[0], fixedX[1]), fixedX[2]) };
+			const int64_t minY{ std::min(std::min(fixedY[0], fixedY[1]), fixedY[2]) };
+			const int64_t maxY{ std::max(std::max(fixedY[0], fixedY[1]), fixedY[2]) };
+
+			triangle.left = std::max(int((minX + FixedPointScale - 1) >> FixedPointShift), scissor.left);
+			triangle.right = std::min(int(maxX >> FixedPointShift) + 1, scissor.right);
+			triangle.bottom = std::max(int((minY + FixedPointScale - 1) >> FixedPointShift), scissor.bottom);
+			triangle.top = std::min(int(maxY >> FixedPointShift) + 1, scissor.top);
+
+			if (triangle.left >= triangle.right || triangle.bottom >= triangle.top)
+				return false;
+
+			const int64_t sign{ windingSign < 0.f ? -1 : 1 };
+			const int64_t firstX{ int64_t(triangle.left) * FixedPointScale };
+			const int64_t firstY{ int64_t(triangle.bottom) * FixedPointScale };
+
+			// Edge i is the one opposite to vertex i, like the float edge functions
+			for (int i{}; i < 3; ++i)
+			{
+				const int a{ (i + 1) % 3 };
+				const int b{ (i + 2) % 3 };
+				const int64_t edgeX{ (fixedX[b] - fixedX[a]) * sign };
+				const int64_t edgeY{ (fixedY[b] - fixedY[a]) * sign };
+
+				// Top-left rule: a pixel exactly on an edge belongs to the triangle for which it is a top or left edge,
+				// so every pixel on an edge shared by two triangles is rasterized exactly once
+				const bool isTopLeft{ edgeY < 0 || (edgeY == 0 && edgeX > 0) };
+
+				triangle.fixedEdgeStart[i] = edgeX * (firstY - fixedY[a]) - edgeY * (firstX - fixedX[a]) - (isTopLeft ? 0 : 1);
+				triangle.fixedEdgeStepX[i] = -edgeY * FixedPointScale;
+				triangle.fixedEdgeStepY[i] = edgeX * FixedPointScale;
+			}
+
+			// The weights come from the float versions, in the same subpixel units
+			triangle.edgeStart = Vector3{ float(triangle.fixedEdgeStart[0]), float(triangle.fixedEdgeStart[1]), float(triangle.fixedEdgeStart[2]) };
+			triangle.edgeStepX = Vector3{ float(triangle.fixedEdgeStepX[0]), float(triangle.fixedEdgeStepX[1]), float(triangle.fixedEdgeStepX[2]) };
+			triangle.edgeStepY = Vector3{ float(triangle.fixedEdgeStepY[0]), float(triangle.fixedEdgeStepY[1]), float(triangle.fixedEdgeStepY[2]) };
+			triangle.invArea = 1.f / float(std::abs(area));
+			return true;
+		}
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "DataTypes.h"
+
+namespace dae
+{
+	// A block of pixels that is rasterized at once, made of 2x2 quads next to each other
+	// Lanes are ordered quad by quad and row-major inside a quad: lane = quad * 4 + y * 2 + x
+	struct RasterBlock final
+	{
+		static constexpr int MaxQuads{ 2 };
+		static constexpr int MaxLanes{ MaxQuads * 4 };
+
+		static int GetLaneX(int lane) { return (lane / 4) * 2 + (lane & 1); }
+		static int GetLaneY(int lane) { return (lane >> 1) & 1; }
+
+		// In
+		Vector3 edgeWeights[MaxQuads]{};	// edge functions at the first pixel of every quad
+		int64_t fixedEdges[MaxQuads][3]{};	// same, in fixed point for the fixed point kernels
+		uint32_t laneMask{};		// lanes inside the bounding box
+		alignas(32) float depth[MaxLanes]{};	// depth buffer values, the lanes that pass the depth test get overwritten
+
+		// Out
+		uint32_t coverageMask{};	// lanes inside the triangle
+		uint32_t depthMask{};		// covered lanes that passed the depth test
+		alignas(32) float z[MaxLanes]{};
+		alignas(32) float interpolatedW[MaxLanes]{};
+		alignas(32) float weightV0[MaxLanes]{};	// perspective correct barycentrics
+		alignas(32) float weightV1[MaxLanes]{};
+		alignas(32) float weightV2[MaxLanes]{};
+	};
+
+	enum class RasterKernelType
+	{
+		Scalar = 0,
+		SSE41 = 1,
+		AVX2 = 2
+	};
+
+	// Pixels that get rasterized, [left, right[ x [bottom, top[
+	struct ScissorRect final
+	{
+		int left{};
+		int right{};
+		int bottom{};
+		int top{};
+	};
+
+	struct RasterKernel final
+	{
+		RasterKernelType type{ RasterKernelType::Scalar };
+		int nrLanes{ 4 };
+		bool isFixedPoint{ false };
+		void(*pRasterizeBlock)(const TriangleSetup& triangle, RasterBlock& block) { nullptr };
+	};
+
+	namespace RasterKernels
+	{
+		bool IsSupported(RasterKernelType type);
+		RasterKernelType GetBestSupportedType();
+		const char* GetName(RasterKernelType type);
+
+		RasterKernel GetKernel(RasterKernelType type, bool isFixedPoint);
+		// Scalar kernel with the same block size, all kernels produce bit-identical results
+		RasterKernel GetReferenceKernel(const RasterKernel& kernel);
+
+		// Vertices are snapped to 1/256th of a pixel by the fixed point kernels
+		constexpr int FixedPointShift{ 8 };
+		constexpr int64_t FixedPointScale{ 1 << FixedPointShift };
+
+		// Edge functions and bounding box of a triangle in screen space, the bounding box is clamped to the scissor
+		// The edges of back faces are flipped with windingSign, so the inside of every triangle is positive
+		// False when the triangle covers no pixels
+		bool SetupEdges(TriangleSetup& triangle, const Vector2 (&positions)[3], float windingSign, const ScissorRect& scissor);
+		bool SetupFixedPointEdges(TriangleSetup& triangle, const Vector2 (&positions)[3], float windingSign, const ScissorRect& scissor);
+	}
+}
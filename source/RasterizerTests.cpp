@@ -0,0 +1,376 @@
+#include "pch.h"
+#include "Tests.h"
+#include "Renderer.h"
+#include <random>
+
+namespace dae
+{
+	namespace
+	{
+		struct TestTriangle final
+		{
+			Vector2 positions[3]{};
+			float depths[3]{};
+			float w[3]{ 1.f, 1.f, 1.f };
+		};
+
+		struct TestCase final
+		{
+			const char* pName;
+			std::vector<TestTriangle> triangles;
+		};
+
+		constexpr ScissorRect TestScissor{ 0, 640, 0, 480 };
+
+		// Adds the triangle with both windings, the back face takes the other branch of the edge setup
+		void AddTriangle(std::vector<TestTriangle>& triangles, const Vector2& v0, const Vector2& v1, const Vector2& v2, std::mt19937& random)
+		{
+			std::uniform_real_distribution<float> depthDistribution{ 0.1f, 0.9f };
+			std::uniform_real_distribution<float> wDistribution{ 0.5f, 5.f };
+
+			TestTriangle triangle{ { v0, v1, v2 } };
+			for (int i{}; i < 3; ++i)
+			{
+				triangle.depths[i] = depthDistribution(random);
+				triangle.w[i] = wDistribution(random);
+			}
+			triangles.push_back(triangle);
+
+			std::swap(triangle.positions[1], triangle.positions[2]);
+			std::swap(triangle.depths[1], triangle.depths[2]);
+			std::swap(triangle.w[1], triangle.w[2]);
+			triangles.push_back(triangle);
+		}
+
+		std::vector<TestCase> CreateTestCases()
+		{
+			std::mt19937 random{ 42 };
+			std::vector<TestCase> testCases{};
+
+			// Grids of quads split in two, the vertices are shared so every inner edge is shared exactly:
+			// one on the pixel grid, where the edges run through the samples, and one with jittered corners
+			// A fan around a vertex that lies on a sample closes the set
+			{
+				TestCase testCase{ "shared edges" };
+				std::uniform_real_distribution<float> jitterDistribution{ -2.f, 2.f };
+				for (const bool isJittered : { false, true })
+				{
+					constexpr int nrCells{ 8 };
+					Vector2 corners[nrCells + 1][nrCells + 1]{};
+					for (int y{}; y <= nrCells; ++y)
+					{
+						for (int x{}; x <= nrCells; ++x)
+						{
+							corners[y][x] = Vector2{ 20.f + x * 8.f, 20.f + y * 8.f + (isJittered ? 100.f : 0.f) };
+							if (isJittered)
+								corners[y][x] += Vector2{ jitterDistribution(random), jitterDistribution(random) };
+						}
+					}
+
+					for (int y{}; y < nrCells; ++y)
+					{
+						for (int x{}; x < nrCells; ++x)
+						{
+							// Alternating diagonals give shared edges in both diagonal directions
+							if ((x + y) % 2 == 0)
+							{
+								AddTriangle(testCase.triangles, corners[y][x], corners[y][x + 1], corners[y + 1][x + 1], random);
+								AddTriangle(testCase.triangles, corners[y][x], corners[y + 1][x + 1], corners[y + 1][x], random);
+							}
+							else
+							{
+								AddTriangle(testCase.triangles, corners[y][x], corners[y][x + 1], corners[y + 1][x], random);
+								AddTriangle(testCase.triangles, corners[y][x + 1], corners[y + 1][x + 1], corners[y + 1][x], random);
+							}
+						}
+					}
+				}
+
+				constexpr int nrFanTriangles{ 16 };
+				const Vector2 center{ 320.f, 240.f };
+				for (int i{}; i < nrFanTriangles; ++i)
+				{
+					const float angle0{ i * PI_2 / nrFanTriangles };
+					const float angle1{ (i + 1) * PI_2 / nrFanTriangles };
+					AddTriangle(testCase.triangles, center,
+						center + Vector2{ 40.f * cosf(angle0), 40.f * sinf(angle0) },
+						center + Vector2{ 40.f * cosf(angle1), 40.f * sinf(angle1) }, random);
+				}
+				testCases.push_back(std::move(testCase));
+			}
+
+			// Smaller than a pixel, both around a sample and exactly on one, down to what snaps to nothing
+			{
+				TestCase testCase{ "tiny triangles" };
+				for (const float size : { 1.5f, 1.f, 0.5f, 0.25f, 0.125f, 0.01f })
+				{
+					AddTriangle(testCase.triangles, Vector2{ 10.f, 10.f }, Vector2{ 10.f + size, 10.f }, Vector2{ 10.f, 10.f + size }, random);
+					AddTriangle(testCase.triangles, Vector2{ 20.f - size, 20.f }, Vector2{ 20.f + size, 20.f - size }, Vector2{ 20.f, 20.f + size }, random);
+				}
+
+				std::uniform_real_distribution<float> positionDistribution{ 0.f, 60.f };
+				std::uniform_real_distribution<float> sizeDistribution{ 0.f, 1.5f };
+				for (int i{}; i < 500; ++i)
+				{
+					const Vector2 v0{ positionDistribution(random), positionDistribution(random) };
+					AddTriangle(testCase.triangles, v0,
+						v0 + Vector2{ sizeDistribution(random), sizeDistribution(random) - 0.75f },
+						v0 + Vector2{ sizeDistribution(random) - 0.75f, sizeDistribution(random) }, random);
+				}
+				testCases.push_back(std::move(testCase));
+			}
+
+			// Long and thin across the screen: along the pixel rows and columns, where the edges run through the samples, and diagonal
+			{
+				TestCase testCase{ "sliver triangles" };
+				for (const float width : { 0.5f, 0.1f, 0.02f })
+				{
+					AddTriangle(testCase.triangles, Vector2{ 5.f, 50.f }, Vector2{ 630.f, 50.f }, Vector2{ 630.f, 50.f + width }, random);
+					AddTriangle(testCase.triangles, Vector2{ 5.f, 60.3f }, Vector2{ 630.f, 61.7f }, Vector2{ 630.f, 61.7f + width }, random);
+					AddTriangle(testCase.triangles, Vector2{ 100.f, 5.f }, Vector2{ 100.f, 470.f }, Vector2{ 100.f + width, 470.f }, random);
+					AddTriangle(testCase.triangles, Vector2{ 5.f, 5.f }, Vector2{ 470.f, 470.f }, Vector2{ 470.f + width, 470.f }, random);
+					AddTriangle(testCase.triangles, Vector2{ 630.f, 7.5f }, Vector2{ 8.25f, 400.f }, Vector2{ 8.25f, 400.f - width }, random);
+				}
+				testCases.push_back(std::move(testCase));
+			}
+
+			// Anything else, partly outside of the scissor
+			{
+				TestCase testCase{ "random triangles" };
+				std::uniform_real_distribution<float> positionXDistribution{ -20.f, 660.f };
+				std::uniform_real_distribution<float> positionYDistribution{ -20.f, 500.f };
+				std::uniform_real_distribution<float> offsetDistribution{ -40.f, 40.f };
+				for (int i{}; i < 1000; ++i)
+				{
+					const Vector2 v0{ positionXDistribution(random), positionYDistribution(random) };
+					AddTriangle(testCase.triangles, v0,
+						v0 + Vector2{ offsetDistribution(random), offsetDistribution(random) },
+						v0 + Vector2{ offsetDistribution(random), offsetDistribution(random) }, random);
+				}
+				testCases.push_back(std::move(testCase));
+			}
+
+			return testCases;
+		}
+
+		// Like SetupTriangle of the renderer, false when the triangle covers no pixels
+		bool SetupTriangle(const TestTriangle& testTriangle, bool isFixedPoint, TriangleSetup& triangle)
+		{
+			const Vector2 (&positions)[3]{ testTriangle.positions };
+			const float windingSign{ Vector2::Cross(positions[1] - positions[0], positions[2] - positions[0]) > 0.f ? 1.f : -1.f };
+
+			const bool isCovering{ isFixedPoint
+				? RasterKernels::SetupFixedPointEdges(triangle, positions, windingSign, TestScissor)
+				: RasterKernels::SetupEdges(triangle, positions, windingSign, TestScissor) };
+			if (!isCovering)
+				return false;
+
+			for (int i{}; i < 3; ++i)
+			{
+				triangle.vertices[i].depth = testTriangle.depths[i];
+				triangle.vertices[i].invW = 1.f / testTriangle.w[i];
+			}
+			triangle.minDepth = std::min(std::min(testTriangle.depths[0], testTriangle.depths[1]), testTriangle.depths[2]);
+			triangle.maxDepth = std::max(std::max(testTriangle.depths[0], testTriangle.depths[1]), testTriangle.depths[2]);
+			return true;
+		}
+
+		// Rasterizes the bounding box block by block like a tile of the renderer, with the kernel and with the scalar reference
+		// The depth buffer holds a pattern of values, so the depth test both passes and fails inside of every triangle
+		uint64_t CountMismatchedBlocks(const RasterKernel& kernel, const TriangleSetup& triangle, uint64_t& nrBlocks)
+		{
+			const RasterKernel referenceKernel{ RasterKernels::GetReferenceKernel(kernel) };
+			const int blockWidth{ kernel.nrLanes / 2 };
+			const int nrQuads{ kernel.nrLanes / 4 };
+			constexpr float depthPattern[]{ 0.3f, 0.5f, 0.7f, FLT_MAX };
+
+			uint64_t nrMismatchedBlocks{};
+			for (int blockY{ triangle.bottom & ~1 }; blockY < triangle.top; blockY += 2)
+			{
+				for (int blockX{ triangle.left & ~1 }; blockX < triangle.right; blockX += blockWidth)
+				{
+					RasterBlock block{};
+					for (int quad{}; quad < nrQuads; ++quad)
+					{
+						const int offsetX{ blockX + quad * 2 - triangle.left };
+						const int offsetY{ blockY - triangle.bottom };
+						for (int i{}; i < 3; ++i)
+						{
+							block.fixedEdges[quad][i] = triangle.fixedEdgeStart[i] + triangle.fixedEdgeStepX[i] * offsetX + triangle.fixedEdgeStepY[i] * offsetY;
+						}
+
+						if (kernel.isFixedPoint)
+							block.edgeWeights[quad] = Vector3{ float(block.fixedEdges[quad][0]), float(block.fixedEdges[quad][1]), float(block.fixedEdges[quad][2]) };
+						else
+							block.edgeWeights[quad] = triangle.edgeStart + triangle.edgeStepX * float(offsetX) + triangle.edgeStepY * float(offsetY);
+					}
+
+					for (int lane{}; lane < kernel.nrLanes; ++lane)
+					{
+						const int px{ blockX + RasterBlock::GetLaneX(lane) };
+						const int py{ blockY + RasterBlock::GetLaneY(lane) };
+						if (px < triangle.left || px >= triangle.right || py < triangle.bottom || py >= triangle.top)
+							continue;
+
+						block.laneMask |= 1u << lane;
+						block.depth[lane] = depthPattern[(px + 2 * py) % std::size(depthPattern)];
+					}
+
+					if (block.laneMask == 0)
+						continue;
+
+					RasterBlock referenceBlock{ block };
+					referenceKernel.pRasterizeBlock(triangle, referenceBlock);
+					kernel.pRasterizeBlock(triangle, block);
+
+					++nrBlocks;
+					if (referenceBlock.coverageMask != block.coverageMask || referenceBlock.depthMask != block.depthMask)
+						++nrMismatchedBlocks;
+				}
+			}
+			return nrMismatchedBlocks;
+		}
+
+		std::vector<RasterKernel> GetSupportedKernels()
+		{
+			std::vector<RasterKernel> kernels{};
+			for (const RasterKernelType type : { RasterKernelType::Scalar, RasterKernelType::SSE41, RasterKernelType::AVX2 })
+			{
+				if (!RasterKernels::IsSupported(type))
+				{
+					std::cout << RasterKernels::GetName(type) << " is not supported on this CPU, skipped\n";
+					continue;
+				}
+
+				kernels.push_back(RasterKernels::GetKernel(type, true));
+				kernels.push_back(RasterKernels::GetKernel(type, false));
+			}
+			return kernels;
+		}
+
+		const char* GetModeName(const RasterKernel& kernel)
+		{
+			return kernel.isFixedPoint ? "fixed point" : "float";
+		}
+
+		// The vehicle from the start view, closer, from the side and through its front so triangles get clipped at the near plane
+		const Vector3 VehicleCameraOrigins[]{ { 0.f, 0.f, 0.f }, { 0.f, 1.f, 25.f }, { -6.f, 3.f, 35.f }, { 0.f, 1.f, 45.f } };
+	}
+
+	bool Tests::RunRasterKernels(SDL_Window* pWindow)
+	{
+		bool hasPassed{ true };
+		const std::vector<RasterKernel> kernels{ GetSupportedKernels() };
+
+		const std::vector<TestCase> testCases{ CreateTestCases() };
+		for (const RasterKernel& kernel : kernels)
+		{
+			for (const TestCase& testCase : testCases)
+			{
+				uint64_t nrBlocks{};
+				uint64_t nrMismatchedBlocks{};
+				for (const TestTriangle& testTriangle : testCase.triangles)
+				{
+					TriangleSetup triangle{};
+					if (SetupTriangle(testTriangle, kernel.isFixedPoint, triangle))
+						nrMismatchedBlocks += CountMismatchedBlocks(kernel, triangle, nrBlocks);
+				}
+
+				std::cout << RasterKernels::GetName(kernel.type) << ' ' << GetModeName(kernel) << ", " << testCase.pName << ": "
+					<< nrMismatchedBlocks << " of " << nrBlocks << " blocks differ from the scalar reference\n";
+				if (nrMismatchedBlocks > 0 || nrBlocks == 0)
+					hasPassed = false;
+			}
+		}
+
+		// The renderer validates every block it rasterizes against the scalar reference
+		Renderer renderer{ pWindow };
+		renderer.ToggleDirectX();
+		renderer.ToggleRasterizerValidation();
+		Timer timer{};
+
+		for (const RasterKernel& kernel : kernels)
+		{
+			renderer.SetKernels(kernel.type, kernel.isFixedPoint);
+
+			uint64_t nrBlocks{};
+			uint64_t nrMismatchedBlocks{};
+			for (const Vector3& cameraOrigin : VehicleCameraOrigins)
+			{
+				renderer.SetCameraOrigin(cameraOrigin);
+				if (!RenderFrames(renderer, timer, 1))
+					return false;
+
+				nrBlocks += renderer.GetStatistics().nrValidatedBlocks;
+				nrMismatchedBlocks += renderer.GetStatistics().nrMismatchedBlocks;
+			}
+
+			std::cout << RasterKernels::GetName(kernel.type) << ' ' << GetModeName(kernel) << ", vehicle frames: "
+				<< nrMismatchedBlocks << " of " << nrBlocks << " blocks differ from the scalar reference\n";
+			if (nrMismatchedBlocks > 0 || nrBlocks == 0)
+				hasPassed = false;
+		}
+
+		return hasPassed;
+	}
+
+	bool Tests::RunFlyThrough(SDL_Window* pWindow)
+	{
+		// One loop of the camera through the vehicle with the best kernel in fixed point, the float edges are not watertight
+		// Starting the fly-through turns the validation on, every frame is checked for holes and overlaps along the shared edges
+		Renderer renderer{ pWindow };
+		renderer.ToggleDirectX();
+		renderer.SetKernels(RasterKernels::GetBestSupportedType(), true);
+		Timer timer{};
+
+		constexpr int nrFlyThroughFrames{ 160 };
+		renderer.ToggleCameraFlyThrough();
+		const bool hasRendered{ RenderFrames(renderer, timer, nrFlyThroughFrames) };
+		const Renderer::FlyThroughResult result{ renderer.GetFlyThroughResult() };
+		renderer.ToggleCameraFlyThrough();
+		if (!hasRendered)
+			return false;
+
+		// Without clipped triangles the near plane and the guard band were not tested
+		return result.nrFailedFrames == 0 && result.nrFrames == nrFlyThroughFrames && result.nrClippedTriangles > 0;
+	}
+
+	bool Tests::RunWatertightness(SDL_Window* pWindow)
+	{
+		// Every shared edge of the vehicle, with every supported kernel in fixed point
+		// The float edges are not watertight, only the fixed point ones follow the top-left rule exactly
+		Renderer renderer{ pWindow };
+		renderer.ToggleDirectX();
+		renderer.ToggleRasterizerValidation();
+		Timer timer{};
+
+		bool hasPassed{ true };
+		for (const RasterKernel& kernel : GetSupportedKernels())
+		{
+			if (!kernel.isFixedPoint)
+				continue;
+
+			renderer.SetKernels(kernel.type, true);
+
+			Renderer::Statistics total{};
+			for (const Vector3& cameraOrigin : VehicleCameraOrigins)
+			{
+				renderer.SetCameraOrigin(cameraOrigin);
+				if (!RenderFrames(renderer, timer, 1))
+					return false;
+
+				const Renderer::Statistics& statistics{ renderer.GetStatistics() };
+				total.nrSharedEdges += statistics.nrSharedEdges;
+				total.nrDoubleHitPixels += statistics.nrDoubleHitPixels;
+				total.nrZeroHitPixels += statistics.nrZeroHitPixels;
+			}
+
+			std::cout << RasterKernels::GetName(kernel.type) << ' ' << GetModeName(kernel) << ", vehicle frames: " << total.nrSharedEdges << " shared edges"
+				<< " | double-hit pixels " << total.nrDoubleHitPixels << " | zero-hit pixels " << total.nrZeroHitPixels << '\n';
+			if (total.nrDoubleHitPixels > 0 || total.nrZeroHitPixels > 0 || total.nrSharedEdges == 0)
+				hasPassed = false;
+		}
+
+		return hasPassed;
+	}
+}
@@ -6,6 +6,17 @@
 #include "EffectTransparent.h"
 #include "Utils.h"
 #include "Texture.h"
+#include "Dds.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "RasterKernels.h"
+#include "Clipping.h"
+#include "Framebuffer.h"
+#include "Meshlets.h"
+#include <cassert>
+#include <bit>
+#include <filesystem>
+#include <map>
 
 namespace dae {
 
@@ -32,9 +43,30 @@ namespace dae {
 		m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
 		m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
 
-		m_pDepthBufferPixels = new float[m_Width * m_Height];
+		m_pFramebuffer = new Framebuffer(m_Width, m_Height, FramebufferLayout::Tiled);
+
+		//Create Tiles
+		m_NrTilesX = (m_Width + TileSize - 1) / TileSize;
+		m_NrTilesY = (m_Height + TileSize - 1) / TileSize;
+		m_TileBins.resize(size_t(m_NrTilesX) * m_NrTilesY);
+		m_TileStatistics.resize(m_TileBins.size());
+
+		m_NrHiZCellsX = m_NrTilesX * NrHiZCellsPerTile;
+		m_HiZCells.resize(size_t(m_NrHiZCellsX) * m_NrTilesY * NrHiZCellsPerTile);
+
+		m_VisibilityBuffer.resize(m_pFramebuffer->GetNrPixels());
+
+		m_Scissor = { 0, m_Width, 0, m_Height };
+
+		m_RasterKernel = RasterKernels::GetKernel(RasterKernels::GetBestSupportedType(), true);
+		m_VertexKernel = VertexKernels::GetKernel(m_RasterKernel.type);
+		std::cout << "Software rasterizer uses the " << RasterKernels::GetName(m_RasterKernel.type) << " vertex and raster kernels\n";
+
+		m_pThreadPool = new ThreadPool(std::max(std::thread::hardware_concurrency(), 1u));
+		std::cout << "Software rasterizer uses " << m_pThreadPool->GetThreadCount() << " threads\n";
 
 		InitMeshes();
+		LoadSampleState(D3D11_FILTER_MIN_MAG_MIP_POINT, m_pDevice);
 
 		m_pCamera = new Camera();
 		m_pCamera->Initialize(float(m_Width) / m_Height, 45.f, { 0,0,0 });
@@ -43,12 +75,17 @@ namespace dae {
 
 	Renderer::~Renderer()
 	{
-		delete[] m_pDepthBufferPixels;
+		delete m_pFramebuffer;
+		delete m_pThreadPool;
 		delete m_pCamera;
 		for (Mesh* pMesh : m_MeshPtrs)
 		{
 			delete pMesh;
 		}
+		for (ID3D11SamplerState* pSamplerState : m_SamplerStatePtrs)
+		{
+			if (pSamplerState) pSamplerState->Release();
+		}
 
 		if (m_pRenderTargetView) m_pRenderTargetView->Release();
 		if (m_pRenderTargetBuffer) m_pRenderTargetBuffer->Release();
@@ -70,16 +107,23 @@ namespace dae {
 	void Renderer::Update(const Timer* pTimer)
 	{
 		m_pCamera->Update(pTimer);
+
+		// Pixels covered by one unit at a distance of one unit, from the vertical field of view
+		const float pixelsPerUnit{ m_pCamera->GetProjectionMatrix()[1][1] * m_Height * 0.5f };
 		for (Mesh* pMesh : m_MeshPtrs)
 		{
 			pMesh->SetMatrix(m_pCamera->GetViewMatrix() * m_pCamera->GetProjectionMatrix(), m_pCamera->GetInvViewMatrix());
+			if (m_ForcedLod < 0)
+				pMesh->SelectLod(pixelsPerUnit, MaxLodPixelError);
+			else
+				pMesh->SetLod(uint32_t(m_ForcedLod));
 
 			pMesh->Update(pTimer);
 		}
 	}
 
 
-	void Renderer::Render() const
+	void Renderer::Render()
 	{
 		if (!m_IsInitialized)
 			return;
@@ -95,7 +139,7 @@ namespace dae {
 		}
 	}
 
-	void Renderer::RenderDirectX() const
+	void Renderer::RenderDirectX()
 	{
 		//1. CLEAR RTV & DSV
 		ColorRGB clearColor{ 0.39f, 0.59f, 0.93f };
@@ -107,244 +151,661 @@ namespace dae {
 		//2. SET PIPELINE + INVOKE DRAWCALLS (= RENDER)
 		for (const Mesh* pMesh : m_MeshPtrs)
 		{
-			pMesh->RenderDirectX(m_pDeviceContext);
+			++m_Statistics.nrMeshes;
+			if (pMesh->IsInFrustum())
+			{
+				pMesh->RenderDirectX(m_pDeviceContext);
+				m_Statistics.nrLodLevels += pMesh->GetLodIdx();
+				m_Statistics.nrLodTriangles += pMesh->GetLod().nrIndices / 3;
+			}
+			else
+				++m_Statistics.nrCulledMeshes;
+
 			if (m_RenderFire == false)
 				break;
 		}
+		++m_Statistics.nrFrames;
 
 		//3. PRESENT BACKBUFFER (SWAP)
 		m_pSwapChain->Present(0, 0);
 	}
 
-	void Renderer::RenderSoftware() const
+	void Renderer::RenderSoftware()
 	{
 		//@START
 		//Lock BackBuffer
 		SDL_LockSurface(m_pBackBuffer);
 
-		// Fill the array with max float value
-		std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
-
-		ClearBackground();
-
+		const uint64_t startTime{ SDL_GetPerformanceCounter() };
+		// The counters of this frame alone, for the fly-through
+		const Statistics frameStart{ m_Statistics };
 
 		// Only render vehicle
 		Mesh* mesh = m_MeshPtrs[0];
-		mesh->VertexTransformationFunction();
+		const bool isMeshVisible{ mesh->IsInFrustum() };
+		if (isMeshVisible)
+			mesh->VertexTransformationFunction(*m_pThreadPool, m_VertexKernel);
+
+		// Views on the buffers of the mesh, nothing gets copied or allocated per frame
+		// A culled mesh has no triangles, the tiles still get cleared
+		const std::span<const uint32_t> indices{ isMeshVisible ? mesh->GetIndices() : std::span<const uint32_t>{} };
+		const std::span<const Vertex_Out> vertices_out{ isMeshVisible ? mesh->GetVerticesOut() : std::span<const Vertex_Out>{} };
+
+		const uint64_t vertexTime{ SDL_GetPerformanceCounter() };
+
+		m_IndexRanges.clear();
+		if (isMeshVisible)
+			CullMeshlets(*mesh);
+		SetupTriangles(indices, vertices_out);
+		BinTriangles();
 
-		const std::vector<uint32_t> indices{ mesh->GetIndices() };
-		const std::vector<Vertex_Out> vertices_out{ mesh->GetVerticesOut() };
+		const uint64_t setupTime{ SDL_GetPerformanceCounter() };
+
+		if (m_pFramebuffer->GetLayout() == FramebufferLayout::Tiled)
+			RenderTiles(*mesh, m_pFramebuffer->GetTiledLayout());
+		else
+			RenderTiles(*mesh, m_pFramebuffer->GetLinearLayout());
+
+		const uint64_t rasterTime{ SDL_GetPerformanceCounter() };
+
+		if (m_ValidateRasterizer && m_Visualize != Visualize::BoundingBox)
+		{
+			CheckWatertightness();
+			if (m_pCamera->IsFlyingThrough())
+				CheckFlyThroughFrame(m_Statistics.nrClippedTriangles - frameStart.nrClippedTriangles,
+					m_Statistics.nrDoubleHitPixels - frameStart.nrDoubleHitPixels, m_Statistics.nrZeroHitPixels - frameStart.nrZeroHitPixels);
+		}
 
-		// For every triangle
-		for (int currIdx{}; currIdx < indices.size(); ++currIdx)
+		const double msPerCount{ 1000.0 / SDL_GetPerformanceFrequency() };
+		++m_Statistics.nrFrames;
+		++m_Statistics.nrMeshes;
+		m_Statistics.nrCulledMeshes += isMeshVisible ? 0 : 1;
+		m_Statistics.nrLodLevels += isMeshVisible ? mesh->GetLodIdx() : 0;
+		m_Statistics.nrLodTriangles += isMeshVisible ? mesh->GetLod().nrIndices / 3 : 0;
+		m_Statistics.vertexMs += (vertexTime - startTime) * msPerCount;
+		m_Statistics.setupMs += (setupTime - vertexTime) * msPerCount;
+		m_Statistics.rasterMs += (rasterTime - setupTime) * msPerCount;
+		m_Statistics.nrVertices += isMeshVisible ? mesh->GetLod().nrVertices : 0;
+		for (const IndexRange& range : m_IndexRanges)
 		{
-			int vertexIdx0{};
-			int vertexIdx1{};
-			int vertexIdx2{};
+			m_Statistics.nrSubmittedTriangles += range.nrIndices / 3;
+		}
+		m_Statistics.nrTriangles += m_Triangles.size();
+		for (const TileStatistics& tileStatistics : m_TileStatistics)
+		{
+			m_Statistics.nrValidatedBlocks += tileStatistics.nrValidatedBlocks;
+			m_Statistics.nrMismatchedBlocks += tileStatistics.nrMismatchedBlocks;
+			m_Statistics.nrHiZCells += tileStatistics.nrHiZCells;
+			m_Statistics.nrHiZRejectedCells += tileStatistics.nrHiZRejectedCells;
+			m_Statistics.nrHiZAcceptedCells += tileStatistics.nrHiZAcceptedCells;
+			m_Statistics.nrHiZRejectedTriangles += tileStatistics.nrHiZRejectedTriangles;
+			m_Statistics.nrDepthPassedFragments += tileStatistics.nrDepthPassedFragments;
+			m_Statistics.nrShadedPixels += tileStatistics.nrShadedPixels;
+			m_Statistics.nrVisiblePixels += tileStatistics.nrVisiblePixels;
+		}
+
+
+		//@END
+		//Update SDL Surface
+		SDL_UnlockSurface(m_pBackBuffer);
+		SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
+		SDL_UpdateWindowSurface(m_pWindow);
+
+	}
 
-			// Updating vertexindeces using trianglelist primitiveTopology
-			vertexIdx0 = indices[currIdx];
-			vertexIdx1 = indices[currIdx + 1];
-			vertexIdx2 = indices[currIdx + 2];
-			currIdx += 2;
+	void Renderer::CullMeshlets(const Mesh& mesh)
+	{
+		const std::span<const Meshlet> meshlets{ mesh.GetMeshlets() };
+		if (!m_UseMeshletCulling || meshlets.empty())
+		{
+			m_IndexRanges.push_back({ mesh.GetLod().firstIndex, mesh.GetLod().nrIndices });
+			return;
+		}
 
-			if (vertexIdx0 == vertexIdx1 || vertexIdx1 == vertexIdx2 || vertexIdx0 == vertexIdx2)
+		// Both tests are done in object space, nothing of the meshlets has to be transformed
+		const Clipping::Frustum frustum{ mesh.GetFrustum() };
+		const Vector3& cameraPosition{ mesh.GetCameraPosition() };
+		for (const Meshlet& meshlet : meshlets)
+		{
+			if ((m_CullMode == CullMode::Back && Meshlets::IsBackFacing(meshlet, cameraPosition))
+				|| (m_CullMode == CullMode::Front && Meshlets::IsFrontFacing(meshlet, cameraPosition)))
+			{
+				++m_Statistics.nrConeCulledMeshlets;
 				continue;
+			}
 
-			if (!IsInFrustum(vertices_out[vertexIdx0])
-				|| !IsInFrustum(vertices_out[vertexIdx1])
-				|| !IsInFrustum(vertices_out[vertexIdx2]))
+			if (!Clipping::IsVisible(frustum, meshlet.bounds))
+			{
+				++m_Statistics.nrFrustumCulledMeshlets;
 				continue;
+			}
 
-			Vertex_Out Vertex0{ NDCToScreen(vertices_out[vertexIdx0]) };
-			Vertex_Out Vertex1{ NDCToScreen(vertices_out[vertexIdx1]) };
-			Vertex_Out Vertex2{ NDCToScreen(vertices_out[vertexIdx2]) };
+			if (!m_IndexRanges.empty() && m_IndexRanges.back().firstIndex + m_IndexRanges.back().nrIndices == meshlet.firstIndex)
+				m_IndexRanges.back().nrIndices += meshlet.nrIndices;
+			else
+				m_IndexRanges.push_back({ meshlet.firstIndex, meshlet.nrIndices });
+		}
+		m_Statistics.nrMeshlets += meshlets.size();
+	}
 
-			//Setting up some variables
-			const Vector2 v0{ Vertex0.position.GetXY() };
-			const Vector2 v1{ Vertex1.position.GetXY() };
-			const Vector2 v2{ Vertex2.position.GetXY() };
+	void Renderer::SetupTriangles(std::span<const uint32_t> indices, std::span<const Vertex_Out> vertices_out)
+	{
+		m_Triangles.clear();
+		m_TriangleScreenPositions.clear();
 
-			const float depthV0{ Vertex0.position.z };
-			const float depthV1{ Vertex1.position.z };
-			const float depthV2{ Vertex2.position.z };
+		// Every triangle of the ranges that were not culled
+		for (const IndexRange& range : m_IndexRanges)
+		{
+			for (int currIdx{ int(range.firstIndex) }; currIdx < int(range.firstIndex + range.nrIndices); ++currIdx)
+			{
+				int vertexIdx0{};
+				int vertexIdx1{};
+				int vertexIdx2{};
 
-			const Vector2 edge01{ v1 - v0 };
-			const Vector2 edge12{ v2 - v1 };
-			const Vector2 edge20{ v0 - v2 };
+				// Updating vertexindeces using trianglelist primitiveTopology
+				vertexIdx0 = indices[currIdx];
+				vertexIdx1 = indices[currIdx + 1];
+				vertexIdx2 = indices[currIdx + 2];
+				currIdx += 2;
 
-			const float areaTriangle{ fabs(Vector2::Cross(v1 - v0, v2 - v0)) };
+				if (vertexIdx0 == vertexIdx1 || vertexIdx1 == vertexIdx2 || vertexIdx0 == vertexIdx2)
+					continue;
 
-			if (areaTriangle <= 0.01f)
-			{
-				continue;
+				const Vertex_Out& vertex0{ vertices_out[vertexIdx0] };
+				const Vertex_Out& vertex1{ vertices_out[vertexIdx1] };
+				const Vertex_Out& vertex2{ vertices_out[vertexIdx2] };
+
+				// All vertices outside of the same side of the screen
+				if (Clipping::GetOutCode(vertex0.position, 1.f) & Clipping::GetOutCode(vertex1.position, 1.f) & Clipping::GetOutCode(vertex2.position, 1.f))
+					continue;
+
+				const uint32_t outCode0{ Clipping::GetOutCode(vertex0.position, GuardBand) };
+				const uint32_t outCode1{ Clipping::GetOutCode(vertex1.position, GuardBand) };
+				const uint32_t outCode2{ Clipping::GetOutCode(vertex2.position, GuardBand) };
+
+				if ((outCode0 | outCode1 | outCode2) == 0)
+				{
+					SetupTriangle(vertex0, vertex1, vertex2);
+					continue;
+				}
+
+				// Crosses the near or far plane or the guard band, clip it and fan the polygon back into triangles
+				++m_Statistics.nrClippedTriangles;
+
+				Vertex_Out polygon[Clipping::MaxClippedVertices]{ vertex0, vertex1, vertex2 };
+				const int nrVertices{ Clipping::ClipPolygon(polygon, 3, outCode0 | outCode1 | outCode2, GuardBand) };
+				for (int i{ 1 }; i + 1 < nrVertices; ++i)
+				{
+					SetupTriangle(polygon[0], polygon[i], polygon[i + 1]);
+				}
 			}
+		}
+	}
 
-			// create bounding box for triangle
-			const int bottom = std::min(int(std::min(v0.y, v1.y)), int(v2.y));
-			const int top = std::max(int(std::max(v0.y, v1.y)), int(v2.y)) + 1;
+	void Renderer::SetupTriangle(const Vertex_Out& vertex0, const Vertex_Out& vertex1, const Vertex_Out& vertex2)
+	{
+		const Vector2 v0{ ClipToScreen(vertex0.position) };
+		const Vector2 v1{ ClipToScreen(vertex1.position) };
+		const Vector2 v2{ ClipToScreen(vertex2.position) };
 
-			const int left = std::min(int(std::min(v0.x, v1.x)), int(v2.x));
-			const int right = std::max(int(std::max(v0.x, v1.x)), int(v2.x)) + 1;
+		// Culled once per triangle from its winding on screen, before any pixel work
+		const bool isFrontFacing{ Vector2::Cross(v1 - v0, v2 - v0) > 0.f };
+		if ((m_CullMode == CullMode::Back && !isFrontFacing) || (m_CullMode == CullMode::Front && isFrontFacing))
+		{
+			++m_Statistics.nrCulledTriangles;
+			return;
+		}
 
-			// check if bounding box is in screen
-			if (left <= 0 || right >= m_Width - 1)
-				continue;
+		// The edges of back faces are flipped, so the inside of every triangle that gets rasterized is positive
+		const float windingSign{ isFrontFacing ? 1.f : -1.f };
 
-			if (bottom <= 0 || top >= m_Height - 1)
-				continue;
+		TriangleSetup triangle{};
 
-			constexpr int offSet{ 1 };
+		const bool isCovering{ m_RasterKernel.isFixedPoint
+			? RasterKernels::SetupFixedPointEdges(triangle, { v0, v1, v2 }, windingSign, m_Scissor)
+			: RasterKernels::SetupEdges(triangle, { v0, v1, v2 }, windingSign, m_Scissor) };
+		if (!isCovering)
+			return;
 
-			////RENDER LOGIC
-			//for (int px{}; px < m_Width; ++px)
-			//{
-			//	for (int py{}; py < m_Height; ++py)
-			//	{
+		const Vertex_Out* triangleVertices[3]{ &vertex0, &vertex1, &vertex2 };
+		for (int i{}; i < 3; ++i)
+		{
+			const Vertex_Out& vertex{ *triangleVertices[i] };
+			VertexSetup& vertexSetup{ triangle.vertices[i] };
+
+			vertexSetup.depth = vertex.position.z / vertex.position.w;
+			vertexSetup.invW = 1.f / vertex.position.w;
+			vertexSetup.uv = vertex.uv;
+			vertexSetup.normal = vertex.normal;
+			vertexSetup.tangent = vertex.tangent;
+			vertexSetup.viewDirection = vertex.viewDirection;
+		}
 
+		// The kernels clamp the interpolated depth to this range, so the hierarchical depth test is exact
+		const VertexSetup* pVertices{ triangle.vertices };
+		triangle.minDepth = std::min(std::min(pVertices[0].depth, pVertices[1].depth), pVertices[2].depth);
+		triangle.maxDepth = std::max(std::max(pVertices[0].depth, pVertices[1].depth), pVertices[2].depth);
 
-			for (int px = left - offSet; px < right + offSet; ++px)
+		m_Triangles.emplace_back(triangle);
+		if (m_ValidateRasterizer)
+			m_TriangleScreenPositions.push_back({ v0, v1, v2 });
+	}
+
+	void Renderer::BinTriangles()
+	{
+		for (std::vector<uint32_t>& bin : m_TileBins)
+		{
+			bin.clear();
+		}
+
+		// Triangles are added in submission order, so every pixel still sees them in index buffer order
+		for (uint32_t triangleIdx{}; triangleIdx < m_Triangles.size(); ++triangleIdx)
+		{
+			const TriangleSetup& triangle{ m_Triangles[triangleIdx] };
+
+			const int firstTileX{ triangle.left / TileSize };
+			const int lastTileX{ (triangle.right - 1) / TileSize };
+			const int firstTileY{ triangle.bottom / TileSize };
+			const int lastTileY{ (triangle.top - 1) / TileSize };
+
+			for (int tileY{ firstTileY }; tileY <= lastTileY; ++tileY)
 			{
-				for (int py = bottom - offSet; py < top + offSet; ++py)
+				for (int tileX{ firstTileX }; tileX <= lastTileX; ++tileX)
 				{
-					ColorRGB finalColor = colors::Black;
+					m_TileBins[tileX + tileY * m_NrTilesX].push_back(triangleIdx);
+				}
+			}
+		}
+	}
+
+	template<typename Layout>
+	void Renderer::RenderTiles(const Mesh& mesh, const Layout& layout)
+	{
+		// Every tile clears, rasterizes and resolves its own part of the buffers
+		m_pThreadPool->ParallelFor(static_cast<uint32_t>(m_TileBins.size()), [&](uint32_t tileIdx)
+			{
+				RenderTile(tileIdx, mesh, layout);
+			});
+	}
 
-					if (m_Visualize == Visualize::BoundingBox)
+	template<typename Layout>
+	void Renderer::RenderTile(uint32_t tileIdx, const Mesh& mesh, const Layout& layout)
+	{
+		const int tileLeft{ int(tileIdx % m_NrTilesX) * TileSize };
+		const int tileBottom{ int(tileIdx / m_NrTilesX) * TileSize };
+		const int tileRight{ std::min(tileLeft + TileSize, m_Width) };
+		const int tileTop{ std::min(tileBottom + TileSize, m_Height) };
+
+		TileStatistics& statistics{ m_TileStatistics[tileIdx] };
+		statistics = {};
+
+		float* pDepthPixels{ m_pFramebuffer->GetDepthPixels() };
+		uint32_t* pColorPixels{ m_pFramebuffer->GetColorPixels() };
+
+		// Fill the array with max float value
+		for (int py{ tileBottom }; py < tileTop; ++py)
+		{
+			for (int px{ tileLeft }; px < tileRight; ++px)
+			{
+				pDepthPixels[layout.GetIndex(px, py)] = FLT_MAX;
+			}
+		}
+
+		ClearBackground(tileLeft, tileRight, tileBottom, tileTop, layout);
+
+		const int tileCellX{ tileLeft / HiZSize };
+		const int tileCellY{ tileBottom / HiZSize };
+		for (int cellY{ tileCellY }; cellY < tileCellY + NrHiZCellsPerTile; ++cellY)
+		{
+			std::fill_n(m_HiZCells.begin() + tileCellX + cellY * m_NrHiZCellsX, NrHiZCellsPerTile, HiZCell{});
+		}
+
+		// Bit of a cell in the masks of this tile
+		const auto getCellBit{ [&](int px, int py)
+			{
+				return 1ull << ((px / HiZSize - tileCellX) + (py / HiZSize - tileCellY) * NrHiZCellsPerTile);
+			} };
+
+		const RasterKernel referenceKernel{ RasterKernels::GetReferenceKernel(m_RasterKernel) };
+		const int blockWidth{ m_RasterKernel.nrLanes / 2 };
+
+		for (const uint32_t triangleIdx : m_TileBins[tileIdx])
+		{
+			const TriangleSetup& triangle{ m_Triangles[triangleIdx] };
+
+			// Only the part of the bounding box that overlaps this tile
+			const int left{ std::max(triangle.left, tileLeft) };
+			const int right{ std::min(triangle.right, tileRight) };
+			const int bottom{ std::max(triangle.bottom, tileBottom) };
+			const int top{ std::min(triangle.top, tileTop) };
+
+			if (m_Visualize == Visualize::BoundingBox)
+			{
+				const uint32_t white{ SDL_MapRGB(m_pBackBuffer->format, 255, 255, 255) };
+				for (int py{ bottom }; py < top; ++py)
+				{
+					for (int px{ left }; px < right; ++px)
 					{
-						finalColor = colors::White;
+						pColorPixels[layout.GetIndex(px, py)] = white;
 					}
-					else
+				}
+				continue;
+			}
+
+			// Cells behind the depth already stored get rejected, cells in front of it skip loading the depth
+			uint64_t rejectedCells{};
+			uint64_t acceptedCells{};
+			if (m_UseHiZ)
+			{
+				uint64_t overlappedCells{};
+				for (int cellY{ bottom / HiZSize }; cellY <= (top - 1) / HiZSize; ++cellY)
+				{
+					for (int cellX{ left / HiZSize }; cellX <= (right - 1) / HiZSize; ++cellX)
 					{
-						Vector2 pixel = { float(px), float(py) };
+						const HiZCell& cell{ m_HiZCells[cellX + cellY * m_NrHiZCellsX] };
+						const uint64_t cellBit{ getCellBit(cellX * HiZSize, cellY * HiZSize) };
+
+						overlappedCells |= cellBit;
+						if (triangle.minDepth > cell.maxDepth)
+							rejectedCells |= cellBit;
+						else if (triangle.maxDepth < cell.minDepth)
+							acceptedCells |= cellBit;
+					}
+				}
 
-						// Maths to check if the pixel is in the triangle
-						const Vector2 directionV0 = pixel - v0;
-						const Vector2 directionV1 = pixel - v1;
-						const Vector2 directionV2 = pixel - v2;
+				statistics.nrHiZCells += std::popcount(overlappedCells);
+				statistics.nrHiZRejectedCells += std::popcount(rejectedCells);
+				statistics.nrHiZAcceptedCells += std::popcount(acceptedCells);
+				if (rejectedCells == overlappedCells)
+				{
+					++statistics.nrHiZRejectedTriangles;
+					continue;
+				}
+			}
+			uint64_t writtenCells{};
+
+			// Blocks start on even pixels, tiles do as well so a block never crosses a tile border
+			const int firstBlockX{ left & ~1 };
+			const int firstBlockY{ bottom & ~1 };
+
+			// Edge function values at the first quad, stepped along the quad rows and columns
+			Vector3 rowWeights{ triangle.edgeStart
+				+ triangle.edgeStepX * float(firstBlockX - triangle.left)
+				+ triangle.edgeStepY * float(firstBlockY - triangle.bottom) };
+			const Vector3 quadStepX{ triangle.edgeStepX * 2.f };
+			const Vector3 quadStepY{ triangle.edgeStepY * 2.f };
+			const int nrQuads{ m_RasterKernel.nrLanes / 4 };
+
+			// The fixed point edge functions are stepped exactly, the float ones are converted from them
+			int64_t fixedRowEdges[3]{};
+			for (int i{}; i < 3; ++i)
+			{
+				fixedRowEdges[i] = triangle.fixedEdgeStart[i]
+					+ triangle.fixedEdgeStepX[i] * (firstBlockX - triangle.left)
+					+ triangle.fixedEdgeStepY[i] * (firstBlockY - triangle.bottom);
+			}
 
-						float weightV2 = Vector2::Cross(edge01, directionV0);
-						float weightV0 = Vector2::Cross(edge12, directionV1);
-						float weightV1 = Vector2::Cross(edge20, directionV2);
+			for (int blockY{ firstBlockY }; blockY < top; blockY += 2, rowWeights += quadStepY)
+			{
+				RasterBlock block{};
+				Vector3 quadWeights{ rowWeights };
+				int64_t fixedQuadEdges[3]{ fixedRowEdges[0], fixedRowEdges[1], fixedRowEdges[2] };
+				for (int i{}; i < 3; ++i)
+				{
+					fixedRowEdges[i] += triangle.fixedEdgeStepY[i] * 2;
+				}
 
-						// Calculate which side of the triangle has been hit
-						const bool isFrontFaceHit{ weightV2 > 0 && weightV0 > 0 && weightV1 > 0 };
-						const bool isBackFaceHit{ weightV2 < 0 && weightV0 < 0 && weightV1 < 0 };
+				for (int blockX{ firstBlockX }; blockX < right; blockX += blockWidth)
+				{
+					// A quad never crosses a cell border, so the hierarchical depth test is done per quad
+					uint64_t quadCellBits[RasterBlock::MaxQuads]{};
+					uint32_t rejectedLanes{};
+					for (int quad{}; quad < nrQuads; ++quad, quadWeights += quadStepX)
+					{
+						if (m_RasterKernel.isFixedPoint)
+						{
+							for (int i{}; i < 3; ++i)
+							{
+								block.fixedEdges[quad][i] = fixedQuadEdges[i];
+								fixedQuadEdges[i] += triangle.fixedEdgeStepX[i] * 2;
+							}
+							block.edgeWeights[quad] = Vector3{ float(block.fixedEdges[quad][0]), float(block.fixedEdges[quad][1]), float(block.fixedEdges[quad][2]) };
+						}
+						else
+						{
+							block.edgeWeights[quad] = quadWeights;
+						}
 
-						// Continue to the next pixel if the cullmode demands it
-						if ((m_CullMode == CullMode::Back && !isFrontFaceHit) ||
-							(m_CullMode == CullMode::Front && !isBackFaceHit) ||
-							(m_CullMode == CullMode::None && !isFrontFaceHit /*&& !isBackFaceHit*/))
+						if (blockX + quad * 2 >= right)
 							continue;
 
-						// Setting up the weights for the UV coordinates
-						weightV0 /= areaTriangle;
-						weightV1 /= areaTriangle;
-						weightV2 /= areaTriangle;
-
-						// Create BufferValue
-						const float ZBufferVal{
-							1.f /
-							((1 / depthV0) * weightV0 +
-							(1 / depthV1) * weightV1 +
-							(1 / depthV2) * weightV2)
-						};
-
-						// Check if there is no triangle in front of this triangle
-						if (ZBufferVal > m_pDepthBufferPixels[px * m_Height + py])
+						quadCellBits[quad] = getCellBit(blockX + quad * 2, blockY);
+						if (rejectedCells & quadCellBits[quad])
+							rejectedLanes |= 0xFu << (quad * 4);
+					}
+
+					if (rejectedLanes == (1u << m_RasterKernel.nrLanes) - 1)
+						continue;
+
+					// Mask out the lanes outside of the bounding box and load their depth
+					block.laneMask = 0;
+					for (int lane{}; lane < m_RasterKernel.nrLanes; ++lane)
+					{
+						const int px{ blockX + RasterBlock::GetLaneX(lane) };
+						const int py{ blockY + RasterBlock::GetLaneY(lane) };
+						if (px < left || px >= right || py < bottom || py >= top || (rejectedLanes & (1u << lane)))
 							continue;
 
-						// Add BufferValue to the array
-						m_pDepthBufferPixels[px * m_Height + py] = ZBufferVal;
+						block.laneMask |= 1u << lane;
+						if (acceptedCells & quadCellBits[lane / 4])
+							block.depth[lane] = FLT_MAX;
+						else
+							block.depth[lane] = pDepthPixels[layout.GetIndex(px, py)];
+					}
 
+					if (block.laneMask == 0)
+						continue;
 
-						// Visualize what is requested by user
-						switch (m_Visualize)
-						{
-						case Visualize::FinalColor:
+					if (m_ValidateRasterizer)
+					{
+						RasterBlock referenceBlock{ block };
+						referenceKernel.pRasterizeBlock(triangle, referenceBlock);
+						m_RasterKernel.pRasterizeBlock(triangle, block);
+
+						++statistics.nrValidatedBlocks;
+						if (referenceBlock.coverageMask != block.coverageMask || referenceBlock.depthMask != block.depthMask)
 						{
-							// Interpolating all atributes
-							// for shading we use world coordinates
-
-							const Vertex_Out v0_world{ vertices_out[vertexIdx0] };
-							const Vertex_Out v1_world{ vertices_out[vertexIdx1] };
-							const Vertex_Out v2_world{ vertices_out[vertexIdx2] };
-
-							const float interpolatedWDepth = {
-								1.f /
-								((1 / v0_world.position.w) * weightV0 +
-								(1 / v1_world.position.w) * weightV1 +
-								(1 / v2_world.position.w) * weightV2)
-							};
-
-							const Vector2 interpolatedUV = {
-								((v0_world.uv / v0_world.position.w) * weightV0 +
-								(v1_world.uv / v1_world.position.w) * weightV1 +
-								(v2_world.uv / v2_world.position.w) * weightV2) * interpolatedWDepth
-							};
-
-							Vector3 interpolatedNormal = {
-								((v0_world.normal / v0_world.position.w) * weightV0 +
-								(v1_world.normal / v1_world.position.w) * weightV1 +
-								(v2_world.normal / v2_world.position.w) * weightV2) * interpolatedWDepth
-							};
-							interpolatedNormal.Normalize();
-
-							Vector3 interpolatedTangent = {
-								((v0_world.tangent / v0_world.position.w) * weightV0 +
-								(v1_world.tangent / v1_world.position.w) * weightV1 +
-								(v2_world.tangent / v2_world.position.w) * weightV2) * interpolatedWDepth
-							};
-							interpolatedTangent.Normalize();
-
-							Vector3 interpolatedViewDirection = {
-								((v0_world.viewDirection / v0_world.position.w) * weightV0 +
-								(v1_world.viewDirection / v1_world.position.w) * weightV1 +
-								(v2_world.viewDirection / v2_world.position.w) * weightV2) * interpolatedWDepth
-							};
-							interpolatedViewDirection.Normalize();
-
-							//Interpolated Vertex Attributes for Pixel
-							Vertex_Out pixelVertex;
-							pixelVertex.position = Vector4{ pixel.x, pixel.y, ZBufferVal, interpolatedWDepth };
-							pixelVertex.uv = interpolatedUV;
-							pixelVertex.normal = interpolatedNormal;
-							pixelVertex.tangent = interpolatedTangent;
-							pixelVertex.viewDirection = interpolatedViewDirection;
-
-							finalColor = PixelShading(pixelVertex, *mesh);
-
-							break;
+							++statistics.nrMismatchedBlocks;
+							assert(false && "Raster kernel coverage differs from the scalar reference");
 						}
-						case Visualize::DepthBuffer:
-						{
-							constexpr float depthRemapSize{ 0.005f };
+					}
+					else
+					{
+						m_RasterKernel.pRasterizeBlock(triangle, block);
+					}
 
-							float remapedBufferVal{ ZBufferVal };
-							DepthRemap(remapedBufferVal, depthRemapSize);
-							finalColor = ColorRGB{ remapedBufferVal, remapedBufferVal , remapedBufferVal };
-							break;
-						}
+					for (int quad{}; quad < nrQuads; ++quad)
+					{
+						if ((block.depthMask >> (quad * 4)) & 0xFu)
+							writtenCells |= quadCellBits[quad];
+					}
+
+					for (int lane{}; lane < m_RasterKernel.nrLanes; ++lane)
+					{
+						if ((block.depthMask & (1u << lane)) == 0)
+							continue;
+
+						const int px{ blockX + RasterBlock::GetLaneX(lane) };
+						const int py{ blockY + RasterBlock::GetLaneY(lane) };
+						const size_t pixelIdx{ layout.GetIndex(px, py) };
+
+						// Add BufferValue to the array
+						pDepthPixels[pixelIdx] = block.z[lane];
+						++statistics.nrDepthPassedFragments;
+
+						const VisibilitySample sample{ triangleIdx, block.interpolatedW[lane], block.weightV0[lane], block.weightV1[lane], block.weightV2[lane] };
+						if (m_UseDeferredShading)
+						{
+							m_VisibilityBuffer[pixelIdx] = sample;
+							continue;
 						}
+
+						WritePixel(px, py, ShadePixel(triangle, sample, block.z[lane], px, py, mesh), layout);
+						++statistics.nrShadedPixels;
 					}
+				}
+			}
 
-					//Update Color in Buffer
-					finalColor.MaxToOne();
+			// Refresh the cells this triangle wrote depth to
+			for (; writtenCells != 0; writtenCells &= writtenCells - 1)
+			{
+				const int cellIdx{ std::countr_zero(writtenCells) };
+				UpdateHiZCell(tileCellX + cellIdx % NrHiZCellsPerTile, tileCellY + cellIdx / NrHiZCellsPerTile, layout);
+			}
+		}
 
-					m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(finalColor.r * 255),
-						static_cast<uint8_t>(finalColor.g * 255),
-						static_cast<uint8_t>(finalColor.b * 255));
+		if (m_UseDeferredShading)
+		{
+			statistics.nrShadedPixels = ShadeTile(tileLeft, tileRight, tileBottom, tileTop, mesh, layout);
+			statistics.nrVisiblePixels = statistics.nrShadedPixels;
+		}
+		else if (m_PrintStatistics)
+		{
+			for (int py{ tileBottom }; py < tileTop; ++py)
+			{
+				for (int px{ tileLeft }; px < tileRight; ++px)
+				{
+					if (pDepthPixels[layout.GetIndex(px, py)] != FLT_MAX)
+						++statistics.nrVisiblePixels;
 				}
 			}
 		}
 
+		m_pFramebuffer->Resolve(layout, tileLeft, tileRight, tileBottom, tileTop, m_pBackBufferPixels, m_Width);
+	}
 
-		//@END
-		//Update SDL Surface
-		SDL_UnlockSurface(m_pBackBuffer);
-		SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-		SDL_UpdateWindowSurface(m_pWindow);
+	template<typename Layout>
+	uint64_t Renderer::ShadeTile(int left, int right, int bottom, int top, const Mesh& mesh, const Layout& layout) const
+	{
+		const float* pDepthPixels{ m_pFramebuffer->GetDepthPixels() };
+
+		uint64_t nrShadedPixels{};
+		for (int py{ bottom }; py < top; ++py)
+		{
+			for (int px{ left }; px < right; ++px)
+			{
+				const size_t pixelIdx{ layout.GetIndex(px, py) };
+				const float z{ pDepthPixels[pixelIdx] };
+				if (z == FLT_MAX)
+					continue;
+
+				const VisibilitySample& sample{ m_VisibilityBuffer[pixelIdx] };
+				WritePixel(px, py, ShadePixel(m_Triangles[sample.triangleIdx], sample, z, px, py, mesh), layout);
+				++nrShadedPixels;
+			}
+		}
+
+		return nrShadedPixels;
+	}
+
+	ColorRGB Renderer::ShadePixel(const TriangleSetup& triangle, const VisibilitySample& sample, float z, int px, int py, const Mesh& mesh) const
+	{
+		// Visualize what is requested by user
+		switch (m_Visualize)
+		{
+		case Visualize::FinalColor:
+		{
+			// Interpolating all atributes with the perspective correct weights
+			// for shading we use world coordinates
+			const VertexSetup& vertex0{ triangle.vertices[0] };
+			const VertexSetup& vertex1{ triangle.vertices[1] };
+			const VertexSetup& vertex2{ triangle.vertices[2] };
+
+			const float weightV0{ sample.weightV0 };
+			const float weightV1{ sample.weightV1 };
+			const float weightV2{ sample.weightV2 };
+
+			const Vector2 interpolatedUV = {
+				vertex0.uv * weightV0 +
+				vertex1.uv * weightV1 +
+				vertex2.uv * weightV2
+			};
+
+			// Exact screen space derivatives of the perspective correct uv, they pick the mip level
+			// d(uv)/dx = w * sum(edgeStepX_i / area * invW_i * (uv_i - uv)), the same with edgeStepY for y
+			const float derivativeScale{ triangle.invArea * sample.interpolatedW };
+			const float scale0{ vertex0.invW * derivativeScale };
+			const float scale1{ vertex1.invW * derivativeScale };
+			const float scale2{ vertex2.invW * derivativeScale };
+			const float deltaU0{ (vertex0.uv.x - interpolatedUV.x) * scale0 };
+			const float deltaV0{ (vertex0.uv.y - interpolatedUV.y) * scale0 };
+			const float deltaU1{ (vertex1.uv.x - interpolatedUV.x) * scale1 };
+			const float deltaV1{ (vertex1.uv.y - interpolatedUV.y) * scale1 };
+			const float deltaU2{ (vertex2.uv.x - interpolatedUV.x) * scale2 };
+			const float deltaV2{ (vertex2.uv.y - interpolatedUV.y) * scale2 };
+			const Vector2 uvDdx{
+				deltaU0 * triangle.edgeStepX.x + deltaU1 * triangle.edgeStepX.y + deltaU2 * triangle.edgeStepX.z,
+				deltaV0 * triangle.edgeStepX.x + deltaV1 * triangle.edgeStepX.y + deltaV2 * triangle.edgeStepX.z };
+			const Vector2 uvDdy{
+				deltaU0 * triangle.edgeStepY.x + deltaU1 * triangle.edgeStepY.y + deltaU2 * triangle.edgeStepY.z,
+				deltaV0 * triangle.edgeStepY.x + deltaV1 * triangle.edgeStepY.y + deltaV2 * triangle.edgeStepY.z };
+
+			Vector3 interpolatedNormal = {
+				vertex0.normal * weightV0 +
+				vertex1.normal * weightV1 +
+				vertex2.normal * weightV2
+			};
+			interpolatedNormal.Normalize();
+
+			// Only the direction gets normalized, w keeps the sign of the handedness
+			Vector4 interpolatedTangent = {
+				vertex0.tangent * weightV0 +
+				vertex1.tangent * weightV1 +
+				vertex2.tangent * weightV2
+			};
+			const Vector3 tangentDirection{ interpolatedTangent.GetXYZ().Normalized() };
+			interpolatedTangent = Vector4{ tangentDirection, interpolatedTangent.w };
+
+			Vector3 interpolatedViewDirection = {
+				vertex0.viewDirection * weightV0 +
+				vertex1.viewDirection * weightV1 +
+				vertex2.viewDirection * weightV2
+			};
+			interpolatedViewDirection.Normalize();
+
+			//Interpolated Vertex Attributes for Pixel
+			Vertex_Out pixelVertex;
+			pixelVertex.position = Vector4{ float(px), float(py), z, sample.interpolatedW };
+			pixelVertex.uv = interpolatedUV;
+			pixelVertex.normal = interpolatedNormal;
+			pixelVertex.tangent = interpolatedTangent;
+			pixelVertex.viewDirection = interpolatedViewDirection;
+
+			return PixelShading(pixelVertex, uvDdx, uvDdy, mesh);
+		}
+		case Visualize::DepthBuffer:
+		{
+			constexpr float depthRemapSize{ 0.005f };
+
+			float remapedBufferVal{ z };
+			DepthRemap(remapedBufferVal, depthRemapSize);
+			return ColorRGB{ remapedBufferVal, remapedBufferVal , remapedBufferVal };
+		}
+		}
+
+		return colors::Black;
+	}
+
+	template<typename Layout>
+	void Renderer::WritePixel(int px, int py, ColorRGB color, const Layout& layout) const
+	{
+		//Update Color in Buffer
+		color.MaxToOne();
 
+		m_pFramebuffer->GetColorPixels()[layout.GetIndex(px, py)] = SDL_MapRGB(m_pBackBuffer->format,
+			static_cast<uint8_t>(color.r * 255),
+			static_cast<uint8_t>(color.g * 255),
+			static_cast<uint8_t>(color.b * 255));
 	}
 
 	void Renderer::ToggleRotation()
@@ -416,6 +877,12 @@ namespace dae {
 
 	void Renderer::ToggleFilteringMethod()
 	{
+		if (!m_UseDirectX)
+		{
+			CycleTextureFilter();
+			return;
+		}
+
 		D3D11_FILTER newFilter{};
 		switch (m_FilteringMethod)
 		{
@@ -439,9 +906,34 @@ namespace dae {
 		LoadSampleState(newFilter, m_pDevice);
 	}
 
+	void Renderer::CycleTextureFilter()
+	{
+		switch (m_TextureFilter)
+		{
+		case Texture::Filter::Point:
+			m_TextureFilter = Texture::Filter::Bilinear;
+			std::cout << "SOFTWARE FILTERING METHOD: BILINEAR\n";
+			break;
+		case Texture::Filter::Bilinear:
+			m_TextureFilter = Texture::Filter::Trilinear;
+			std::cout << "SOFTWARE FILTERING METHOD: TRILINEAR\n";
+			break;
+		case Texture::Filter::Trilinear:
+			m_TextureFilter = Texture::Filter::Point;
+			std::cout << "SOFTWARE FILTERING METHOD: POINT\n";
+			break;
+		}
+		for (Mesh* pMesh : m_MeshPtrs)
+		{
+			pMesh->SetTextureFilter(m_TextureFilter);
+		}
+		m_Statistics = {};
+	}
+
 	void Renderer::ToggleDirectX()
 	{
 		m_UseDirectX = !m_UseDirectX;
+		m_Statistics = {};
 		if (m_UseDirectX)
 			std::cout << "Using hardware rendering\n";
 		else
@@ -453,6 +945,61 @@ namespace dae {
 		m_UsingUniformClearColor = !m_UsingUniformClearColor;
 	}
 
+	void Renderer::ToggleCameraFlyThrough()
+	{
+		m_pCamera->ToggleFlyThrough();
+		if (m_pCamera->IsFlyingThrough())
+		{
+			// Through the vehicle and past the screen borders, so the near plane and the guard band clip every frame
+			m_WasValidatingBeforeFlyThrough = m_ValidateRasterizer;
+			m_ValidateRasterizer = true;
+			m_FlyThroughResult = {};
+			std::cout << "Camera fly-through started, the software rasterizer checks every frame for holes and overlaps\n";
+			return;
+		}
+
+		m_ValidateRasterizer = m_WasValidatingBeforeFlyThrough;
+		std::cout << "Camera fly-through stopped: " << m_FlyThroughResult.nrFailedFrames << " of " << m_FlyThroughResult.nrFrames << " frames"
+			<< " had holes or overlaps | clipped triangles " << m_FlyThroughResult.nrClippedTriangles
+			<< " | double-hit pixels " << m_FlyThroughResult.nrDoubleHitPixels
+			<< " | zero-hit pixels " << m_FlyThroughResult.nrZeroHitPixels << "\n";
+	}
+
+	void Renderer::ToggleQuantizedVertices()
+	{
+		m_UseQuantizedVertices = !m_UseQuantizedVertices;
+		for (Mesh* pMesh : m_MeshPtrs)
+		{
+			pMesh->SetQuantizedVertices(m_UseQuantizedVertices);
+		}
+
+		if (m_UseQuantizedVertices)
+			std::cout << "Meshes use quantized 16 bit vertices\n";
+		else
+			std::cout << "Meshes use float vertices\n";
+	}
+
+	void Renderer::CycleLodMode()
+	{
+		uint32_t nrLods{ 1 };
+		for (const Mesh* pMesh : m_MeshPtrs)
+		{
+			nrLods = std::max(nrLods, pMesh->GetNrLods());
+		}
+
+		m_ForcedLod = m_ForcedLod + 1 < int(nrLods) ? m_ForcedLod + 1 : -1;
+		m_Statistics = {};
+		if (m_ForcedLod < 0)
+			std::cout << "Levels of detail picked by distance, at most " << MaxLodPixelError << " pixel error\n";
+		else
+			std::cout << "Level of detail " << m_ForcedLod << " forced on every mesh\n";
+	}
+
+	void Renderer::SetForcedLod(int lodIdx)
+	{
+		m_ForcedLod = lodIdx;
+	}
+
 	void Renderer::ToggleFireRendering()
 	{
 		m_RenderFire = !m_RenderFire;
@@ -506,20 +1053,209 @@ namespace dae {
 			m_Visualize = Visualize::FinalColor;
 	}
 
+	void Renderer::CycleThreadCount()
+	{
+		// 1, 2, 4, ... up to the amount of hardware threads, then back to 1
+		const uint32_t maxThreads{ std::max(std::thread::hardware_concurrency(), 1u) };
+		uint32_t threadCount{ m_pThreadPool->GetThreadCount() * 2 };
+		if (m_pThreadPool->GetThreadCount() == maxThreads)
+			threadCount = 1;
+		else if (threadCount > maxThreads)
+			threadCount = maxThreads;
+
+		SetThreadCount(threadCount);
+	}
+
+	void Renderer::SetThreadCount(uint32_t threadCount)
+	{
+		m_pThreadPool->SetThreadCount(threadCount);
+		std::cout << "Software rasterizer uses " << threadCount << " threads\n";
+	}
+
+	void Renderer::SetCameraOrigin(const Vector3& origin)
+	{
+		m_pCamera->SetOrigin(origin);
+	}
+
+	void Renderer::CycleRasterKernel()
+	{
+		// Skips the kernels this CPU does not support
+		RasterKernelType type{ m_RasterKernel.type };
+		do
+		{
+			type = RasterKernelType((int(type) + 1) % 3);
+		} while (!RasterKernels::IsSupported(type));
+
+		SetKernels(type, m_RasterKernel.isFixedPoint);
+	}
+
+	void Renderer::SetKernels(RasterKernelType type, bool isFixedPoint)
+	{
+		m_RasterKernel = RasterKernels::GetKernel(type, isFixedPoint);
+		m_VertexKernel = VertexKernels::GetKernel(type);
+		std::cout << "Software rasterizer uses the " << RasterKernels::GetName(type) << " vertex and raster kernels\n";
+	}
+
+	void Renderer::ToggleFixedPointRasterization()
+	{
+		m_RasterKernel = RasterKernels::GetKernel(m_RasterKernel.type, !m_RasterKernel.isFixedPoint);
+		if (m_RasterKernel.isFixedPoint)
+			std::cout << "Software rasterizer uses fixed point edge functions with the top-left rule\n";
+		else
+			std::cout << "Software rasterizer uses float edge functions\n";
+	}
+
+	void Renderer::ToggleRasterizerValidation()
+	{
+		m_ValidateRasterizer = !m_ValidateRasterizer;
+		if (m_ValidateRasterizer)
+			std::cout << "Rasterizer is validated against the scalar reference kernel and checked for watertightness\n";
+		else
+			std::cout << "Rasterizer validation is disabled\n";
+	}
+
+	void Renderer::ToggleHierarchicalDepth()
+	{
+		m_UseHiZ = !m_UseHiZ;
+		if (m_UseHiZ)
+			std::cout << "Hierarchical depth test enabled\n";
+		else
+			std::cout << "Hierarchical depth test disabled\n";
+	}
+
+	void Renderer::ToggleMeshletCulling()
+	{
+		m_UseMeshletCulling = !m_UseMeshletCulling;
+		m_Statistics = {};
+		if (m_UseMeshletCulling)
+			std::cout << "Meshlet cone and frustum culling enabled\n";
+		else
+			std::cout << "Meshlet cone and frustum culling disabled\n";
+	}
+
+	void Renderer::ToggleDeferredShading()
+	{
+		m_UseDeferredShading = !m_UseDeferredShading;
+		if (m_UseDeferredShading)
+			std::cout << "Software rasterizer shades every visible pixel once after rasterization\n";
+		else
+			std::cout << "Software rasterizer shades every fragment that passes the depth test\n";
+	}
+
+	void Renderer::ToggleFramebufferLayout()
+	{
+		if (m_pFramebuffer->GetLayout() == FramebufferLayout::Linear)
+		{
+			m_pFramebuffer->SetLayout(FramebufferLayout::Tiled);
+			std::cout << "Software framebuffer stores color and depth in 8x8 pixel blocks\n";
+		}
+		else
+		{
+			m_pFramebuffer->SetLayout(FramebufferLayout::Linear);
+			std::cout << "Software framebuffer stores color and depth row by row\n";
+		}
+	}
+
+	void Renderer::ToggleTexelLayout()
+	{
+		m_TexelLayout = m_TexelLayout == Texture::TexelLayout::Tiled ? Texture::TexelLayout::Linear : Texture::TexelLayout::Tiled;
+		for (Mesh* pMesh : m_MeshPtrs)
+		{
+			pMesh->SetTexelLayout(m_TexelLayout);
+		}
+
+		if (m_TexelLayout == Texture::TexelLayout::Tiled)
+			std::cout << "Software textures store their texels in 4x4 blocks\n";
+		else
+			std::cout << "Software textures store their texels row by row\n";
+	}
+
+	void Renderer::ToggleStatistics()
+	{
+		m_PrintStatistics = !m_PrintStatistics;
+		m_Statistics = {};
+		if (m_PrintStatistics)
+			std::cout << "Started statistics printing\n";
+		else
+			std::cout << "Stopped statistics printing\n";
+	}
+
+	void Renderer::PrintStatistics()
+	{
+		if (!m_PrintStatistics || m_Statistics.nrFrames == 0)
+			return;
+
+		// Averages over all frames since the last print
+		const double nrFrames{ double(m_Statistics.nrFrames) };
+		const double nrDrawnMeshes{ std::max(double(m_Statistics.nrMeshes - m_Statistics.nrCulledMeshes), 1.0) };
+		if (m_UseDirectX)
+		{
+			std::cout << "HARDWARE: meshes drawn " << (m_Statistics.nrMeshes - m_Statistics.nrCulledMeshes) / nrFrames
+				<< " | culled " << m_Statistics.nrCulledMeshes / nrFrames
+				<< " | LOD " << m_Statistics.nrLodLevels / nrDrawnMeshes << " (" << uint64_t(m_Statistics.nrLodTriangles / nrFrames) << " triangles)\n";
+			m_Statistics = {};
+			return;
+		}
+
+		const char* layoutName{ m_pFramebuffer->GetLayout() == FramebufferLayout::Tiled ? TiledLayout::Name : LinearLayout::Name };
+		std::cout << "SOFTWARE: " << layoutName << " framebuffer"
+			<< " | " << (m_UseQuantizedVertices ? "quantized" : "float") << " vertex " << m_Statistics.vertexMs / nrFrames << "ms"
+			<< " (" << (m_Statistics.vertexMs > 0.0 ? m_Statistics.nrVertices / m_Statistics.vertexMs / 1000.0 : 0.0) << "M vertices/s)"
+			<< " | setup " << m_Statistics.setupMs / nrFrames << "ms"
+			<< " | raster " << m_Statistics.rasterMs / nrFrames << "ms"
+			<< " | meshes culled " << m_Statistics.nrCulledMeshes / nrFrames << " of " << m_Statistics.nrMeshes / nrFrames
+			<< " | LOD " << m_Statistics.nrLodLevels / nrDrawnMeshes << " (" << uint64_t(m_Statistics.nrLodTriangles / nrFrames) << " triangles)"
+			<< " | meshlets culled by cone " << uint64_t(m_Statistics.nrConeCulledMeshlets / nrFrames)
+			<< ", frustum " << uint64_t(m_Statistics.nrFrustumCulledMeshlets / nrFrames) << " of " << uint64_t(m_Statistics.nrMeshlets / nrFrames)
+			<< " | triangles submitted " << uint64_t(m_Statistics.nrSubmittedTriangles / nrFrames)
+			<< " | rasterized " << uint64_t(m_Statistics.nrTriangles / nrFrames)
+			<< " | culled " << uint64_t(m_Statistics.nrCulledTriangles / nrFrames)
+			<< " | clipped " << uint64_t(m_Statistics.nrClippedTriangles / nrFrames) << "\n";
+
+		if (m_Statistics.nrVisiblePixels > 0)
+		{
+			// Overdraw: how many times every visible pixel got shaded
+			std::cout << "SOFTWARE: " << (m_UseDeferredShading ? "deferred" : "forward") << " shading"
+				<< " | depth test passed " << uint64_t(m_Statistics.nrDepthPassedFragments / nrFrames)
+				<< " | shaded " << uint64_t(m_Statistics.nrShadedPixels / nrFrames)
+				<< " | visible " << uint64_t(m_Statistics.nrVisiblePixels / nrFrames)
+				<< " | overdraw " << double(m_Statistics.nrShadedPixels) / m_Statistics.nrVisiblePixels << "\n";
+		}
+
+		if (m_UseHiZ && m_Statistics.nrHiZCells > 0)
+		{
+			const double percentPerCell{ 100.0 / m_Statistics.nrHiZCells };
+			std::cout << "SOFTWARE: hierarchical depth rejected " << m_Statistics.nrHiZRejectedCells * percentPerCell << "%"
+				<< " and accepted " << m_Statistics.nrHiZAcceptedCells * percentPerCell << "% of " << uint64_t(m_Statistics.nrHiZCells / nrFrames) << " cells"
+				<< " | triangles rejected " << uint64_t(m_Statistics.nrHiZRejectedTriangles / nrFrames) << "\n";
+		}
+
+		if (m_ValidateRasterizer)
+		{
+			std::cout << "SOFTWARE: " << m_Statistics.nrMismatchedBlocks << " of " << m_Statistics.nrValidatedBlocks
+				<< " blocks differ from the scalar reference kernel\n";
+			std::cout << "SOFTWARE: " << uint64_t(m_Statistics.nrSharedEdges / nrFrames) << " shared edges"
+				<< " | double-hit pixels " << uint64_t(m_Statistics.nrDoubleHitPixels / nrFrames)
+				<< " | zero-hit pixels " << uint64_t(m_Statistics.nrZeroHitPixels / nrFrames) << "\n";
+		}
+
+		m_Statistics = {};
+	}
+
 	void Renderer::InitMeshes()
 	{
 		//Vehicle
 		EffectShaded* vehicleEffect{ new EffectShaded{ m_pDevice, L"Resources/PosCol3D.fx" } };
 
 		//Load textures
-		Texture* pDiffuse{ Texture::LoadFromFile("Resources/vehicle_diffuse.png", m_pDevice) };
-		Texture* pNormal{ Texture::LoadFromFile("Resources/vehicle_normal.png", m_pDevice) };
-		Texture* pSpecular{ Texture::LoadFromFile("Resources/vehicle_specular.png", m_pDevice) };
-		Texture* pGlossiness{ Texture::LoadFromFile("Resources/vehicle_gloss.png", m_pDevice) };
+		Texture* pDiffuse{ LoadTexture("Resources/vehicle_diffuse.png") };
+		Texture* pNormal{ LoadTexture("Resources/vehicle_normal.png") };
+		Texture* pSpecular{ LoadTexture("Resources/vehicle_specular.png") };
+		Texture* pGlossiness{ LoadTexture("Resources/vehicle_gloss.png") };
 
 		//Create vehicle
 		Mesh* pVehicle{ new Mesh{ m_pDevice, "Resources/vehicle.obj", vehicleEffect
-								, pDiffuse, pNormal, pSpecular, pGlossiness} };
+								, pDiffuse, pNormal, pSpecular, pGlossiness, {}, m_pThreadPool } };
 		m_MeshPtrs.push_back(pVehicle);
 
 
@@ -528,16 +1264,43 @@ namespace dae {
 		EffectTransparent* fireEffect{ new EffectTransparent{ m_pDevice, L"Resources/PartialCoverage.fx" } };
 
 		//Load textures
-		Texture* pFireDiffuse{ Texture::LoadFromFile("Resources/fireFX_diffuse.png", m_pDevice) };
+		Texture* pFireDiffuse{ LoadTexture("Resources/fireFX_diffuse.png") };
 
 		//Create fire
+		// Blended without depth writes, so its triangles keep the order of the file
+		MeshCache::LoadOptions fireLoadOptions{};
+		fireLoadOptions.preserveTriangleOrder = true;
 		Mesh* pFire{ new Mesh{ m_pDevice, "Resources/fireFX.obj", fireEffect, 
-							pFireDiffuse, nullptr, nullptr, nullptr	} };
+							pFireDiffuse, nullptr, nullptr, nullptr, fireLoadOptions, m_pThreadPool } };
 		m_MeshPtrs.push_back(pFire);
 
 
 	}
 
+	Texture* Renderer::LoadTexture(const std::string& path) const
+	{
+		// The block compressed version next to it, when the TextureCompressor made one from the image as it is now
+		// Files of other tools have no source hash, those are used when they are newer than the image. Without the image the file is used as it is
+		const std::string compressedPath{ std::filesystem::path{ path }.replace_extension(".dds").string() };
+		if (std::filesystem::exists(compressedPath))
+		{
+			const MappedFile source{ path };
+			uint64_t sourceHash{};
+			const bool isCurrent{ !source.IsOpen() || (Dds::ReadSourceHash(compressedPath, sourceHash)
+				&& (sourceHash != 0 ? sourceHash == source.GetHash() : std::filesystem::last_write_time(compressedPath) >= std::filesystem::last_write_time(path))) };
+			if (isCurrent)
+			{
+				if (Texture* pTexture{ Texture::LoadFromFile(compressedPath, m_pDevice) })
+					return pTexture;
+			}
+			else
+			{
+				std::cout << compressedPath << ": not compressed from the current " << path << ", run the TextureCompressor again\n";
+			}
+		}
+		return Texture::LoadFromFile(path, m_pDevice);
+	}
+
 	HRESULT Renderer::InitializeDirectX()
 	{
 		//1. Create Device & DeviceContext
@@ -657,62 +1420,209 @@ namespace dae {
 
 	void Renderer::LoadSampleState(const D3D11_FILTER& filter, ID3D11Device* device)
 	{
-		// Create the SampleState description
-		D3D11_SAMPLER_DESC sampleDesc{};
-		sampleDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-		sampleDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-		sampleDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-		sampleDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-		sampleDesc.MipLODBias = 0;
-		sampleDesc.MinLOD = 0;
-		sampleDesc.MaxLOD = D3D11_FLOAT32_MAX;
-		sampleDesc.MaxAnisotropy = 16;
-		sampleDesc.Filter = filter;
-
+		for (ID3D11SamplerState* pSamplerState : m_SamplerStatePtrs)
+		{
+			if (pSamplerState) pSamplerState->Release();
+		}
+		m_SamplerStatePtrs.assign(m_MeshPtrs.size(), nullptr);
 
-		if (m_pSamplerState) m_pSamplerState->Release();
+		for (size_t meshIdx{}; meshIdx < m_MeshPtrs.size(); ++meshIdx)
+		{
+			// Create the SampleState description, the address modes and border color come from the material
+			const Texture::Sampler& sampler{ m_MeshPtrs[meshIdx]->GetSampler() };
+			D3D11_SAMPLER_DESC sampleDesc{};
+			sampleDesc.AddressU = static_cast<D3D11_TEXTURE_ADDRESS_MODE>(sampler.addressU);
+			sampleDesc.AddressV = static_cast<D3D11_TEXTURE_ADDRESS_MODE>(sampler.addressV);
+			sampleDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+			sampleDesc.BorderColor[0] = sampler.borderColor.r;
+			sampleDesc.BorderColor[1] = sampler.borderColor.g;
+			sampleDesc.BorderColor[2] = sampler.borderColor.b;
+			sampleDesc.BorderColor[3] = 1.f;
+			sampleDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+			sampleDesc.MipLODBias = 0;
+			sampleDesc.MinLOD = 0;
+			sampleDesc.MaxLOD = D3D11_FLOAT32_MAX;
+			sampleDesc.MaxAnisotropy = 16;
+			sampleDesc.Filter = filter;
+
+			HRESULT result{ device->CreateSamplerState(&sampleDesc, &m_SamplerStatePtrs[meshIdx]) };
+			if (FAILED(result))
+				std::cout << "m_pSamplerState failed to load\n";
+
+			m_MeshPtrs[meshIdx]->SetSamplerState(m_SamplerStatePtrs[meshIdx]);
+		}
 
+	}
 
-		HRESULT result{ device->CreateSamplerState(&sampleDesc, &m_pSamplerState) };
-		if (FAILED(result))
-			std::cout << "m_pSamplerState failed to load\n";
+	template<typename Layout>
+	void dae::Renderer::ClearBackground(int left, int right, int bottom, int top, const Layout& layout) const
+	{
+		uint32_t clearColor{};
+		if (m_UsingUniformClearColor)
+			clearColor = SDL_MapRGB(m_pBackBuffer->format, 0.1f * 265, 0.1f * 265, 0.1f * 265);
+		else
+			clearColor = SDL_MapRGB(m_pBackBuffer->format, 0.39f * 265, 0.39f * 265, 0.39f * 265);
 
-		for (Mesh* pMesh : m_MeshPtrs)
+		uint32_t* pColorPixels{ m_pFramebuffer->GetColorPixels() };
+		for (int py{ bottom }; py < top; ++py)
 		{
-			pMesh->SetSamplerState(m_pSamplerState);
+			for (int px{ left }; px < right; ++px)
+			{
+				pColorPixels[layout.GetIndex(px, py)] = clearColor;
+			}
 		}
+	}
 
+	template<typename Layout>
+	void Renderer::UpdateHiZCell(int cellX, int cellY, const Layout& layout)
+	{
+		HiZCell& cell{ m_HiZCells[cellX + cellY * m_NrHiZCellsX] };
+		cell = { FLT_MAX, 0.f };
+
+		// Cells on the border of the screen only hold the pixels inside of it
+		const int right{ std::min((cellX + 1) * HiZSize, m_Width) };
+		const int top{ std::min((cellY + 1) * HiZSize, m_Height) };
+		const float* pDepthPixels{ m_pFramebuffer->GetDepthPixels() };
+		for (int py{ cellY * HiZSize }; py < top; ++py)
+		{
+			for (int px{ cellX * HiZSize }; px < right; ++px)
+			{
+				const float depth{ pDepthPixels[layout.GetIndex(px, py)] };
+				cell.minDepth = std::min(cell.minDepth, depth);
+				cell.maxDepth = std::max(cell.maxDepth, depth);
+			}
+		}
 	}
 
-	void dae::Renderer::ClearBackground() const
+	void Renderer::CheckWatertightness()
 	{
-		
-		if (m_UsingUniformClearColor)
-			SDL_FillRect(m_pBackBuffer, NULL, SDL_MapRGB(m_pBackBuffer->format, 0.1f * 265, 0.1f * 265, 0.1f * 265));
-		else
-			SDL_FillRect(m_pBackBuffer, NULL, SDL_MapRGB(m_pBackBuffer->format, 0.39f * 265, 0.39f * 265, 0.39f * 265));
+		// Every triangle that was set up, the second triangle on an edge gets checked against the first
+		// Edges are matched on their screen positions, so the ones along uv and normal seams count as shared as well
+		// The fan triangles of a clipped triangle share their inner edges, and the clipper gives the triangles on both sides
+		// of a clipped edge the exact same new vertex, so near plane and guard band edges get checked like any other
+		const auto getPositionKey{ [](const Vector2& position)
+			{
+				return uint64_t{ std::bit_cast<uint32_t>(position.x) } << 32 | std::bit_cast<uint32_t>(position.y);
+			} };
+
+		std::map<std::pair<uint64_t, uint64_t>, std::pair<uint32_t, int>> edgeTriangles{};
+
+		for (uint32_t triangleIdx{}; triangleIdx < m_TriangleScreenPositions.size(); ++triangleIdx)
+		{
+			const std::array<Vector2, 3>& positions{ m_TriangleScreenPositions[triangleIdx] };
+			for (int edgeIdx{}; edgeIdx < 3; ++edgeIdx)
+			{
+				const uint64_t positionKeyA{ getPositionKey(positions[(edgeIdx + 1) % 3]) };
+				const uint64_t positionKeyB{ getPositionKey(positions[(edgeIdx + 2) % 3]) };
+				if (positionKeyA == positionKeyB)
+					continue;
+
+				const std::pair edgeKey{ std::min(positionKeyA, positionKeyB), std::max(positionKeyA, positionKeyB) };
+
+				const auto [it, isFirst] { edgeTriangles.try_emplace(edgeKey, triangleIdx, edgeIdx) };
+				if (isFirst)
+					continue;
+
+				CheckSharedEdge(it->second.first, triangleIdx, it->second.second, edgeIdx);
+			}
+		}
 	}
 
-	Vertex_Out Renderer::NDCToScreen(const Vertex_Out& vtx) const
+	void Renderer::CheckFlyThroughFrame(uint64_t nrClippedTriangles, uint64_t nrDoubleHitPixels, uint64_t nrZeroHitPixels)
 	{
-		Vertex_Out vertex{ vtx };
-		vertex.position.x = (vtx.position.x + 1.f) * 0.5f * float(m_Width);
-		vertex.position.y = (1.f - vtx.position.y) * 0.5f * float(m_Height);
-		return vertex;
+		++m_FlyThroughResult.nrFrames;
+		m_FlyThroughResult.nrClippedTriangles += nrClippedTriangles;
+		m_FlyThroughResult.nrDoubleHitPixels += nrDoubleHitPixels;
+		m_FlyThroughResult.nrZeroHitPixels += nrZeroHitPixels;
+		if (nrDoubleHitPixels == 0 && nrZeroHitPixels == 0)
+			return;
+
+		++m_FlyThroughResult.nrFailedFrames;
+		std::cout << "SOFTWARE: fly-through frame " << m_FlyThroughResult.nrFrames << " with " << nrClippedTriangles << " clipped triangles"
+			<< " | double-hit pixels " << nrDoubleHitPixels << " | zero-hit pixels " << nrZeroHitPixels << "\n";
 	}
 
-	bool Renderer::IsInFrustum(const Vertex_Out& vtx)
+	void Renderer::CheckSharedEdge(uint32_t triangleIdx0, uint32_t triangleIdx1, int edgeIdx0, int edgeIdx1)
 	{
-		if (vtx.position.x < -1 || vtx.position.x > 1)
-			return false;
+		const TriangleSetup& triangle0{ m_Triangles[triangleIdx0] };
+		const TriangleSetup& triangle1{ m_Triangles[triangleIdx1] };
 
-		if (vtx.position.y < -1 || vtx.position.y > 1)
-			return  false;
+		// Exact edge functions of the rasterized positions, snapped in fixed point, positive inside
+		const auto getExactEdges{ [&](uint32_t triangleIdx, int px, int py, double(&edges)[3])
+			{
+				double screenX[3]{};
+				double screenY[3]{};
+				for (int i{}; i < 3; ++i)
+				{
+					const Vector2& position{ m_TriangleScreenPositions[triangleIdx][i] };
+					screenX[i] = m_RasterKernel.isFixedPoint ? std::llround(position.x * RasterKernels::FixedPointScale) / double(RasterKernels::FixedPointScale) : position.x;
+					screenY[i] = m_RasterKernel.isFixedPoint ? std::llround(position.y * RasterKernels::FixedPointScale) / double(RasterKernels::FixedPointScale) : position.y;
+				}
 
-		if (vtx.position.z < 0 || vtx.position.z > 1)
-			return  false;
+				const double area{ (screenX[1] - screenX[0]) * (screenY[2] - screenY[0]) - (screenY[1] - screenY[0]) * (screenX[2] - screenX[0]) };
+				const double windingSign{ area < 0.0 ? -1.0 : 1.0 };
+				for (int i{}; i < 3; ++i)
+				{
+					const int a{ (i + 1) % 3 };
+					const int b{ (i + 2) % 3 };
+					edges[i] = windingSign * ((screenX[b] - screenX[a]) * (py - screenY[a]) - (screenY[b] - screenY[a]) * (px - screenX[a]));
+				}
+			} };
 
-		return true;
+		// A pixel next to the shared edge, on the inside of the two other edges, has to be covered by exactly one of both
+		const auto isNextToSharedEdge{ [&](uint32_t triangleIdx, int edgeIdx, int px, int py)
+			{
+				double edges[3]{};
+				getExactEdges(triangleIdx, px, py, edges);
+				return edges[edgeIdx] >= 0.0 && edges[(edgeIdx + 1) % 3] > 0.0 && edges[(edgeIdx + 2) % 3] > 0.0;
+			} };
+
+		++m_Statistics.nrSharedEdges;
+
+		const int left{ std::max(triangle0.left, triangle1.left) };
+		const int right{ std::min(triangle0.right, triangle1.right) };
+		const int bottom{ std::max(triangle0.bottom, triangle1.bottom) };
+		const int top{ std::min(triangle0.top, triangle1.top) };
+		for (int py{ bottom }; py < top; ++py)
+		{
+			for (int px{ left }; px < right; ++px)
+			{
+				const bool isCovered0{ IsPixelCovered(triangle0, px, py) };
+				const bool isCovered1{ IsPixelCovered(triangle1, px, py) };
+
+				if (isCovered0 && isCovered1)
+					++m_Statistics.nrDoubleHitPixels;
+				else if (!isCovered0 && !isCovered1
+					&& (isNextToSharedEdge(triangleIdx0, edgeIdx0, px, py) || isNextToSharedEdge(triangleIdx1, edgeIdx1, px, py)))
+					++m_Statistics.nrZeroHitPixels;
+			}
+		}
+	}
+
+	bool Renderer::IsPixelCovered(const TriangleSetup& triangle, int px, int py) const
+	{
+		// Same test as the kernels, exact for fixed point, the float one can differ from the stepped edges in the last bits
+		if (m_RasterKernel.isFixedPoint)
+		{
+			for (int i{}; i < 3; ++i)
+			{
+				const int64_t edge{ triangle.fixedEdgeStart[i] + triangle.fixedEdgeStepX[i] * (px - triangle.left) + triangle.fixedEdgeStepY[i] * (py - triangle.bottom) };
+				if (edge < 0)
+					return false;
+			}
+			return true;
+		}
+
+		const Vector3 edges{ triangle.edgeStart + triangle.edgeStepX * float(px - triangle.left) + triangle.edgeStepY * float(py - triangle.bottom) };
+		return edges.x > 0.f && edges.y > 0.f && edges.z > 0.f;
+	}
+
+	Vector2 Renderer::ClipToScreen(const Vector4& position) const
+	{
+		// Perspective divide, then NDC to screen
+		const float ndcX{ position.x / position.w };
+		const float ndcY{ position.y / position.w };
+		return Vector2{ (ndcX + 1.f) * 0.5f * float(m_Width), (1.f - ndcY) * 0.5f * float(m_Height) };
 	}
 
 	void Renderer::DepthRemap(float& depth, float topPercentile) const
@@ -723,7 +1633,7 @@ namespace dae {
 		depth = std::min(1.f, depth);
 	}
 
-	ColorRGB Renderer::PixelShading(Vertex_Out v, const Mesh& mesh) const
+	ColorRGB Renderer::PixelShading(Vertex_Out v, const Vector2& uvDdx, const Vector2& uvDdy, const Mesh& mesh) const
 	{
 		// Light settings
 		const Vector3 lightDirection{ 0.577f, -0.577f, 0.577f };
@@ -733,12 +1643,15 @@ namespace dae {
 
 		if (m_UseNormalMap)
 		{
-			const Vector3 biNormal = Vector3::Cross(v.normal, v.tangent);
-			const Matrix tangentSpaceAxis = { v.tangent, biNormal, v.normal, Vector3::Zero };
+			const Vector3 tangent{ v.tangent.GetXYZ() };
+			const Vector3 biNormal = Vector3::Cross(v.normal, tangent) * (v.tangent.w < 0.f ? -1.f : 1.f);
+			const Matrix tangentSpaceAxis = { tangent, biNormal, v.normal, Vector3::Zero };
 
-			const ColorRGB normalColor = mesh.GetNormal()->Sample(v.uv);
+			const ColorRGB normalColor = mesh.GetNormal()->Sample(v.uv, uvDdx, uvDdy, mesh.GetSampler());
 			Vector3 sampledNormal = { normalColor.r, normalColor.g, normalColor.b };
 			sampledNormal = 2.f * sampledNormal - Vector3{ 1.f, 1.f, 1.f };
+			if (mesh.GetNormal()->HasTwoChannels())
+				sampledNormal.z = sqrtf(std::max(1.f - sampledNormal.x * sampledNormal.x - sampledNormal.y * sampledNormal.y, 0.f));
 
 			sampledNormal = tangentSpaceAxis.TransformVector(sampledNormal);
 
@@ -751,15 +1664,15 @@ namespace dae {
 		ObservedArea = std::max(ObservedArea, 0.f);
 
 		// DIFFUSE
-		const ColorRGB TextureColor{ mesh.GetDiffuse()->Sample(v.uv) / PI};
+		const ColorRGB TextureColor{ mesh.GetDiffuse()->Sample(v.uv, uvDdx, uvDdy, mesh.GetSampler()) / PI};
 
 		// SPECULAR
 		const Vector3 reflect{ Vector3::Reflect(-lightDirection, v.normal) };
 		float cosAlpha{ Vector3::Dot(reflect, v.viewDirection) };
 		cosAlpha = std::max(0.f, cosAlpha);
-		const float specularExp{ specularShininess * mesh.GetGlossiness()->Sample(v.uv).r };
+		const float specularExp{ specularShininess * mesh.GetGlossiness()->Sample(v.uv, uvDdx, uvDdy, mesh.GetSampler()).r };
 
-		const ColorRGB specular{ mesh.GetSpecular()->Sample(v.uv) * powf(cosAlpha, specularExp)};
+		const ColorRGB specular{ mesh.GetSpecular()->Sample(v.uv, uvDdx, uvDdy, mesh.GetSampler()) * powf(cosAlpha, specularExp)};
 
 		ColorRGB finalColor{ 0,0,0 };
 
@@ -1,5 +1,9 @@
 #pragma once
 #include "DataTypes.h"
+#include "Texture.h"
+#include "RasterKernels.h"
+#include "VertexKernels.h"
+#include <array>
 
 struct SDL_Window;
 struct SDL_Surface;
@@ -9,6 +13,8 @@ namespace dae
 
 	class Mesh;
 	class Camera;
+	class ThreadPool;
+	class Framebuffer;
 
 	class Renderer final
 	{
@@ -22,30 +28,110 @@ namespace dae
 		Renderer& operator=(Renderer&&) noexcept = delete;
 
 		void Update(const Timer* pTimer);
-		void Render() const;
+		void Render();
 
 		//COMBINED
 		void ToggleDirectX();
 		void ToggleRotation();
 		void CycleCullModes();
 		void ToggleUniformClearColor();
-		//HARDWARE
+		void ToggleCameraFlyThrough();
+		void ToggleQuantizedVertices();
+		void CycleLodMode();
+		// Cycles the filter of the renderer that is in use
 		void ToggleFilteringMethod();
+		//HARDWARE
 		void ToggleFireRendering();
 		//SOFTWARE
 		void CycleShadingMode();
 		void ToggleNormalMap();
 		void ToggleDepthBufferVisualization();
 		void ToggleBoundingBoxVisualization();
+		void CycleThreadCount();
+		void CycleRasterKernel();
+		void ToggleFixedPointRasterization();
+		void ToggleRasterizerValidation();
+		void ToggleHierarchicalDepth();
+		void ToggleDeferredShading();
+		void ToggleFramebufferLayout();
+		void ToggleTexelLayout();
+		void ToggleMeshletCulling();
+		void ToggleStatistics();
+		void PrintStatistics();
+
+		//BENCHMARKS AND TESTS
+		// Summed over the frames since the last print or reset, printed as averages
+		struct Statistics
+		{
+			uint32_t nrFrames{};
+			// Meshes outside of the frustum are neither transformed nor drawn
+			uint64_t nrMeshes{};
+			uint64_t nrCulledMeshes{};
+			// Summed over the drawn meshes: the level of detail they used and its triangles
+			uint64_t nrLodLevels{};
+			uint64_t nrLodTriangles{};
+			double vertexMs{};
+			double setupMs{};
+			double rasterMs{};
+			uint64_t nrVertices{};
+			uint64_t nrMeshlets{};
+			uint64_t nrConeCulledMeshlets{};
+			uint64_t nrFrustumCulledMeshlets{};
+			// Triangles of the meshlets that were not culled, the ones that were set up for the rasterizer
+			uint64_t nrSubmittedTriangles{};
+			uint64_t nrTriangles{};
+			uint64_t nrCulledTriangles{};
+			uint64_t nrClippedTriangles{};
+			uint64_t nrValidatedBlocks{};
+			uint64_t nrMismatchedBlocks{};
+			uint64_t nrSharedEdges{};
+			uint64_t nrDoubleHitPixels{};
+			uint64_t nrZeroHitPixels{};
+			uint64_t nrHiZCells{};
+			uint64_t nrHiZRejectedCells{};
+			uint64_t nrHiZAcceptedCells{};
+			uint64_t nrHiZRejectedTriangles{};
+			uint64_t nrDepthPassedFragments{};
+			uint64_t nrShadedPixels{};
+			uint64_t nrVisiblePixels{};
+		};
+		const Statistics& GetStatistics() const { return m_Statistics; }
+		void ResetStatistics() { m_Statistics = {}; }
+
+		// The fly-through validates every frame, frames with holes or overlaps are reported as they happen
+		struct FlyThroughResult
+		{
+			uint64_t nrFrames{};
+			uint64_t nrFailedFrames{};
+			uint64_t nrClippedTriangles{};
+			uint64_t nrDoubleHitPixels{};
+			uint64_t nrZeroHitPixels{};
+		};
+		// Since the fly-through was started
+		const FlyThroughResult& GetFlyThroughResult() const { return m_FlyThroughResult; }
+
+		void SetThreadCount(uint32_t threadCount);
+		void SetCameraOrigin(const Vector3& origin);
+		// The vertex kernel uses the same instruction set as the raster kernel
+		void SetKernels(RasterKernelType type, bool isFixedPoint);
+		// -1 picks the level of detail by distance, like CycleLodMode
+		void SetForcedLod(int lodIdx);
 	private:
-		void RenderDirectX() const;
-		void RenderSoftware() const;
+		void RenderDirectX();
+		void RenderSoftware();
 
 		void InitMeshes();
+		// Prefers a .dds with the same name, the software sampler decodes its blocks on demand
+		Texture* LoadTexture(const std::string& path) const;
 
 		bool m_UseDirectX{ true };
 		bool m_UsingUniformClearColor{ false };
 		bool m_RenderFire{ true };
+		bool m_UseQuantizedVertices{ false };
+		// -1 picks the level of detail of every mesh by its distance, otherwise every mesh uses this level or its coarsest one
+		int m_ForcedLod{ -1 };
+		// How far, in pixels, a level of detail may move the surface on screen
+		static constexpr float MaxLodPixelError{ 1.f };
 
 		SDL_Window* m_pWindow{};
 
@@ -57,7 +143,8 @@ namespace dae
 		std::vector<Mesh*> m_MeshPtrs{};
 		Camera* m_pCamera{ nullptr };
 
-		ID3D11SamplerState* m_pSamplerState{ nullptr };
+		// One per mesh, with the address modes of its material
+		std::vector<ID3D11SamplerState*> m_SamplerStatePtrs{};
 		ID3D11Device* m_pDevice{ nullptr };
 		ID3D11DeviceContext* m_pDeviceContext{ nullptr };
 		IDXGISwapChain* m_pSwapChain{ nullptr };
@@ -84,11 +171,37 @@ namespace dae
 		void LoadSampleState(const D3D11_FILTER& filter, ID3D11Device* device);
 
 		//SOFTWARE
-		void ClearBackground() const;
-		Vertex_Out NDCToScreen(const Vertex_Out& vtx) const;
-		static bool IsInFrustum(const Vertex_Out& vtx);
+		// The software sampler picks mip levels too, point filtering does not mean full resolution
+		Texture::Filter m_TextureFilter{ Texture::Filter::Point };
+		// Every texture fits in the cache of a desktop CPU, there the tiled index costs more than its locality gains
+		Texture::TexelLayout m_TexelLayout{ Texture::TexelLayout::Linear };
+		void CycleTextureFilter();
+
+		//SOFTWARE
+		void CullMeshlets(const Mesh& mesh);
+		void SetupTriangles(std::span<const uint32_t> indices, std::span<const Vertex_Out> vertices_out);
+		void SetupTriangle(const Vertex_Out& vertex0, const Vertex_Out& vertex1, const Vertex_Out& vertex2);
+		void BinTriangles();
+		template<typename Layout>
+		void RenderTiles(const Mesh& mesh, const Layout& layout);
+		template<typename Layout>
+		void RenderTile(uint32_t tileIdx, const Mesh& mesh, const Layout& layout);
+		template<typename Layout>
+		uint64_t ShadeTile(int left, int right, int bottom, int top, const Mesh& mesh, const Layout& layout) const;
+		ColorRGB ShadePixel(const TriangleSetup& triangle, const VisibilitySample& sample, float z, int px, int py, const Mesh& mesh) const;
+		template<typename Layout>
+		void WritePixel(int px, int py, ColorRGB color, const Layout& layout) const;
+		template<typename Layout>
+		void ClearBackground(int left, int right, int bottom, int top, const Layout& layout) const;
+		template<typename Layout>
+		void UpdateHiZCell(int cellX, int cellY, const Layout& layout);
+		void CheckWatertightness();
+		void CheckSharedEdge(uint32_t triangleIdx0, uint32_t triangleIdx1, int edgeIdx0, int edgeIdx1);
+		void CheckFlyThroughFrame(uint64_t nrClippedTriangles, uint64_t nrDoubleHitPixels, uint64_t nrZeroHitPixels);
+		bool IsPixelCovered(const TriangleSetup& triangle, int px, int py) const;
+		Vector2 ClipToScreen(const Vector4& position) const;
 		void DepthRemap(float& depth, float topPercentile) const;
-		ColorRGB PixelShading(Vertex_Out v, const Mesh& mesh) const;
+		ColorRGB PixelShading(Vertex_Out v, const Vector2& uvDdx, const Vector2& uvDdy, const Mesh& mesh) const;
 
 		enum class CullMode
 		{
@@ -116,7 +229,80 @@ namespace dae
 		SDL_Surface* m_pFrontBuffer{ nullptr };
 		SDL_Surface* m_pBackBuffer{ nullptr };
 		uint32_t* m_pBackBufferPixels{};
-		float* m_pDepthBufferPixels{};
+
+		// Color and depth are rendered in the layout of the framebuffer, every tile is resolved to the back buffer when it is done
+		Framebuffer* m_pFramebuffer{ nullptr };
+
+		// Sort-middle: triangles are set up once, binned per screen tile and every tile is rasterized by one worker
+		// A worker only touches the pixels of its own tile, so the buffers need no locking
+		static constexpr int TileSize{ 64 };
+		int m_NrTilesX{};
+		int m_NrTilesY{};
+		std::vector<TriangleSetup> m_Triangles{};
+		std::vector<std::vector<uint32_t>> m_TileBins{};
+		ThreadPool* m_pThreadPool{ nullptr };
+
+		// Parts of the index buffer that survived the meshlet culling, neighbouring meshlets are merged into one range
+		// Backfacing meshlets are only culled when the cull mode would cull all of their triangles anyway
+		struct IndexRange
+		{
+			uint32_t firstIndex{};
+			uint32_t nrIndices{};
+		};
+		std::vector<IndexRange> m_IndexRanges{};
+		bool m_UseMeshletCulling{ true };
+
+		// Triangles are clipped to the near and far plane, but only to the guard band at the sides:
+		// 8 times the screen size keeps the edge functions precise, the scissor cuts off the rest
+		static constexpr float GuardBand{ 8.f };
+		ScissorRect m_Scissor{};
+
+		RasterKernel m_RasterKernel{};
+		VertexKernel m_VertexKernel{};
+		// Compares every block with the scalar reference kernel and checks the shared edges for holes and overlaps
+		bool m_ValidateRasterizer{ false };
+		// The screen positions of every triangle in m_Triangles, only while validating, clipped ones included
+		std::vector<std::array<Vector2, 3>> m_TriangleScreenPositions{};
+
+		FlyThroughResult m_FlyThroughResult{};
+		bool m_WasValidatingBeforeFlyThrough{ false };
+
+		// Hierarchical depth: the nearest and farthest depth of every 8x8 pixels
+		// Triangles are tested against it before any pixel work, the cells they wrote to are refreshed afterwards
+		static constexpr int HiZSize{ 8 };
+		static constexpr int NrHiZCellsPerTile{ TileSize / HiZSize };
+		static_assert(NrHiZCellsPerTile * NrHiZCellsPerTile <= 64, "The cells of a tile have to fit in a 64 bit mask");
+		struct HiZCell
+		{
+			float minDepth{ FLT_MAX };
+			float maxDepth{ FLT_MAX };
+		};
+		int m_NrHiZCellsX{};
+		std::vector<HiZCell> m_HiZCells{};
+		bool m_UseHiZ{ true };
+
+		// Deferred shading: rasterization only stores which triangle is visible where, every pixel is shaded once afterwards
+		// A sample is only valid where the depth buffer was written this frame, it is stored in the framebuffer layout
+		std::vector<VisibilitySample> m_VisibilityBuffer{};
+		bool m_UseDeferredShading{ false };
+
+		// Filled by the worker of that tile, summed into the frame statistics afterwards
+		struct TileStatistics
+		{
+			uint64_t nrValidatedBlocks{};
+			uint64_t nrMismatchedBlocks{};
+			uint64_t nrHiZCells{};
+			uint64_t nrHiZRejectedCells{};
+			uint64_t nrHiZAcceptedCells{};
+			uint64_t nrHiZRejectedTriangles{};
+			uint64_t nrDepthPassedFragments{};
+			uint64_t nrShadedPixels{};
+			uint64_t nrVisiblePixels{};
+		};
+		std::vector<TileStatistics> m_TileStatistics{};
+
+		Statistics m_Statistics{};
+		bool m_PrintStatistics{ false };
 
 
 	};
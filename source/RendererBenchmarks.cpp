@@ -0,0 +1,73 @@
+#include "pch.h"
+#include "Benchmarks.h"
+#include "Renderer.h"
+#include <thread>
+
+namespace dae
+{
+	void Benchmarks::RunTriangleSetup(SDL_Window* pWindow)
+	{
+		// The vehicle from the start view, on one thread with the scalar kernel to compare with the old per pixel loop,
+		// then on every thread with the best kernel
+		Renderer renderer{ pWindow };
+		renderer.ToggleDirectX();
+		Timer timer{};
+
+		const uint32_t maxThreads{ std::max(std::thread::hardware_concurrency(), 1u) };
+		const RasterKernelType bestType{ RasterKernels::GetBestSupportedType() };
+		const std::pair<uint32_t, RasterKernelType> runs[]{ { 1, RasterKernelType::Scalar }, { maxThreads, bestType } };
+		for (const auto& [nrThreads, type] : runs)
+		{
+			renderer.SetThreadCount(nrThreads);
+			renderer.SetKernels(type, true);
+
+			constexpr int nrFrames{ 100 };
+			if (!RenderFrames(renderer, timer, nrFrames))
+				return;
+
+			const Renderer::Statistics& statistics{ renderer.GetStatistics() };
+			std::cout << RasterKernels::GetName(type) << " on " << nrThreads << " threads:"
+				<< " setup " << statistics.setupMs / nrFrames << "ms"
+				<< " (" << statistics.nrTriangles / statistics.setupMs / 1000.0 << "M triangles/s)"
+				<< " | raster " << statistics.rasterMs / nrFrames << "ms"
+				<< " (" << statistics.nrDepthPassedFragments / statistics.rasterMs / 1000.0 << "M fragments/s)\n";
+		}
+	}
+
+	void Benchmarks::RunLodSweep(SDL_Window* pWindow)
+	{
+		// The camera backs away from the vehicle up to the far plane, every level of detail is forced in turn
+		// and the one picked by the distance is printed with them
+		Renderer renderer{ pWindow };
+		renderer.ToggleDirectX();
+		Timer timer{};
+
+		constexpr float vehicleZ{ 50.f };
+		constexpr int nrFrames{ 50 };
+		for (const float distance : { 10.f, 20.f, 35.f, 50.f, 65.f, 80.f, 95.f })
+		{
+			renderer.SetCameraOrigin({ 0.f, 0.f, vehicleZ - distance });
+
+			renderer.SetForcedLod(-1);
+			if (!RenderFrames(renderer, timer, nrFrames))
+				return;
+
+			std::cout << "distance " << distance << ": picked LOD " << renderer.GetStatistics().nrLodLevels / double(nrFrames);
+			for (int lodIdx{}; ; ++lodIdx)
+			{
+				renderer.SetForcedLod(lodIdx);
+				if (!RenderFrames(renderer, timer, nrFrames))
+					return;
+
+				// Forcing a level the vehicle does not have gives its coarsest one again
+				const Renderer::Statistics& statistics{ renderer.GetStatistics() };
+				if (statistics.nrLodLevels != uint64_t(lodIdx) * nrFrames)
+					break;
+
+				std::cout << " | LOD " << lodIdx << " (" << statistics.nrLodTriangles / nrFrames << " triangles) "
+					<< (statistics.vertexMs + statistics.setupMs + statistics.rasterMs) / nrFrames << "ms";
+			}
+			std::cout << '\n';
+		}
+	}
+}
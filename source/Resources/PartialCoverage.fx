@@ -2,6 +2,10 @@ Texture2D gDiffuseMap	: DiffuseMap;
 
 float4x4 gWorldViewProj : WorldViewProjection;
 
+// Positions are quantized over the mesh bounds: position = gPositionOffset + unorm * gPositionExtent
+float3 gPositionOffset;
+float3 gPositionExtent;
+
 
 SamplerState gSamState
 {
@@ -62,7 +66,16 @@ struct VS_INPUT
 	float3 Position			: POSITION;
 	float2 UV				: TEXCOORD;
 	float3 Normal			: NORMAL;
-	float3 Tangent			: TANGENT;
+	float4 Tangent			: TANGENT;
+};
+
+// VertexD11Quantized, unorm position with the tangent handedness in w, octahedral snorm normal and tangent, half float uv
+struct VS_QUANTIZED_INPUT
+{
+	float4 Position			: POSITION;
+	float2 Normal			: NORMAL;
+	float2 Tangent			: TANGENT;
+	float2 UV				: TEXCOORD;
 };
 
 struct VS_OUTPUT
@@ -85,6 +98,26 @@ VS_OUTPUT VS(VS_INPUT input)
 }
 
 
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 direction = float3(encoded, 1.f - abs(encoded.x) - abs(encoded.y));
+	float fold = saturate(-direction.z);
+	direction.xy -= (direction.xy >= 0.f ? fold : -fold);
+	return normalize(direction);
+}
+
+VS_OUTPUT VS_Quantized(VS_QUANTIZED_INPUT input)
+{
+	VS_INPUT decoded		= (VS_INPUT)0;
+	decoded.Position		= gPositionOffset + input.Position.xyz * gPositionExtent;
+	decoded.UV				= input.UV;
+	decoded.Normal			= DecodeOctahedral(input.Normal);
+	decoded.Tangent			= float4(DecodeOctahedral(input.Tangent), input.Position.w * 2.f - 1.f);
+
+	return VS(decoded);
+}
+
+
 //------------------------------------------------------
 //	Pixel Shader
 //------------------------------------------------------
@@ -110,6 +143,19 @@ technique11 DefaultTechnique
 	}
 }
 
+technique11 QuantizedTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_Quantized()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
+}
+
 
 
 
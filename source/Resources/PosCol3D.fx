@@ -3,10 +3,17 @@ Texture2D gNormalMap	: NormalMap;
 Texture2D gSpecularMap	: SpecularMap;
 Texture2D gGlossinessMap: GlossinessMap;
 
+// BC5 normal maps only store x and y, z is rebuilt from the unit length
+bool gNormalMapHasTwoChannels = false;
+
 float4x4 gWorldViewProj : WorldViewProjection;
 float4x4 gWorldMatrix	: WorldMarix;
 float4x4 gViewInverseMatrix	: ViewInverseMarix;
 
+// Positions are quantized over the mesh bounds: position = gPositionOffset + unorm * gPositionExtent
+float3 gPositionOffset;
+float3 gPositionExtent;
+
 float gPI = 3.14159265359f;
 float gLightIntensity = 7.0f;
 float gShininess = 25.0f;
@@ -75,7 +82,16 @@ struct VS_INPUT
 	float3 Position			: POSITION;
 	float2 UV				: TEXCOORD;
 	float3 Normal			: NORMAL;
-	float3 Tangent			: TANGENT;
+	float4 Tangent			: TANGENT;
+};
+
+// VertexD11Quantized, unorm position with the tangent handedness in w, octahedral snorm normal and tangent, half float uv
+struct VS_QUANTIZED_INPUT
+{
+	float4 Position			: POSITION;
+	float2 Normal			: NORMAL;
+	float2 Tangent			: TANGENT;
+	float2 UV				: TEXCOORD;
 };
 
 struct VS_OUTPUT
@@ -84,7 +100,7 @@ struct VS_OUTPUT
 	float4 WorldPosition	: WORLD_POS;
 	float2 UV				: TEXCOORD;
 	float3 Normal			: NORMAL;
-	float3 Tangent			: TANGENT;
+	float4 Tangent			: TANGENT;
 };
 
 
@@ -98,23 +114,45 @@ VS_OUTPUT VS(VS_INPUT input)
 	output.WorldPosition	= mul(float4(input.Position, 1.f), gWorldMatrix);
 	output.UV				= input.UV;
 	output.Normal			= mul(normalize(input.Normal), (float3x3)gWorldMatrix);
-	output.Tangent			= mul(normalize(input.Tangent), (float3x3)gWorldMatrix);
+	output.Tangent			= float4(mul(normalize(input.Tangent.xyz), (float3x3)gWorldMatrix), input.Tangent.w);
 
 	return output;
 }
 
 
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 direction = float3(encoded, 1.f - abs(encoded.x) - abs(encoded.y));
+	float fold = saturate(-direction.z);
+	direction.xy -= (direction.xy >= 0.f ? fold : -fold);
+	return normalize(direction);
+}
+
+VS_OUTPUT VS_Quantized(VS_QUANTIZED_INPUT input)
+{
+	VS_INPUT decoded		= (VS_INPUT)0;
+	decoded.Position		= gPositionOffset + input.Position.xyz * gPositionExtent;
+	decoded.UV				= input.UV;
+	decoded.Normal			= DecodeOctahedral(input.Normal);
+	decoded.Tangent			= float4(DecodeOctahedral(input.Tangent), input.Position.w * 2.f - 1.f);
+
+	return VS(decoded);
+}
+
+
 //------------------------------------------------------
 //	Pixel Shader
 //------------------------------------------------------
 
 float4 PS(VS_OUTPUT input) : SV_TARGET
 {
-	float3 binormal = cross(input.Normal, input.Tangent);
-	float4x4 tangentSpaceAxis = float4x4(float4(input.Tangent, 0.0f), float4(binormal, 0.0f), float4(input.Normal, 0.0), float4(0.0f, 0.0f, 0.0f, 1.0f));
+	float3 binormal = cross(input.Normal, input.Tangent.xyz) * (input.Tangent.w < 0.f ? -1.f : 1.f);
+	float4x4 tangentSpaceAxis = float4x4(float4(input.Tangent.xyz, 0.0f), float4(binormal, 0.0f), float4(input.Normal, 0.0), float4(0.0f, 0.0f, 0.0f, 1.0f));
 
 	float3 newNormal = gNormalMap.Sample(gSamState, input.UV);
 	newNormal = 2.f * newNormal - float3( 1.f, 1.f, 1.f );
+	if (gNormalMapHasTwoChannels)
+		newNormal.z = sqrt(saturate(1.f - dot(newNormal.xy, newNormal.xy)));
 
 	newNormal = normalize(mul(newNormal, tangentSpaceAxis));
 
@@ -156,3 +194,16 @@ technique11 DefaultTechnique
 		SetPixelShader(CompileShader(ps_5_0, PS()));
 	}
 }
+
+technique11 QuantizedTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_Quantized()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
+}
@@ -0,0 +1,236 @@
+#include "pch.h"
+#include "Tangents.h"
+#include "ThreadPool.h"
+
+#include <cfloat>
+
+namespace dae
+{
+	namespace
+	{
+		// Below this handing out the ranges costs more than the work
+		constexpr size_t MinTrianglesPerRange{ 16 * 1024 };
+
+		// Splits [0, count[ into nrRanges contiguous ranges that the pool hands out, the calling thread helps out
+		template<typename Function>
+		void ParallelForRanges(ThreadPool* pThreadPool, size_t count, size_t nrRanges, const Function& function)
+		{
+			if (nrRanges == 1)
+			{
+				function(size_t(0), count);
+				return;
+			}
+
+			pThreadPool->ParallelFor(uint32_t(nrRanges), [&](uint32_t rangeIdx)
+				{
+					function(count * rangeIdx / nrRanges, count * (rangeIdx + 1) / nrRanges);
+				});
+		}
+
+		bool IsZero(float value)
+		{
+			return std::abs(value) <= FLT_MIN;
+		}
+
+		// Any unit vector perpendicular to the normal, for vertices without a usable uv direction
+		Vector3 GetPerpendicular(const Vector3& normal)
+		{
+			const Vector3 axis{ std::abs(normal.x) < 0.5f ? Vector3::UnitX : Vector3::UnitY };
+			const Vector3 perpendicular{ axis - normal * Vector3::Dot(axis, normal) };
+			const float length{ perpendicular.Magnitude() };
+			return IsZero(length) ? Vector3::UnitX : perpendicular / length;
+		}
+
+		// The old ParseOBJ tangents, faces with degenerate uvs are skipped instead of adding infinities
+		void GenerateAccumulated(const std::vector<uint32_t>& indices, std::vector<Vertex>& vertices)
+		{
+			std::vector<Vector3> sums(vertices.size());
+			for (size_t idx{}; idx < indices.size(); idx += 3)
+			{
+				const Vertex& v0{ vertices[indices[idx]] };
+				const Vertex& v1{ vertices[indices[idx + 1]] };
+				const Vertex& v2{ vertices[indices[idx + 2]] };
+
+				const Vector3 edge0{ v1.position - v0.position };
+				const Vector3 edge1{ v2.position - v0.position };
+				const Vector2 diffX{ v1.uv.x - v0.uv.x, v2.uv.x - v0.uv.x };
+				const Vector2 diffY{ v1.uv.y - v0.uv.y, v2.uv.y - v0.uv.y };
+				const float determinant{ Vector2::Cross(diffX, diffY) };
+				if (IsZero(determinant))
+					continue;
+
+				const Vector3 tangent{ (edge0 * diffY.y - edge1 * diffY.x) * (1.f / determinant) };
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					sums[indices[idx + corner]] += tangent;
+				}
+			}
+
+			for (size_t vertexIdx{}; vertexIdx < vertices.size(); ++vertexIdx)
+			{
+				Vertex& vertex{ vertices[vertexIdx] };
+				const Vector3 rejected{ Vector3::Reject(sums[vertexIdx], vertex.normal) };
+				const float length{ rejected.Magnitude() };
+				vertex.tangent = Vector4{ IsZero(length) ? GetPerpendicular(vertex.normal) : rejected / length, 1.f };
+			}
+		}
+
+		// Per face: the u direction and the handedness, per corner: that direction in the tangent plane of the vertex,
+		// weighted by the angle of the corner. Written per corner, so every thread owns the triangles of its range
+		void ComputeCornerTangents(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+			std::vector<Vector3>& cornerTangents, std::vector<int8_t>& faceSigns, size_t firstTriangle, size_t lastTriangle)
+		{
+			for (size_t triangleIdx{ firstTriangle }; triangleIdx < lastTriangle; ++triangleIdx)
+			{
+				const uint32_t* pIndices{ &indices[triangleIdx * 3] };
+				const Vertex* pVertices[3]{ &vertices[pIndices[0]], &vertices[pIndices[1]], &vertices[pIndices[2]] };
+
+				const Vector3 edge0{ pVertices[1]->position - pVertices[0]->position };
+				const Vector3 edge1{ pVertices[2]->position - pVertices[0]->position };
+				const Vector2 diffX{ pVertices[1]->uv.x - pVertices[0]->uv.x, pVertices[2]->uv.x - pVertices[0]->uv.x };
+				const Vector2 diffY{ pVertices[1]->uv.y - pVertices[0]->uv.y, pVertices[2]->uv.y - pVertices[0]->uv.y };
+				const float determinant{ Vector2::Cross(diffX, diffY) };
+
+				// Degenerate uvs give no direction, such faces do not vote
+				const int8_t sign{ IsZero(determinant) ? int8_t(0) : determinant > 0.f ? int8_t(1) : int8_t(-1) };
+				faceSigns[triangleIdx] = sign;
+
+				Vector3 faceTangent{ (edge0 * diffY.y - edge1 * diffY.x) * float(sign) };
+				const float faceLength{ faceTangent.Magnitude() };
+				if (!IsZero(faceLength))
+					faceTangent /= faceLength;
+
+				for (int corner{}; corner < 3; ++corner)
+				{
+					Vector3& cornerTangent{ cornerTangents[triangleIdx * 3 + corner] };
+					cornerTangent = Vector3::Zero;
+					if (sign == 0)
+						continue;
+
+					const Vector3& normal{ pVertices[corner]->normal };
+					const Vector3 projected{ faceTangent - normal * Vector3::Dot(normal, faceTangent) };
+					const float projectedLength{ projected.Magnitude() };
+					if (IsZero(projectedLength))
+						continue;
+
+					// The angle between the two edges of the corner, both flattened onto the tangent plane
+					Vector3 toNext{ pVertices[(corner + 1) % 3]->position - pVertices[corner]->position };
+					Vector3 toPrevious{ pVertices[(corner + 2) % 3]->position - pVertices[corner]->position };
+					toNext -= normal * Vector3::Dot(normal, toNext);
+					toPrevious -= normal * Vector3::Dot(normal, toPrevious);
+					const float lengths{ toNext.Magnitude() * toPrevious.Magnitude() };
+					if (IsZero(lengths))
+						continue;
+
+					const float angle{ std::acos(std::clamp(Vector3::Dot(toNext, toPrevious) / lengths, -1.f, 1.f)) };
+					cornerTangent = projected * (angle / projectedLength);
+				}
+			}
+		}
+
+		Tangents::Result GenerateMikkTSpace(std::vector<uint32_t>& indices, std::vector<Vertex>& vertices, ThreadPool* pThreadPool, size_t nrRanges)
+		{
+			const size_t nrTriangles{ indices.size() / 3 };
+			std::vector<Vector3> cornerTangents(indices.size());
+			std::vector<int8_t> faceSigns(nrTriangles);
+			ParallelForRanges(pThreadPool, nrTriangles, nrRanges, [&](size_t first, size_t last)
+				{
+					ComputeCornerTangents(indices, vertices, cornerTangents, faceSigns, first, last);
+				});
+
+			// A vertex on a mirror seam gets a copy for the faces with the negative handedness,
+			// faces with degenerate uvs keep the original one
+			constexpr uint8_t positiveBit{ 1 };
+			constexpr uint8_t negativeBit{ 2 };
+			std::vector<uint8_t> handedness(vertices.size());
+			for (size_t idx{}; idx < indices.size(); ++idx)
+			{
+				const int8_t sign{ faceSigns[idx / 3] };
+				if (sign != 0)
+					handedness[indices[idx]] |= sign > 0 ? positiveBit : negativeBit;
+			}
+
+			const size_t nrOriginalVertices{ vertices.size() };
+			std::vector<uint32_t> copies(nrOriginalVertices);
+			for (size_t vertexIdx{}; vertexIdx < nrOriginalVertices; ++vertexIdx)
+			{
+				if (handedness[vertexIdx] != (positiveBit | negativeBit))
+					continue;
+
+				copies[vertexIdx] = uint32_t(vertices.size());
+				vertices.push_back(vertices[vertexIdx]);
+				handedness[vertexIdx] = positiveBit;
+				handedness.push_back(negativeBit);
+			}
+			for (size_t idx{}; idx < indices.size(); ++idx)
+			{
+				const uint32_t vertexIdx{ indices[idx] };
+				if (faceSigns[idx / 3] < 0 && copies[vertexIdx] != 0)
+					indices[idx] = copies[vertexIdx];
+			}
+
+			// The corners of every vertex in index buffer order, that order is the same for any amount of threads
+			std::vector<uint32_t> cornerOffsets(vertices.size() + 1);
+			for (const uint32_t vertexIdx : indices)
+			{
+				++cornerOffsets[vertexIdx + 1];
+			}
+			for (size_t vertexIdx{}; vertexIdx < vertices.size(); ++vertexIdx)
+			{
+				cornerOffsets[vertexIdx + 1] += cornerOffsets[vertexIdx];
+			}
+			std::vector<uint32_t> vertexCorners(indices.size());
+			{
+				std::vector<uint32_t> nextCorner(cornerOffsets.begin(), cornerOffsets.end() - 1);
+				for (size_t idx{}; idx < indices.size(); ++idx)
+				{
+					vertexCorners[nextCorner[indices[idx]]++] = uint32_t(idx);
+				}
+			}
+
+			ParallelForRanges(pThreadPool, vertices.size(), nrRanges, [&](size_t first, size_t last)
+				{
+					for (size_t vertexIdx{ first }; vertexIdx < last; ++vertexIdx)
+					{
+						Vector3 sum{};
+						for (uint32_t cornerIdx{ cornerOffsets[vertexIdx] }; cornerIdx < cornerOffsets[vertexIdx + 1]; ++cornerIdx)
+						{
+							sum += cornerTangents[vertexCorners[cornerIdx]];
+						}
+
+						Vertex& vertex{ vertices[vertexIdx] };
+						const float length{ sum.Magnitude() };
+						vertex.tangent = Vector4{ IsZero(length) ? GetPerpendicular(vertex.normal) : sum / length,
+							handedness[vertexIdx] == negativeBit ? -1.f : 1.f };
+					}
+				});
+
+			return { uint32_t(nrRanges), uint32_t(vertices.size() - nrOriginalVertices) };
+		}
+	}
+
+	namespace Tangents
+	{
+		const char* GetName(Method method)
+		{
+			switch (method)
+			{
+			case Method::Accumulated: return "accumulated";
+			case Method::MikkTSpace: return "MikkTSpace";
+			}
+			return "unknown";
+		}
+
+		Result Generate(Method method, std::vector<uint32_t>& indices, std::vector<Vertex>& vertices, ThreadPool* pThreadPool)
+		{
+			if (method == Method::Accumulated)
+			{
+				GenerateAccumulated(indices, vertices);
+				return { 1, 0 };
+			}
+
+			const size_t maxRanges{ pThreadPool ? pThreadPool->GetThreadCount() : 1u };
+			return GenerateMikkTSpace(indices, vertices, pThreadPool, std::clamp(indices.size() / 3 / MinTrianglesPerRange, size_t(1), maxRanges));
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "DataTypes.h"
+
+namespace dae
+{
+	class ThreadPool;
+
+	// Tangent frames for normal mapping, the tangent xyz follows the u direction of the uvs
+	// w is the handedness: the bitangent is Cross(normal, tangent.xyz) * w
+	namespace Tangents
+	{
+		enum class Method : uint32_t
+		{
+			// Face tangents summed per vertex and made perpendicular to the normal, serial, w is always 1
+			Accumulated,
+			// Same frames as the MikkTSpace reference: angle weighted, per handedness, vertices on a mirror seam get split
+			MikkTSpace
+		};
+
+		const char* GetName(Method method);
+
+		struct Result final
+		{
+			uint32_t nrThreads{};
+			// Vertices that got a copy because their triangles disagree on the handedness
+			uint32_t nrSplitVertices{};
+		};
+
+		// Needs positions, uvs and normals, overwrites the tangents and may append vertices and rewrite indices
+		// The sums per vertex always run in the same order, so the output does not depend on the amount of threads
+		// Runs on the threads of the pool, without a pool or for small meshes on the calling thread alone
+		Result Generate(Method method, std::vector<uint32_t>& indices, std::vector<Vertex>& vertices, ThreadPool* pThreadPool = nullptr);
+	}
+}
@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "Tests.h"
+#include "Renderer.h"
+#include <cstring>
+
+#undef main
+
+using namespace dae;
+
+namespace
+{
+	struct Test final
+	{
+		const char* pName;
+		const char* pDescription;
+		bool(*pRun)(SDL_Window* pWindow);
+	};
+
+	constexpr Test TestList[]
+	{
+		{ "kernels", "every supported raster kernel against the scalar reference", &Tests::RunRasterKernels },
+		{ "flythrough", "holes and overlaps while the camera flies through the vehicle", &Tests::RunFlyThrough },
+		{ "watertight", "holes and overlaps along the shared edges of the vehicle in fixed point", &Tests::RunWatertightness },
+		{ "allocations", "heap allocations of the software frames once the renderer is warmed up", &Tests::RunAllocations },
+	};
+}
+
+bool dae::Tests::RenderFrames(Renderer& renderer, Timer& timer, int nrFrames)
+{
+	renderer.ResetStatistics();
+	for (int frameIdx{}; frameIdx < nrFrames; ++frameIdx)
+	{
+		timer.Update();
+		renderer.Update(&timer);
+		renderer.Render();
+	}
+
+	if (renderer.GetStatistics().nrFrames > 0)
+		return true;
+
+	std::cout << "No software frames were rendered\n";
+	return false;
+}
+
+int main(int argc, char* args[])
+{
+	const auto isNamed{ [&](const char* pName)
+		{
+			return std::any_of(args + 1, args + argc, [&](const char* pArg) { return std::strcmp(pArg, pName) == 0; });
+		} };
+
+	for (int argIdx{ 1 }; argIdx < argc; ++argIdx)
+	{
+		if (std::none_of(std::begin(TestList), std::end(TestList), [&](const Test& test) { return std::strcmp(test.pName, args[argIdx]) == 0; }))
+		{
+			std::cout << "Unknown test " << args[argIdx] << ", expected one of:\n";
+			for (const Test& test : TestList)
+			{
+				std::cout << "  " << test.pName << ": " << test.pDescription << '\n';
+			}
+			return 1;
+		}
+	}
+
+	SDL_Init(SDL_INIT_VIDEO);
+
+	// Hidden, the software frames are still presented to its surface and DirectX still creates its swap chain
+	SDL_Window* pWindow = SDL_CreateWindow(
+		"DualRasterizer - Tests",
+		SDL_WINDOWPOS_UNDEFINED,
+		SDL_WINDOWPOS_UNDEFINED,
+		640, 480, SDL_WINDOW_HIDDEN);
+
+	if (!pWindow)
+		return 1;
+
+	int nrFailedTests{};
+	for (const Test& test : TestList)
+	{
+		if (argc > 1 && !isNamed(test.pName))
+			continue;
+
+		std::cout << "\n=== " << test.pName << ": " << test.pDescription << '\n';
+		const bool hasPassed{ test.pRun(pWindow) };
+		std::cout << (hasPassed ? "PASSED " : "FAILED ") << test.pName << '\n';
+		if (!hasPassed)
+			++nrFailedTests;
+	}
+
+	SDL_DestroyWindow(pWindow);
+	SDL_Quit();
+	return nrFailedTests;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+struct SDL_Window;
+
+namespace dae
+{
+	class Renderer;
+	class Timer;
+
+	// Each test prints what it checked and what failed, the Tests project runs the ones named on its command line or all of them
+	// and exits with the number of failed tests
+	namespace Tests
+	{
+		// Renders nrFrames after resetting the statistics, false when no software frame was rendered
+		bool RenderFrames(Renderer& renderer, Timer& timer, int nrFrames);
+
+		bool RunRasterKernels(SDL_Window* pWindow);
+		bool RunFlyThrough(SDL_Window* pWindow);
+		bool RunWatertightness(SDL_Window* pWindow);
+		bool RunAllocations(SDL_Window* pWindow);
+	}
+}
@@ -1,21 +1,217 @@
 #include "pch.h"
 #include "Texture.h"
+#include "Dds.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <immintrin.h>
 
 using namespace dae;
 
-Texture::~Texture()
+namespace
 {
-	SDL_FreeSurface(m_pSurface);
+	// Every 8 bit channel value as a float in [0, 1]
+	constexpr std::array<float, 256> UnormToFloat{ []()
+		{
+			std::array<float, 256> table{};
+			for (int value{}; value < 256; ++value)
+			{
+				table[value] = value / 255.f;
+			}
+			return table;
+		}() };
+
+	ColorRGB UnpackTexel(uint32_t texel)
+	{
+		return ColorRGB{ UnormToFloat[texel & 0xFF], UnormToFloat[texel >> 8 & 0xFF], UnormToFloat[texel >> 16 & 0xFF] };
+	}
+
+	// Exponent plus the mantissa as a straight line, at most 0.09 off, plenty to pick and blend mip levels
+	float FastLog2(float value)
+	{
+		const uint32_t bits{ std::bit_cast<uint32_t>(value) };
+		return float(int(bits >> 23) - 127) + std::bit_cast<float>((bits & 0x007FFFFF) | 0x3F800000) - 1.f;
+	}
+
+	// The tiled index is the block of 4x4 texels times 16 plus the Z-order of the texel in it, bits x0 y0 x1 y1.
+	// The x and y bits never overlap, so it is the sum of a column and a row part and a bilinear footprint needs two of each
+	constexpr size_t GetTiledColumn(int x)
+	{
+		return size_t(x >> 2) << 4 | (x & 1) | (x & 2) << 1;
+	}
+
+	constexpr size_t GetTiledRow(int y, int nrBlocksX)
+	{
+		return (size_t(y >> 2) * nrBlocksX) << 4 | (y & 1) << 1 | (y & 2) << 2;
+	}
+
+	// Where texel x + 4 * y of a decoded block goes in the Z-order of the tiled layout
+	constexpr std::array<uint8_t, BlockCompression::TexelsPerBlock> BlockTexelToTiled{ []()
+		{
+			std::array<uint8_t, BlockCompression::TexelsPerBlock> table{};
+			for (int texelIdx{}; texelIdx < BlockCompression::TexelsPerBlock; ++texelIdx)
+			{
+				table[texelIdx] = uint8_t(GetTiledColumn(texelIdx % 4) + GetTiledRow(texelIdx / 4, 1));
+			}
+			return table;
+		}() };
+
+	// Decoded blocks of compressed textures, direct mapped on a hash of the key. One per thread, so the tile workers
+	// never share it or take a lock. 256 blocks are 16 KiB, they stay in L1 and L2 next to the tile being shaded
+	struct BlockCache final
+	{
+		static constexpr int NrEntriesBits{ 8 };
+		static constexpr size_t NrEntries{ size_t(1) << NrEntriesBits };
+
+		uint64_t keys[NrEntries]{};
+		// In the order of the tiled layout, the lowest 4 bits of a tiled index pick the texel
+		uint32_t texels[NrEntries][BlockCompression::TexelsPerBlock]{};
+	};
+	thread_local BlockCache DecodedBlocks{};
 
+	// Every compressed level takes the next one, shifted past the block index. Keys are never reused, so a texture
+	// that is gone can not leave valid entries behind, and 0 stays free to mark an empty entry
+	std::atomic<uint64_t> NextCompressedLevel{ 1 };
+
+	int FloorToInt(float value)
+	{
+		const int truncated{ int(value) };
+		return value < float(truncated) ? truncated - 1 : truncated;
+	}
+
+	// Remainder that is never negative. Power of two sizes, every level of the textures we ship, only need a mask
+	int Modulo(int value, int divisor)
+	{
+		if ((divisor & (divisor - 1)) == 0)
+			return value & (divisor - 1);
+
+		const int remainder{ value % divisor };
+		return remainder + (remainder >> 31 & divisor);
+	}
+
+	// Coordinates outside the texture, every mode runs the same selects so tiled uvs do not mispredict per texel.
+	// Border is clamped here, the caller swaps in the border color
+	int AddressOutside(int coordinate, int size, Texture::AddressMode mode)
+	{
+		// Mirror repeats two sizes and runs the second one backwards: 0 1 2 2 1 0 0 1 2
+		const bool isMirror{ mode == Texture::AddressMode::Mirror };
+		const int period{ isMirror ? 2 * size : size };
+		const int repeated{ Modulo(coordinate, period) };
+		const int folded{ isMirror ? std::min(repeated, period - 1 - repeated) : repeated };
+
+		const bool isClamped{ mode == Texture::AddressMode::Clamp || mode == Texture::AddressMode::Border };
+		return std::clamp(isClamped ? coordinate : folded, 0, size - 1);
+	}
+
+	// The texel a coordinate reads, like the hardware sampler. Inside the texture that is the coordinate itself,
+	// a test that is always predicted on a mesh without tiling and keeps the selects above out of the common case
+	int Address(int coordinate, int size, Texture::AddressMode mode)
+	{
+		return uint32_t(coordinate) < uint32_t(size) ? coordinate : AddressOutside(coordinate, size, mode);
+	}
+
+	bool IsBorder(int coordinate, int size, Texture::AddressMode mode)
+	{
+		return mode == Texture::AddressMode::Border && uint32_t(coordinate) >= uint32_t(size);
+	}
+
+	// 2x2 box filter of every channel, rounded to nearest. An odd last row or column is left out,
+	// the source is clamped where a side is 1 texel. SSE2 averages two texels per step when the source width is even
+	void Downsample(const uint32_t* pSource, int sourceWidth, int sourceHeight, uint32_t* pDestination, int width, int height)
+	{
+		const __m128i zero{ _mm_setzero_si128() };
+		const __m128i rounding{ _mm_set1_epi16(2) };
+		for (int y{}; y < height; ++y)
+		{
+			const uint32_t* pRow0{ pSource + size_t(std::min(2 * y, sourceHeight - 1)) * sourceWidth };
+			const uint32_t* pRow1{ pSource + size_t(std::min(2 * y + 1, sourceHeight - 1)) * sourceWidth };
+			uint32_t* pDestinationRow{ pDestination + size_t(y) * width };
+
+			int x{};
+			if (sourceWidth % 2 == 0)
+			{
+				for (; x + 2 <= width; x += 2)
+				{
+					const __m128i row0{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow0 + 2 * x)) };
+					const __m128i row1{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow1 + 2 * x)) };
+
+					// Channels widened to 16 bit, low holds the column sums of texels 0 and 1, high of 2 and 3
+					const __m128i low{ _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero)) };
+					const __m128i high{ _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero)) };
+					const __m128i sums{ _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high)) };
+					const __m128i averages{ _mm_srli_epi16(_mm_add_epi16(sums, rounding), 2) };
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(pDestinationRow + x), _mm_packus_epi16(averages, averages));
+				}
+			}
+
+			for (; x < width; ++x)
+			{
+				const int x0{ std::min(2 * x, sourceWidth - 1) };
+				const int x1{ std::min(2 * x + 1, sourceWidth - 1) };
+				const uint32_t texels[4]{ pRow0[x0], pRow0[x1], pRow1[x0], pRow1[x1] };
+
+				uint32_t average{};
+				for (int shift{}; shift < 32; shift += 8)
+				{
+					uint32_t sum{ 2 };
+					for (const uint32_t texel : texels)
+					{
+						sum += texel >> shift & 0xFF;
+					}
+					average |= (sum >> 2) << shift;
+				}
+				pDestinationRow[x] = average;
+			}
+		}
+	}
+}
+
+Texture::~Texture()
+{
 	if (m_pResource) m_pResource->Release();
 	if (m_pSRV) m_pSRV->Release();
 
 
 }
 
-Texture* Texture::LoadFromFile(const std::string& path, ID3D11Device* pDevice)
+Texture* Texture::LoadFromFile(const std::string& path, ID3D11Device* pDevice, bool keepFloatTexels)
 {
-	Texture* text{ new Texture(IMG_Load(path.c_str()), pDevice) };
+	Texture* text{};
+	if (path.ends_with(".dds"))
+	{
+		Dds::Image image{};
+		if (!Dds::Read(path, image))
+		{
+			std::cout << path << ": not a BC1, BC3, BC5 or BC7 2D texture\n";
+			return nullptr;
+		}
+		text = new Texture(std::move(image), pDevice);
+	}
+	else
+	{
+		SDL_Surface* pSurface{ IMG_Load(path.c_str()) };
+		if (!pSurface)
+		{
+			std::cout << path << ": " << IMG_GetError() << '\n';
+			return nullptr;
+		}
+
+		// Whatever the file was loaded as, ABGR8888 puts red in the lowest byte, the memory order of R8G8B8A8
+		SDL_Surface* pConverted{ SDL_ConvertSurfaceFormat(pSurface, SDL_PIXELFORMAT_ABGR8888, 0) };
+		SDL_FreeSurface(pSurface);
+		if (!pConverted)
+		{
+			std::cout << path << ": " << SDL_GetError() << '\n';
+			return nullptr;
+		}
+		text = new Texture(pConverted, pDevice, keepFloatTexels);
+	}
+
+	std::cout << path << ": " << (text->m_IsCompressed ? BlockCompression::GetName(text->m_Format) : "RGBA8") << ' '
+		<< text->GetMipWidth(0) << 'x' << text->GetMipHeight(0) << " with " << text->GetNrMipLevels() << " mip levels, "
+		<< text->GetSoftwareMemorySize() / 1024 << "KiB software, " << text->GetHardwareMemorySize() / 1024 << "KiB hardware\n";
 	return text;
 }
 
@@ -24,13 +220,84 @@ ID3D11ShaderResourceView* dae::Texture::GetSRV() const
 	return m_pSRV;
 }
 
-Texture::Texture(SDL_Surface* pSurface, ID3D11Device* pDevice)
+Texture::Texture(SDL_Surface* pSurface, ID3D11Device* pDevice, bool keepFloatTexels)
 {
-	DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	const int width{ pSurface->w };
+	const int height{ pSurface->h };
+	MipLevel fullLevel{ CreateMipLevel(width, height) };
+	for (int y{}; y < height; ++y)
+	{
+		const uint8_t* pRow{ static_cast<const uint8_t*>(pSurface->pixels) + size_t(y) * pSurface->pitch };
+		std::memcpy(fullLevel.GetTexels() + size_t(y) * width, pRow, size_t(width) * sizeof(uint32_t));
+	}
+	SDL_FreeSurface(pSurface);
+
+	m_MipLevels.push_back(std::move(fullLevel));
+	BuildMipLevels();
+	m_SquaredWidth = float(width) * width;
+	m_SquaredHeight = float(height) * height;
+	m_MaxMipLevel = float(m_MipLevels.size() - 1);
+
+	if (keepFloatTexels)
+	{
+		for (MipLevel& level : m_MipLevels)
+		{
+			const size_t nrTexels{ level.blocks.size() * std::size(TexelBlock{}.texels) };
+			level.floatTexels.reserve(nrTexels);
+			for (size_t idx{}; idx < nrTexels; ++idx)
+			{
+				level.floatTexels.push_back(UnpackTexel(level.GetTexels()[idx]));
+			}
+		}
+	}
+
+	// The hardware gets the same mip levels
+	std::vector<D3D11_SUBRESOURCE_DATA> initData(m_MipLevels.size());
+	for (size_t levelIdx{}; levelIdx < m_MipLevels.size(); ++levelIdx)
+	{
+		const MipLevel& level{ m_MipLevels[levelIdx] };
+		initData[levelIdx].pSysMem = level.GetTexels();
+		initData[levelIdx].SysMemPitch = static_cast<UINT>(level.width * sizeof(uint32_t));
+		initData[levelIdx].SysMemSlicePitch = static_cast<UINT>(level.width * level.height * sizeof(uint32_t));
+	}
+	CreateResource(pDevice, DXGI_FORMAT_R8G8B8A8_UNORM, initData);
+}
+
+Texture::Texture(Dds::Image&& image, ID3D11Device* pDevice)
+	: m_Layout{ TexelLayout::Tiled }
+	, m_IsCompressed{ true }
+	, m_Format{ image.format }
+{
+	// The blocks go to the hardware as they are, the levels keep them for the software sampler
+	std::vector<D3D11_SUBRESOURCE_DATA> initData(image.levels.size());
+	for (size_t levelIdx{}; levelIdx < image.levels.size(); ++levelIdx)
+	{
+		const int width{ std::max(image.width >> levelIdx, 1) };
+		MipLevel level{ width, std::max(image.height >> levelIdx, 1), (width + 3) / 4 };
+		level.compressedBlocks = std::move(image.levels[levelIdx]);
+		level.blockCacheKey = NextCompressedLevel++ << 32;
+
+		initData[levelIdx].pSysMem = level.compressedBlocks.data();
+		initData[levelIdx].SysMemPitch = static_cast<UINT>(level.nrBlocksX * BlockCompression::GetBlockSize(m_Format));
+		initData[levelIdx].SysMemSlicePitch = static_cast<UINT>(level.compressedBlocks.size());
+		m_MipLevels.push_back(std::move(level));
+	}
+
+	m_SquaredWidth = float(image.width) * image.width;
+	m_SquaredHeight = float(image.height) * image.height;
+	m_MaxMipLevel = float(m_MipLevels.size() - 1);
+	CreateResource(pDevice, BlockCompression::GetDxgiFormat(m_Format), initData);
+}
+
+void Texture::CreateResource(ID3D11Device* pDevice, DXGI_FORMAT format, const std::vector<D3D11_SUBRESOURCE_DATA>& initData)
+{
+	if (!pDevice)
+		return;
+
 	D3D11_TEXTURE2D_DESC desc{};
-	desc.Width = pSurface->w;
-	desc.Height = pSurface->h;
-	desc.MipLevels = 1;
+	desc.Width = m_MipLevels.front().width;
+	desc.Height = m_MipLevels.front().height;
+	desc.MipLevels = static_cast<UINT>(m_MipLevels.size());
 	desc.ArraySize = 1;
 	desc.Format = format;
 	desc.SampleDesc.Count = 1;
@@ -40,12 +307,7 @@ Texture::Texture(SDL_Surface* pSurface, ID3D11Device* pDevice)
 	desc.CPUAccessFlags = 0;
 	desc.MiscFlags = 0;
 
-	D3D11_SUBRESOURCE_DATA initData;
-	initData.pSysMem = pSurface->pixels;
-	initData.SysMemPitch = static_cast<UINT>(pSurface->pitch);
-	initData.SysMemSlicePitch = static_cast<UINT>(pSurface->h * pSurface->pitch);
-
-	HRESULT hr = pDevice->CreateTexture2D(&desc, &initData, &m_pResource);
+	HRESULT hr = pDevice->CreateTexture2D(&desc, initData.data(), &m_pResource);
 
 	if (FAILED(hr))
 	{
@@ -55,7 +317,7 @@ Texture::Texture(SDL_Surface* pSurface, ID3D11Device* pDevice)
 	D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc{};
 	SRVDesc.Format = format;
 	SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	SRVDesc.Texture2D.MipLevels = 1;
+	SRVDesc.Texture2D.MipLevels = static_cast<UINT>(m_MipLevels.size());
 
 	if (m_pResource != nullptr)
 	{
@@ -66,25 +328,209 @@ Texture::Texture(SDL_Surface* pSurface, ID3D11Device* pDevice)
 			std::cout << "Failed to load ShaderResourceView\n";
 		}
 	}
+}
+
+void Texture::SetLayout(TexelLayout layout)
+{
+	if (layout == m_Layout || m_IsCompressed)
+		return;
+
+	for (MipLevel& level : m_MipLevels)
+	{
+		MipLevel reordered{ CreateMipLevel(level.width, level.height) };
+		reordered.floatTexels.resize(level.floatTexels.size());
+		for (int y{}; y < level.height; ++y)
+		{
+			for (int x{}; x < level.width; ++x)
+			{
+				const size_t from{ GetColumn(x) + GetRow(level, y) };
+				const size_t to{ layout == TexelLayout::Linear ? size_t(x) + size_t(y) * level.width : GetTiledColumn(x) + GetTiledRow(y, level.nrBlocksX) };
+				reordered.GetTexels()[to] = level.GetTexels()[from];
+				if (!level.floatTexels.empty())
+					reordered.floatTexels[to] = level.floatTexels[from];
+			}
+		}
+		level = std::move(reordered);
+	}
+	m_Layout = layout;
+}
+
+size_t Texture::GetSoftwareMemorySize() const
+{
+	size_t size{};
+	for (const MipLevel& level : m_MipLevels)
+	{
+		size += level.blocks.size() * sizeof(TexelBlock) + level.floatTexels.size() * sizeof(ColorRGB) + level.compressedBlocks.size();
+	}
+	return size;
+}
+
+size_t Texture::GetHardwareMemorySize() const
+{
+	size_t size{};
+	for (const MipLevel& level : m_MipLevels)
+	{
+		size += m_IsCompressed ? level.compressedBlocks.size() : size_t(level.width) * level.height * sizeof(uint32_t);
+	}
+	return size;
+}
+
+std::vector<uint32_t> Texture::GetMipTexels(size_t levelIdx) const
+{
+	const MipLevel& level{ m_MipLevels[levelIdx] };
+	std::vector<uint32_t> texels(size_t(level.width) * level.height);
+	for (int y{}; y < level.height; ++y)
+	{
+		for (int x{}; x < level.width; ++x)
+		{
+			const size_t idx{ GetColumn(x) + GetRow(level, y) };
+			texels[size_t(y) * level.width + x] = m_IsCompressed ? FetchCompressed(level, idx) : level.GetTexels()[idx];
+		}
+	}
+	return texels;
+}
+
+Texture::MipLevel Texture::CreateMipLevel(int width, int height)
+{
+	// Rounded up to whole blocks, the linear layout only uses the first width * height texels
+	MipLevel level{ width, height, (width + 3) / 4 };
+	level.blocks.resize(size_t(level.nrBlocksX) * ((height + 3) / 4));
+	return level;
+}
+
+void Texture::BuildMipLevels()
+{
+	while (m_MipLevels.back().width > 1 || m_MipLevels.back().height > 1)
+	{
+		const MipLevel& source{ m_MipLevels.back() };
+		MipLevel level{ CreateMipLevel(std::max(source.width / 2, 1), std::max(source.height / 2, 1)) };
+		Downsample(source.GetTexels(), source.width, source.height, level.GetTexels(), level.width, level.height);
+		m_MipLevels.push_back(std::move(level));
+	}
+}
+
+float Texture::GetMipLevel(const Vector2& uvDdx, const Vector2& uvDdy) const
+{
+	// log2 of the longest of the two pixel steps, in texels of the full resolution level
+	const float stepX{ uvDdx.x * uvDdx.x * m_SquaredWidth + uvDdx.y * uvDdx.y * m_SquaredHeight };
+	const float stepY{ uvDdy.x * uvDdy.x * m_SquaredWidth + uvDdy.y * uvDdy.y * m_SquaredHeight };
+	return 0.5f * FastLog2(std::max(stepX, stepY));
+}
+
+size_t Texture::GetColumn(int x) const
+{
+	return m_Layout == TexelLayout::Tiled ? GetTiledColumn(x) : size_t(x);
+}
+
+size_t Texture::GetRow(const MipLevel& level, int y) const
+{
+	return m_Layout == TexelLayout::Tiled ? GetTiledRow(y, level.nrBlocksX) : size_t(y) * level.width;
+}
 
-	m_pSurface = pSurface;
-	m_pSurfacePixels = (uint32_t*)pSurface->pixels;
+ColorRGB Texture::Fetch(const MipLevel& level, size_t idx) const
+{
+	if (!level.floatTexels.empty())
+		return level.floatTexels[idx];
+	if (m_IsCompressed)
+		return UnpackTexel(FetchCompressed(level, idx));
+
+	return UnpackTexel(level.GetTexels()[idx]);
+}
+
+uint32_t Texture::FetchCompressed(const MipLevel& level, size_t idx) const
+{
+	// Fibonacci hashing spreads the blocks of a row and the rows of a level over the whole cache
+	const uint64_t key{ level.blockCacheKey + idx / BlockCompression::TexelsPerBlock };
+	const size_t entry{ size_t(key * 0x9E3779B97F4A7C15ull >> (64 - BlockCache::NrEntriesBits)) };
 
+	const BlockCache& cache{ DecodedBlocks };
+	if (cache.keys[entry] != key)
+		DecodeBlock(level, idx / BlockCompression::TexelsPerBlock, entry);
+	return cache.texels[entry][idx % BlockCompression::TexelsPerBlock];
 }
 
-ColorRGB Texture::Sample(const Vector2& uv) const
+void Texture::DecodeBlock(const MipLevel& level, size_t blockIdx, size_t entry) const
 {
-	const int x = int(uv.x * m_pSurface->w);
-	const int y = int(uv.y * m_pSurface->h);
+	uint32_t texels[BlockCompression::TexelsPerBlock];
+	BlockCompression::DecodeBlock(m_Format, level.compressedBlocks.data() + blockIdx * BlockCompression::GetBlockSize(m_Format), texels);
 
-	Uint8 r{ };
-	Uint8 g{ };
-	Uint8 b{ };
+	BlockCache& cache{ DecodedBlocks };
+	for (int texelIdx{}; texelIdx < BlockCompression::TexelsPerBlock; ++texelIdx)
+	{
+		cache.texels[entry][BlockTexelToTiled[texelIdx]] = texels[texelIdx];
+	}
+	cache.keys[entry] = level.blockCacheKey + blockIdx;
+}
 
-	const int idx{ int(x + (y * m_pSurface->w)) };
+ColorRGB Texture::FetchAddressed(const MipLevel& level, int x, int y, const Sampler& sampler) const
+{
+	// The clamped texel is always safe to read, the border color is picked after it
+	const ColorRGB texel{ Fetch(level, GetColumn(Address(x, level.width, sampler.addressU)) + GetRow(level, Address(y, level.height, sampler.addressV))) };
+	return IsBorder(x, level.width, sampler.addressU) || IsBorder(y, level.height, sampler.addressV) ? sampler.borderColor : texel;
+}
 
-	SDL_GetRGB(m_pSurfacePixels[idx], m_pSurface->format, &r, &g, &b);
+ColorRGB Texture::SamplePoint(const MipLevel& level, const Vector2& uv, const Sampler& sampler) const
+{
+	const int x{ FloorToInt(uv.x * level.width) };
+	const int y{ FloorToInt(uv.y * level.height) };
+	if (sampler.addressU == AddressMode::Border || sampler.addressV == AddressMode::Border)
+		return FetchAddressed(level, x, y, sampler);
+
+	return Fetch(level, GetColumn(Address(x, level.width, sampler.addressU)) + GetRow(level, Address(y, level.height, sampler.addressV)));
+}
+
+ColorRGB Texture::SampleBilinear(const MipLevel& level, const Vector2& uv, const Sampler& sampler) const
+{
+	// Texel centers are at half coordinates
+	const float x{ uv.x * level.width - 0.5f };
+	const float y{ uv.y * level.height - 0.5f };
+	const int x0{ FloorToInt(x) };
+	const int y0{ FloorToInt(y) };
+	const float weightX{ x - x0 };
+	const float weightY{ y - y0 };
+
+	ColorRGB row0{};
+	ColorRGB row1{};
+	if (sampler.addressU == AddressMode::Border || sampler.addressV == AddressMode::Border)
+	{
+		row0 = FetchAddressed(level, x0, y0, sampler) * (1.f - weightX) + FetchAddressed(level, x0 + 1, y0, sampler) * weightX;
+		row1 = FetchAddressed(level, x0, y0 + 1, sampler) * (1.f - weightX) + FetchAddressed(level, x0 + 1, y0 + 1, sampler) * weightX;
+	}
+	else
+	{
+		const size_t left{ GetColumn(Address(x0, level.width, sampler.addressU)) };
+		const size_t right{ GetColumn(Address(x0 + 1, level.width, sampler.addressU)) };
+		const size_t bottom{ GetRow(level, Address(y0, level.height, sampler.addressV)) };
+		const size_t top{ GetRow(level, Address(y0 + 1, level.height, sampler.addressV)) };
+		row0 = Fetch(level, left + bottom) * (1.f - weightX) + Fetch(level, right + bottom) * weightX;
+		row1 = Fetch(level, left + top) * (1.f - weightX) + Fetch(level, right + top) * weightX;
+	}
+	return row0 * (1.f - weightY) + row1 * weightY;
+}
+
+ColorRGB Texture::Sample(const Vector2& uv, const Vector2& uvDdx, const Vector2& uvDdy, const Sampler& sampler) const
+{
+	// Magnified textures use the full resolution level
+	const float mipLevel{ GetMipLevel(uvDdx, uvDdy) };
+	const float clampedLevel{ mipLevel > 0.f ? std::min(mipLevel, m_MaxMipLevel) : 0.f };
+
+	switch (sampler.filter)
+	{
+	case Filter::Point:
+		return SamplePoint(m_MipLevels[int(clampedLevel + 0.5f)], uv, sampler);
+	case Filter::Bilinear:
+		return SampleBilinear(m_MipLevels[int(clampedLevel + 0.5f)], uv, sampler);
+	case Filter::Trilinear:
+	{
+		const int levelIdx{ int(clampedLevel) };
+		const float weight{ clampedLevel - levelIdx };
+		const ColorRGB color{ SampleBilinear(m_MipLevels[levelIdx], uv, sampler) };
+		if (weight == 0.f)
+			return color;
+
+		return color * (1.f - weight) + SampleBilinear(m_MipLevels[levelIdx + 1], uv, sampler) * weight;
+	}
+	}
 
-	ColorRGB kleur{ r / 255.f, g / 255.f, b / 255.f };
-	return kleur;
+	return colors::Black;
 }
@@ -1,10 +1,53 @@
 #pragma once
+#include "BlockCompression.h"
 
 namespace dae
 {
+	namespace Dds
+	{
+		struct Image;
+	}
+
 	class Texture
 	{
 	public:
+		// Software filters, the mip level is picked from the uv derivatives like the hardware does
+		enum class Filter
+		{
+			Point = 0,
+			Bilinear = 1,
+			Trilinear = 2
+		};
+
+		// What a texel coordinate outside the texture reads, the values of D3D11_TEXTURE_ADDRESS_MODE
+		enum class AddressMode
+		{
+			Wrap = 1,
+			Mirror = 2,
+			Clamp = 3,
+			// The border color
+			Border = 4
+		};
+
+		// The software side of a D3D11 sampler state, every mesh has one for its textures
+		struct Sampler
+		{
+			Filter filter{ Filter::Point };
+			AddressMode addressU{ AddressMode::Wrap };
+			AddressMode addressV{ AddressMode::Wrap };
+			ColorRGB borderColor{};
+		};
+
+		// Where texel x, y of a mip level is in memory
+		enum class TexelLayout
+		{
+			// Row after row, what the file and the hardware upload use
+			Linear = 0,
+			// 4x4 blocks of one cache line each, the blocks row after row and the texels in Z-order inside a block,
+			// so a bilinear footprint or a few neighbouring pixels of a rotated triangle mostly hit the same line
+			Tiled = 1
+		};
+
 		~Texture();
 
 		// rule of 5 copypasta
@@ -13,16 +56,86 @@ namespace dae
 		Texture& operator=(const Texture& other) = delete;
 		Texture& operator=(Texture&& other) = delete;
 
-		static Texture* LoadFromFile(const std::string& path, ID3D11Device* pDevice);
+		// The texels are converted once to RGBA8 with red in the lowest byte, both renderers use that copy
+		// keepFloatTexels also keeps them as floats, sampling is then a plain load at three times the memory
+		// A .dds file keeps its blocks: the hardware gets them as they are and the software sampler decodes
+		// the blocks it reads into a small cache per thread, keepFloatTexels does not apply. Nullptr if it can not be read
+		// Without a device only the software side is made
+		static Texture* LoadFromFile(const std::string& path, ID3D11Device* pDevice, bool keepFloatTexels = false);
 
 		ID3D11ShaderResourceView* GetSRV() const;
-		ColorRGB Sample(const Vector2& uv) const;
+		// Reorders the texels of every mip level for the software sampler, LoadFromFile gives a linear texture
+		// Compressed textures are always tiled, a block is one tile
+		void SetLayout(TexelLayout layout);
+		TexelLayout GetLayout() const { return m_Layout; }
+		// uvDdx and uvDdy are how much the uv changes to the next pixel to the right and up, they pick the mip level
+		ColorRGB Sample(const Vector2& uv, const Vector2& uvDdx, const Vector2& uvDdy, const Sampler& sampler) const;
+
+		bool IsCompressed() const { return m_IsCompressed; }
+		BlockCompression::Format GetFormat() const { return m_Format; }
+		// BC5 stores red and green only, a normal map needs its z rebuilt from them
+		bool HasTwoChannels() const { return m_IsCompressed && m_Format == BlockCompression::Format::BC5; }
+		// Bytes of all mip levels in the software sampler and in the hardware texture
+		size_t GetSoftwareMemorySize() const;
+		size_t GetHardwareMemorySize() const;
+
+		size_t GetNrMipLevels() const { return m_MipLevels.size(); }
+		int GetMipWidth(size_t levelIdx) const { return m_MipLevels[levelIdx].width; }
+		int GetMipHeight(size_t levelIdx) const { return m_MipLevels[levelIdx].height; }
+		// The RGBA8 texels of a level row after row, whatever the layout, compressed levels are decoded
+		std::vector<uint32_t> GetMipTexels(size_t levelIdx) const;
 
 	private:
-		Texture(SDL_Surface* pSurface, ID3D11Device* pDevice);
+		// Takes an ABGR8888 surface and frees it
+		Texture(SDL_Surface* pSurface, ID3D11Device* pDevice, bool keepFloatTexels);
+		Texture(Dds::Image&& image, ID3D11Device* pDevice);
+
+		// Aligned to a cache line, the storage of a level is a whole number of these in both layouts
+		struct alignas(64) TexelBlock
+		{
+			uint32_t texels[16];
+		};
+
+		// Every level is a 2x2 box filter of the one before it, down to 1x1
+		struct MipLevel
+		{
+			int width{};
+			int height{};
+			int nrBlocksX{};
+			std::vector<TexelBlock> blocks{};
+			std::vector<ColorRGB> floatTexels{};
+			// A compressed level has its BCn blocks instead of texel blocks, in the same order as the tiled layout
+			std::vector<uint8_t> compressedBlocks{};
+			// Unique for every compressed level, plus the block index it is the key of a decoded block in the cache
+			uint64_t blockCacheKey{};
+
+			uint32_t* GetTexels() { return blocks[0].texels; }
+			const uint32_t* GetTexels() const { return blocks[0].texels; }
+		};
+		std::vector<MipLevel> m_MipLevels{};
+		TexelLayout m_Layout{ TexelLayout::Linear };
+		bool m_IsCompressed{};
+		BlockCompression::Format m_Format{};
+		// Of the full resolution level, to get the derivatives in texels
+		float m_SquaredWidth{};
+		float m_SquaredHeight{};
+		float m_MaxMipLevel{};
 
-		SDL_Surface* m_pSurface{ nullptr };
-		uint32_t* m_pSurfacePixels{ nullptr };
+		static MipLevel CreateMipLevel(int width, int height);
+		void BuildMipLevels();
+		void CreateResource(ID3D11Device* pDevice, DXGI_FORMAT format, const std::vector<D3D11_SUBRESOURCE_DATA>& initData);
+		float GetMipLevel(const Vector2& uvDdx, const Vector2& uvDdy) const;
+		// The index of texel x, y is GetColumn(x) + GetRow(level, y) in both layouts
+		size_t GetColumn(int x) const;
+		size_t GetRow(const MipLevel& level, int y) const;
+		ColorRGB Fetch(const MipLevel& level, size_t idx) const;
+		// The texel from the decoded block cache of the calling thread, DecodeBlock fills an entry on a miss
+		uint32_t FetchCompressed(const MipLevel& level, size_t idx) const;
+		void DecodeBlock(const MipLevel& level, size_t blockIdx, size_t entry) const;
+		// Fetch of the texel at x, y after the address modes, or the border color
+		ColorRGB FetchAddressed(const MipLevel& level, int x, int y, const Sampler& sampler) const;
+		ColorRGB SamplePoint(const MipLevel& level, const Vector2& uv, const Sampler& sampler) const;
+		ColorRGB SampleBilinear(const MipLevel& level, const Vector2& uv, const Sampler& sampler) const;
 
 		ID3D11Texture2D* m_pResource{ nullptr };
 		ID3D11ShaderResourceView* m_pSRV{ nullptr };
@@ -0,0 +1,406 @@
+#include "pch.h"
+#include "Benchmarks.h"
+#include "Renderer.h"
+#include "Texture.h"
+#include "Dds.h"
+
+#include <bit>
+#include <filesystem>
+#include <memory>
+#include <random>
+
+namespace dae
+{
+	namespace
+	{
+		// Keeps the samples from being optimized away
+		volatile float SampleSink{};
+
+		// Random uvs read a texel of a different cache line nearly every time, the scanline ones walk the texels in memory order
+		std::vector<Vector2> CreateRandomUVs(size_t nrUVs)
+		{
+			std::mt19937 generator{ 1234 };
+			std::uniform_real_distribution<float> distribution{ 0.f, 1.f };
+			std::vector<Vector2> uvs(nrUVs);
+			for (Vector2& uv : uvs)
+			{
+				uv = { distribution(generator), distribution(generator) };
+			}
+			return uvs;
+		}
+
+		std::vector<Vector2> CreateScanlineUVs(int width, int height)
+		{
+			std::vector<Vector2> uvs{};
+			uvs.reserve(size_t(width) * height);
+			for (int y{}; y < height; ++y)
+			{
+				for (int x{}; x < width; ++x)
+				{
+					uvs.push_back({ (x + 0.5f) / width, (y + 0.5f) / height });
+				}
+			}
+			return uvs;
+		}
+
+		// A set associative cache of 64 byte lines that evicts the least recently used one, the lines of a set are kept
+		// most recent first. Stands in for the hardware cache counters, which are not available on every machine
+		class CacheModel final
+		{
+		public:
+			CacheModel(size_t size, size_t nrWays) :
+				m_NrWays{ nrWays },
+				m_NrSets{ size / LineSize / nrWays },
+				m_Lines(m_NrSets * nrWays, UINT64_MAX)
+			{
+			}
+
+			void Access(uint64_t address)
+			{
+				const uint64_t line{ address / LineSize };
+				const auto first{ m_Lines.begin() + ptrdiff_t(line % m_NrSets * m_NrWays) };
+				const auto last{ first + ptrdiff_t(m_NrWays) };
+				auto it{ std::find(first, last, line) };
+				if (it == last)
+				{
+					++m_NrMisses;
+					it = last - 1;
+					*it = line;
+				}
+				std::rotate(first, it, it + 1);
+				++m_NrAccesses;
+			}
+
+			double GetMissRatio() const { return double(m_NrMisses) / m_NrAccesses; }
+
+		private:
+			static constexpr size_t LineSize{ 64 };
+
+			size_t m_NrWays;
+			size_t m_NrSets;
+			std::vector<uint64_t> m_Lines;
+			uint64_t m_NrAccesses{};
+			uint64_t m_NrMisses{};
+		};
+
+		// A square of 512x512 pixels turned by 30 degrees with minification texels of the full resolution level per pixel,
+		// the uvs wrap past the texture. Every pixel gets its uv and the uv steps to its neighbours like the rasterizer gives them
+		struct MinifiedQuad final
+		{
+			std::vector<Vector2> uvs{};
+			Vector2 uvDdx{};
+			Vector2 uvDdy{};
+		};
+
+		MinifiedQuad CreateMinifiedQuad(int textureSize, int minification)
+		{
+			constexpr int size{ 512 };
+			const float step{ float(minification) / textureSize };
+			const float cosAngle{ cosf(PI / 6.f) };
+			const float sinAngle{ sinf(PI / 6.f) };
+
+			MinifiedQuad quad{ {}, { cosAngle * step, sinAngle * step }, { -sinAngle * step, cosAngle * step } };
+			quad.uvs.reserve(size_t(size) * size);
+			for (int y{}; y < size; ++y)
+			{
+				for (int x{}; x < size; ++x)
+				{
+					const Vector2 offset{ x - size * 0.5f, y - size * 0.5f };
+					quad.uvs.push_back(Vector2{ 0.5f, 0.5f } + quad.uvDdx * offset.x + quad.uvDdy * offset.y);
+				}
+			}
+			return quad;
+		}
+
+		// Misses per point sample of the linear layout in a 32 KiB 8 way cache like the L1 of most desktop CPUs,
+		// with the texel addresses the point filter reads from the level it picks
+		double GetPointMissRatio(const Texture& texture, const std::vector<Vector2>& uvs, size_t levelIdx)
+		{
+			uint64_t levelAddress{};
+			for (size_t idx{}; idx < levelIdx; ++idx)
+			{
+				levelAddress += uint64_t(texture.GetMipWidth(idx)) * texture.GetMipHeight(idx) * sizeof(uint32_t);
+			}
+
+			const int width{ texture.GetMipWidth(levelIdx) };
+			const int height{ texture.GetMipHeight(levelIdx) };
+			CacheModel cache{ 32 * 1024, 8 };
+			for (const Vector2& uv : uvs)
+			{
+				const int x{ int(floorf(uv.x * width)) & (width - 1) };
+				const int y{ int(floorf(uv.y * height)) & (height - 1) };
+				cache.Access(levelAddress + (uint64_t(y) * width + x) * sizeof(uint32_t));
+			}
+			return cache.GetMissRatio();
+		}
+
+		// Samples every uv nrRepeats times, in M samples per second
+		template<typename Sampler>
+		double MeasureSamples(const std::vector<Vector2>& uvs, int nrRepeats, const Sampler& sample)
+		{
+			ColorRGB sum{};
+			const uint64_t startCounter{ SDL_GetPerformanceCounter() };
+			for (int repeatIdx{}; repeatIdx < nrRepeats; ++repeatIdx)
+			{
+				for (const Vector2& uv : uvs)
+				{
+					sum += sample(uv);
+				}
+			}
+			const double ms{ Benchmarks::GetMilliseconds(startCounter) };
+			SampleSink = sum.r + sum.g + sum.b;
+			return double(uvs.size()) * nrRepeats / ms / 1000.0;
+		}
+	}
+
+	void Benchmarks::RunTextureSampling(SDL_Window*)
+	{
+		constexpr const char* pPath{ "Resources/vehicle_diffuse.png" };
+
+		// Before: every sample converted the texel of the surface IMG_Load made with SDL_GetRGB and divided by 255
+		const std::unique_ptr<SDL_Surface, void(*)(SDL_Surface*)> pSurface{ IMG_Load(pPath), &SDL_FreeSurface };
+		const std::unique_ptr<Texture> pTexture{ Texture::LoadFromFile(pPath, nullptr) };
+		const std::unique_ptr<Texture> pFloatTexture{ Texture::LoadFromFile(pPath, nullptr, true) };
+		if (!pSurface || pSurface->format->BytesPerPixel != 4 || !pTexture || !pFloatTexture)
+		{
+			std::cout << "Could not load " << pPath << " as a 32 bit surface\n";
+			return;
+		}
+
+		const SDL_Surface& surface{ *pSurface };
+		const uint32_t* pSurfacePixels{ static_cast<const uint32_t*>(surface.pixels) };
+		const auto sampleSurface{ [&](const Vector2& uv)
+			{
+				const int x{ int(uv.x * surface.w) };
+				const int y{ int(uv.y * surface.h) };
+				Uint8 r{};
+				Uint8 g{};
+				Uint8 b{};
+				SDL_GetRGB(pSurfacePixels[x + y * surface.w], surface.format, &r, &g, &b);
+				return ColorRGB{ r / 255.f, g / 255.f, b / 255.f };
+			} };
+
+		// After: point samples of the full resolution level, the derivatives of 0 never pick another one
+		const Texture::Sampler sampler{};
+		const auto sampleTexture{ [&](const Texture& texture)
+			{
+				return [&](const Vector2& uv) { return texture.Sample(uv, {}, {}, sampler); };
+			} };
+
+		std::cout << pPath << " (" << surface.w << "x" << surface.h << "), point samples of the full resolution level on one thread\n";
+		const std::pair<const char*, std::vector<Vector2>> uvSets[]{ { "random", CreateRandomUVs(size_t(1) << 22) }, { "scanline", CreateScanlineUVs(surface.w, surface.h) } };
+		for (const auto& [pName, uvs] : uvSets)
+		{
+			const double surfaceSamples{ MeasureSamples(uvs, 4, sampleSurface) };
+			const double texelSamples{ MeasureSamples(uvs, 4, sampleTexture(*pTexture)) };
+			const double floatSamples{ MeasureSamples(uvs, 4, sampleTexture(*pFloatTexture)) };
+			std::cout << pName << " uvs: SDL_GetRGB " << surfaceSamples << "M samples/s"
+				<< " | RGBA8 " << texelSamples << "M samples/s (" << texelSamples / surfaceSamples << "x)"
+				<< " | float " << floatSamples << "M samples/s (" << floatSamples / surfaceSamples << "x)\n";
+		}
+	}
+
+	void Benchmarks::RunFilterDistance(SDL_Window* pWindow)
+	{
+		constexpr const char* pPath{ "Resources/vehicle_diffuse.png" };
+		const std::unique_ptr<Texture> pTexture{ Texture::LoadFromFile(pPath, nullptr) };
+		const int textureSize{ pTexture ? pTexture->GetMipWidth(0) : 0 };
+		if (textureSize == 0 || textureSize != pTexture->GetMipHeight(0) || !std::has_single_bit(uint32_t(textureSize)))
+		{
+			std::cout << "Could not load " << pPath << " as a square power of two texture\n";
+			return;
+		}
+
+		// Derivatives of 0 always read the full resolution level, like the sampler did before the mip chain
+		std::cout << pPath << " on a quad turned by 30 degrees, on one thread\n";
+		for (int minification{ 1 }; minification <= 16; minification *= 2)
+		{
+			const MinifiedQuad quad{ CreateMinifiedQuad(textureSize, minification) };
+			const auto measureFilter{ [&](Texture::Filter filter, bool usesMipLevels)
+				{
+					const Texture::Sampler sampler{ filter };
+					const Vector2 uvDdx{ usesMipLevels ? quad.uvDdx : Vector2{} };
+					const Vector2 uvDdy{ usesMipLevels ? quad.uvDdy : Vector2{} };
+					return MeasureSamples(quad.uvs, 4, [&](const Vector2& uv) { return pTexture->Sample(uv, uvDdx, uvDdy, sampler); });
+				} };
+
+			const size_t levelIdx{ size_t(std::countr_zero(uint32_t(minification))) };
+			std::cout << minification << " texels per pixel: full resolution point " << measureFilter(Texture::Filter::Point, false) << "M samples/s, "
+				<< GetPointMissRatio(*pTexture, quad.uvs, 0) * 100.0 << "% L1 misses"
+				<< " | level " << levelIdx << " point " << measureFilter(Texture::Filter::Point, true) << "M samples/s, "
+				<< GetPointMissRatio(*pTexture, quad.uvs, levelIdx) * 100.0 << "% L1 misses"
+				<< " | bilinear " << measureFilter(Texture::Filter::Bilinear, true) << "M samples/s"
+				<< " | trilinear " << measureFilter(Texture::Filter::Trilinear, true) << "M samples/s\n";
+		}
+
+		// The software frame of the vehicle with every filter while the camera backs away, the filters cycle from point
+		Renderer renderer{ pWindow };
+		renderer.ToggleDirectX();
+		Timer timer{};
+		constexpr float vehicleZ{ 50.f };
+		constexpr int nrFrames{ 50 };
+		for (const float distance : { 10.f, 50.f, 95.f })
+		{
+			renderer.SetCameraOrigin({ 0.f, 0.f, vehicleZ - distance });
+
+			// Cycling the filter prints it, the line goes out once all three are done
+			double frameMs[3]{};
+			for (double& ms : frameMs)
+			{
+				if (!RenderFrames(renderer, timer, nrFrames))
+					return;
+
+				const Renderer::Statistics& statistics{ renderer.GetStatistics() };
+				ms = (statistics.vertexMs + statistics.setupMs + statistics.rasterMs) / nrFrames;
+				renderer.ToggleFilteringMethod();
+			}
+			std::cout << "distance " << distance << ": point " << frameMs[0] << "ms | bilinear " << frameMs[1] << "ms | trilinear " << frameMs[2] << "ms\n";
+		}
+	}
+
+	void Benchmarks::RunTexelLayouts(SDL_Window* pWindow)
+	{
+		// The vehicle turns with the wall clock, so the layouts take turns every few frames until it made a whole turn
+		// and both got about the same angles
+		Renderer renderer{ pWindow };
+		renderer.ToggleDirectX();
+		renderer.ToggleRotation();
+		Timer timer{};
+		timer.Start();
+
+		constexpr int nrBlockFrames{ 4 };
+		// At 45 degrees per second
+		constexpr double turnMs{ 8000.0 };
+		for (const char* pFilter : { "point", "bilinear", "trilinear" })
+		{
+			if (!RenderFrames(renderer, timer, nrBlockFrames))
+				return;
+
+			double frameMs[2]{};
+			const uint64_t startCounter{ SDL_GetPerformanceCounter() };
+			int nrBlocks{};
+			while (nrBlocks % 2 != 0 || GetMilliseconds(startCounter) < turnMs)
+			{
+				renderer.ResetStatistics();
+				for (int frameIdx{}; frameIdx < nrBlockFrames; ++frameIdx)
+				{
+					timer.Update();
+					renderer.Update(&timer);
+					renderer.Render();
+				}
+
+				// The blocks start linear
+				const Renderer::Statistics& statistics{ renderer.GetStatistics() };
+				frameMs[nrBlocks % 2] += statistics.vertexMs + statistics.setupMs + statistics.rasterMs;
+				++nrBlocks;
+
+				const SilencedOutput silencedOutput{};
+				renderer.ToggleTexelLayout();
+			}
+
+			const int nrFrames{ nrBlocks / 2 * nrBlockFrames };
+			std::cout << pFilter << ", " << nrFrames << " frames each: linear " << frameMs[0] / nrFrames << "ms | tiled " << frameMs[1] / nrFrames
+				<< "ms (" << frameMs[0] / frameMs[1] << "x)\n";
+			renderer.ToggleFilteringMethod();
+		}
+	}
+
+	void Benchmarks::RunBlockCompression(SDL_Window*)
+	{
+		// The formats the TextureCompressor gives them
+		const std::pair<const char*, BlockCompression::Format> textures[]
+		{
+			{ "Resources/vehicle_diffuse.png", BlockCompression::Format::BC7 },
+			{ "Resources/vehicle_normal.png", BlockCompression::Format::BC5 },
+			{ "Resources/vehicle_specular.png", BlockCompression::Format::BC1 },
+			{ "Resources/vehicle_gloss.png", BlockCompression::Format::BC1 }
+		};
+		const std::string ddsPath{ (std::filesystem::temp_directory_path() / "DualRasterizerBlocks.dds").string() };
+		const Texture::Sampler sampler{};
+		const std::vector<Vector2> randomUVs{ CreateRandomUVs(size_t(1) << 22) };
+
+		std::cout << "Point samples of the full resolution level on one thread, the RGBA8 textures tiled like the compressed ones\n";
+		size_t rgbaSize[2]{};
+		size_t compressedSize[2]{};
+		for (const auto& [pPath, format] : textures)
+		{
+			std::unique_ptr<Texture> pTexture{};
+			std::unique_ptr<Texture> pCompressedTexture{};
+			double encodeMs{};
+			{
+				const SilencedOutput silencedOutput{};
+				pTexture.reset(Texture::LoadFromFile(pPath, nullptr));
+				if (pTexture)
+				{
+					// Every mip level the way the TextureCompressor writes them, through a .dds like the renderer loads them
+					Dds::Image image{ format, pTexture->GetMipWidth(0), pTexture->GetMipHeight(0) };
+					const uint64_t encodeStartCounter{ SDL_GetPerformanceCounter() };
+					for (size_t levelIdx{}; levelIdx < pTexture->GetNrMipLevels(); ++levelIdx)
+					{
+						const std::vector<uint32_t> texels{ pTexture->GetMipTexels(levelIdx) };
+						image.levels.push_back(BlockCompression::Encode(format, texels.data(), pTexture->GetMipWidth(levelIdx), pTexture->GetMipHeight(levelIdx)));
+					}
+					encodeMs = GetMilliseconds(encodeStartCounter);
+					if (Dds::Write(ddsPath, image))
+						pCompressedTexture.reset(Texture::LoadFromFile(ddsPath, nullptr));
+				}
+			}
+			if (!pTexture || !pCompressedTexture)
+			{
+				std::cout << "Could not compress " << pPath << '\n';
+				continue;
+			}
+			pTexture->SetLayout(Texture::TexelLayout::Tiled);
+
+			// Every block of the full resolution level, the way the sampler fills its cache
+			Dds::Image image{};
+			Dds::Read(ddsPath, image);
+			const std::vector<uint8_t>& blocks{ image.levels.front() };
+			const size_t blockSize{ BlockCompression::GetBlockSize(format) };
+			const size_t nrBlocks{ blocks.size() / blockSize };
+			constexpr int nrDecodeRepeats{ 4 };
+			uint32_t decodedTexels[BlockCompression::TexelsPerBlock]{};
+			uint32_t texelSum{};
+			const uint64_t decodeStartCounter{ SDL_GetPerformanceCounter() };
+			for (int repeatIdx{}; repeatIdx < nrDecodeRepeats; ++repeatIdx)
+			{
+				for (size_t blockIdx{}; blockIdx < nrBlocks; ++blockIdx)
+				{
+					BlockCompression::DecodeBlock(format, blocks.data() + blockIdx * blockSize, decodedTexels);
+					texelSum += decodedTexels[blockIdx % BlockCompression::TexelsPerBlock];
+				}
+			}
+			const double decodeMs{ GetMilliseconds(decodeStartCounter) };
+			SampleSink = float(texelSum);
+			const double decodedMB{ double(nrBlocks) * nrDecodeRepeats * sizeof(decodedTexels) / (1024.0 * 1024.0) };
+
+			const auto sampleTexture{ [&](const Texture& texture)
+				{
+					return [&](const Vector2& uv) { return texture.Sample(uv, {}, {}, sampler); };
+				} };
+			const std::vector<Vector2> scanlineUVs{ CreateScanlineUVs(pTexture->GetMipWidth(0), pTexture->GetMipHeight(0)) };
+			std::cout << pPath << " (" << pTexture->GetMipWidth(0) << "x" << pTexture->GetMipHeight(0) << ") as " << BlockCompression::GetName(format)
+				<< ": encode " << encodeMs << "ms | decode " << nrBlocks * nrDecodeRepeats / decodeMs / 1000.0 << "M blocks/s (" << decodedMB / decodeMs * 1000.0 << "MB/s of texels)\n";
+			for (const auto& [pName, uvs] : { std::pair{ "random", &randomUVs }, std::pair{ "scanline", &scanlineUVs } })
+			{
+				const double texelSamples{ MeasureSamples(*uvs, 2, sampleTexture(*pTexture)) };
+				const double compressedSamples{ MeasureSamples(*uvs, 2, sampleTexture(*pCompressedTexture)) };
+				std::cout << "  " << pName << " uvs: RGBA8 " << texelSamples << "M samples/s | " << BlockCompression::GetName(format) << ' '
+					<< compressedSamples << "M samples/s (" << compressedSamples / texelSamples << "x)\n";
+			}
+			std::cout << "  memory: RGBA8 " << pTexture->GetSoftwareMemorySize() / 1024 << "KiB software, " << pTexture->GetHardwareMemorySize() / 1024 << "KiB hardware | "
+				<< BlockCompression::GetName(format) << ' ' << pCompressedTexture->GetSoftwareMemorySize() / 1024 << "KiB software, "
+				<< pCompressedTexture->GetHardwareMemorySize() / 1024 << "KiB hardware\n";
+
+			rgbaSize[0] += pTexture->GetSoftwareMemorySize();
+			rgbaSize[1] += pTexture->GetHardwareMemorySize();
+			compressedSize[0] += pCompressedTexture->GetSoftwareMemorySize();
+			compressedSize[1] += pCompressedTexture->GetHardwareMemorySize();
+		}
+		std::filesystem::remove(ddsPath);
+
+		constexpr double mebibyte{ 1024.0 * 1024.0 };
+		std::cout << "Material set: RGBA8 " << rgbaSize[0] / mebibyte << "MiB software, " << rgbaSize[1] / mebibyte << "MiB hardware | compressed "
+			<< compressedSize[0] / mebibyte << "MiB software, " << compressedSize[1] / mebibyte << "MiB hardware\n";
+	}
+}
@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "Texture.h"
+#include "Dds.h"
+#include "MappedFile.h"
+
+#include <cmath>
+#include <filesystem>
+
+using namespace dae;
+
+// Offline tool: writes block compressed .dds files with the full mip chain, the renderer loads them instead of the image next to them
+
+namespace
+{
+	struct Job final
+	{
+		const char* path;
+		BlockCompression::Format format;
+	};
+
+	// Color maps with detail get BC7, the normal map BC5 for two full channels, the gray maps BC1
+	constexpr Job DefaultJobs[]{
+		{ "Resources/vehicle_diffuse.png", BlockCompression::Format::BC7 },
+		{ "Resources/vehicle_normal.png", BlockCompression::Format::BC5 },
+		{ "Resources/vehicle_specular.png", BlockCompression::Format::BC1 },
+		{ "Resources/vehicle_gloss.png", BlockCompression::Format::BC1 },
+		{ "Resources/fireFX_diffuse.png", BlockCompression::Format::BC7 }
+	};
+
+	// Over the channels the format stores, of the decoded full resolution level against the source
+	double GetPsnr(BlockCompression::Format format, const std::vector<uint8_t>& blocks, const std::vector<uint32_t>& texels, int width, int height)
+	{
+		const int nrChannels{ format == BlockCompression::Format::BC5 ? 2 : format == BlockCompression::Format::BC1 ? 3 : 4 };
+		const int nrBlocksX{ (width + BlockCompression::BlockDimension - 1) / BlockCompression::BlockDimension };
+		const size_t blockSize{ BlockCompression::GetBlockSize(format) };
+
+		double squaredError{};
+		for (size_t blockIdx{}; blockIdx * blockSize < blocks.size(); ++blockIdx)
+		{
+			uint32_t decoded[BlockCompression::TexelsPerBlock];
+			BlockCompression::DecodeBlock(format, blocks.data() + blockIdx * blockSize, decoded);
+			for (int texelIdx{}; texelIdx < BlockCompression::TexelsPerBlock; ++texelIdx)
+			{
+				const int x{ int(blockIdx % nrBlocksX) * BlockCompression::BlockDimension + texelIdx % BlockCompression::BlockDimension };
+				const int y{ int(blockIdx / nrBlocksX) * BlockCompression::BlockDimension + texelIdx / BlockCompression::BlockDimension };
+				if (x >= width || y >= height)
+					continue;
+
+				for (int channel{}; channel < nrChannels; ++channel)
+				{
+					const double difference{ double(decoded[texelIdx] >> (8 * channel) & 0xFF) - double(texels[size_t(y) * width + x] >> (8 * channel) & 0xFF) };
+					squaredError += difference * difference;
+				}
+			}
+		}
+
+		const double meanSquaredError{ squaredError / (double(width) * height * nrChannels) };
+		return meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : INFINITY;
+	}
+
+	bool Compress(const std::string& sourcePath, const std::string& destinationPath, BlockCompression::Format format)
+	{
+		// Without a device: the mip levels the renderer would make, nothing on the GPU
+		const std::unique_ptr<Texture> pTexture{ Texture::LoadFromFile(sourcePath, nullptr) };
+		if (!pTexture)
+			return false;
+
+		// D3D11 only creates block compressed textures whose full resolution level is a whole number of blocks
+		if (pTexture->GetMipWidth(0) % BlockCompression::BlockDimension != 0 || pTexture->GetMipHeight(0) % BlockCompression::BlockDimension != 0)
+		{
+			std::cout << sourcePath << ": " << pTexture->GetMipWidth(0) << "x" << pTexture->GetMipHeight(0)
+				<< " is not a whole number of blocks, it stays uncompressed\n";
+			return false;
+		}
+
+		const uint64_t startTime{ SDL_GetPerformanceCounter() };
+		Dds::Image image{ format, pTexture->GetMipWidth(0), pTexture->GetMipHeight(0) };
+		// The renderer only uses the file as long as the image did not change
+		image.sourceHash = MappedFile{ sourcePath }.GetHash();
+		double psnr{};
+		for (size_t levelIdx{}; levelIdx < pTexture->GetNrMipLevels(); ++levelIdx)
+		{
+			const int width{ pTexture->GetMipWidth(levelIdx) };
+			const int height{ pTexture->GetMipHeight(levelIdx) };
+			const std::vector<uint32_t> texels{ pTexture->GetMipTexels(levelIdx) };
+			image.levels.push_back(BlockCompression::Encode(format, texels.data(), width, height));
+			if (levelIdx == 0)
+				psnr = GetPsnr(format, image.levels.front(), texels, width, height);
+		}
+		const double milliseconds{ (SDL_GetPerformanceCounter() - startTime) * 1000.0 / SDL_GetPerformanceFrequency() };
+
+		if (!Dds::Write(destinationPath, image))
+		{
+			std::cout << destinationPath << ": could not write\n";
+			return false;
+		}
+
+		size_t size{};
+		for (const std::vector<uint8_t>& level : image.levels)
+		{
+			size += level.size();
+		}
+		std::cout << destinationPath << ": " << BlockCompression::GetName(format) << " in " << milliseconds << "ms, "
+			<< size / 1024 << "KiB for " << image.levels.size() << " mip levels, PSNR " << psnr << "dB\n";
+		return true;
+	}
+}
+
+int main(int argc, char* args[])
+{
+	if (argc == 4)
+	{
+		BlockCompression::Format format{};
+		if (!BlockCompression::GetFormat(args[3], format))
+		{
+			std::cout << "Unknown format " << args[3] << ", expected BC1, BC3, BC5 or BC7\n";
+			return 1;
+		}
+		return Compress(args[1], args[2], format) ? 0 : 1;
+	}
+	if (argc != 1)
+	{
+		std::cout << "Usage: TextureCompressor <image> <output.dds> <BC1|BC3|BC5|BC7>\n"
+			<< "Without arguments every texture of the scene is compressed next to its image\n";
+		return 1;
+	}
+
+	bool succeeded{ true };
+	for (const Job& job : DefaultJobs)
+	{
+		succeeded &= Compress(job.path, std::filesystem::path{ job.path }.replace_extension(".dds").string(), job.format);
+	}
+	return succeeded ? 0 : 1;
+}
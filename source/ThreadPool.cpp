@@ -0,0 +1,112 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+using namespace dae;
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	SetThreadCount(threadCount);
+}
+
+ThreadPool::~ThreadPool()
+{
+	StopWorkers();
+}
+
+void ThreadPool::SetThreadCount(uint32_t threadCount)
+{
+	threadCount = std::max(threadCount, 1u);
+	if (threadCount == GetThreadCount())
+		return;
+
+	StopWorkers();
+	StartWorkers(threadCount - 1);
+}
+
+void ThreadPool::Dispatch(uint32_t count, JobFunction pFunction, void* pContext)
+{
+	if (count == 0)
+		return;
+
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_pJobFunction = pFunction;
+		m_pJobContext = pContext;
+		m_JobCount = count;
+		m_NextJob = 0;
+		m_BusyWorkers = static_cast<uint32_t>(m_Workers.size());
+		++m_Generation;
+	}
+	m_WakeCondition.notify_all();
+
+	// The calling thread works along instead of idling
+	RunJobs();
+
+	std::unique_lock lock{ m_Mutex };
+	m_DoneCondition.wait(lock, [this] { return m_BusyWorkers == 0; });
+}
+
+void ThreadPool::WorkerLoop(uint64_t startGeneration)
+{
+	uint64_t lastGeneration{ startGeneration };
+	while (true)
+	{
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_WakeCondition.wait(lock, [&] { return m_IsStopping || m_Generation != lastGeneration; });
+			if (m_IsStopping)
+				return;
+
+			lastGeneration = m_Generation;
+		}
+
+		RunJobs();
+
+		{
+			std::lock_guard lock{ m_Mutex };
+			--m_BusyWorkers;
+			if (m_BusyWorkers == 0)
+				m_DoneCondition.notify_one();
+		}
+	}
+}
+
+void ThreadPool::RunJobs()
+{
+	for (uint32_t job{ m_NextJob.fetch_add(1) }; job < m_JobCount; job = m_NextJob.fetch_add(1))
+	{
+		m_pJobFunction(m_pJobContext, job);
+	}
+}
+
+void ThreadPool::StartWorkers(uint32_t workerCount)
+{
+	// Read before the threads run: a Dispatch between their creation and their first lock is still theirs to help with
+	uint64_t startGeneration{};
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_IsStopping = false;
+		startGeneration = m_Generation;
+	}
+
+	m_Workers.reserve(workerCount);
+	for (uint32_t i{}; i < workerCount; ++i)
+	{
+		m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, startGeneration);
+	}
+}
+
+void ThreadPool::StopWorkers()
+{
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_IsStopping = true;
+	}
+	m_WakeCondition.notify_all();
+
+	for (std::thread& worker : m_Workers)
+	{
+		worker.join();
+	}
+	m_Workers.clear();
+}
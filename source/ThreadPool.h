@@ -0,0 +1,59 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace dae
+{
+	class ThreadPool final
+	{
+	public:
+		// threadCount includes the calling thread, which always helps out during ParallelFor
+		explicit ThreadPool(uint32_t threadCount);
+		~ThreadPool();
+
+		// rule of 5 copypasta
+		ThreadPool(const ThreadPool& other) = delete;
+		ThreadPool(ThreadPool&& other) = delete;
+		ThreadPool& operator=(const ThreadPool& other) = delete;
+		ThreadPool& operator=(ThreadPool&& other) = delete;
+
+		void SetThreadCount(uint32_t threadCount);
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Workers.size()) + 1; }
+
+		// Calls func(index) for every index in [0, count) and blocks until all calls have returned
+		// Indices are handed out one by one, so the work per index does not have to be balanced
+		template<typename Func>
+		void ParallelFor(uint32_t count, Func&& func)
+		{
+			using FuncType = std::remove_reference_t<Func>;
+			Dispatch(count, [](void* pContext, uint32_t index) { (*static_cast<FuncType*>(pContext))(index); }, &func);
+		}
+
+	private:
+		using JobFunction = void(*)(void*, uint32_t);
+
+		void Dispatch(uint32_t count, JobFunction pFunction, void* pContext);
+		void WorkerLoop(uint64_t startGeneration);
+		void RunJobs();
+
+		void StartWorkers(uint32_t workerCount);
+		void StopWorkers();
+
+		std::vector<std::thread> m_Workers{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_WakeCondition{};
+		std::condition_variable m_DoneCondition{};
+
+		uint64_t m_Generation{};
+		uint32_t m_BusyWorkers{};
+		bool m_IsStopping{ false };
+
+		JobFunction m_pJobFunction{ nullptr };
+		void* m_pJobContext{ nullptr };
+		uint32_t m_JobCount{};
+		std::atomic<uint32_t> m_NextJob{};
+	};
+}
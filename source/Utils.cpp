@@ -0,0 +1,332 @@
+#include "pch.h"
+#include "Utils.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include <charconv>
+#include <string_view>
+#include <unordered_map>
+
+namespace dae
+{
+	namespace
+	{
+		// The position, uv and normal indices of a face corner, 1-based, 0 marks a missing uv or normal
+		// Corners with the same ones share a vertex
+		struct FaceCorner final
+		{
+			int64_t indices[3]{};
+
+			bool operator==(const FaceCorner& other) const = default;
+		};
+
+		struct FaceCornerHash final
+		{
+			size_t operator()(const FaceCorner& corner) const
+			{
+				return size_t(corner.indices[0] * 73856093) ^ size_t(corner.indices[1] * 19349663) ^ size_t(corner.indices[2] * 83492791);
+			}
+		};
+
+		// Everything one thread parsed from its part of the file
+		// Negative indices count back from the last element read so far, which depends on the chunks before this one,
+		// so they are stored relative to the start of the chunk and get resolved while merging
+		struct ObjChunk final
+		{
+			std::vector<Vector3> positions{};
+			std::vector<Vector2> UVs{};
+			std::vector<Vector3> normals{};
+			std::vector<FaceCorner> corners{};	// three per triangle, polygons are fanned
+			std::vector<uint8_t> relativeMasks{};	// per corner, a bit for every index that is relative to the chunk
+			bool isValid{ true };
+		};
+
+		class ObjTokenizer final
+		{
+		public:
+			ObjTokenizer(const char* pBegin, const char* pEnd) : m_pCurrent{ pBegin }, m_pEnd{ pEnd } {}
+
+			bool IsAtEnd() const { return m_pCurrent >= m_pEnd; }
+
+			void SkipSpaces()
+			{
+				while (m_pCurrent < m_pEnd && (*m_pCurrent == ' ' || *m_pCurrent == '\t' || *m_pCurrent == '\r'))
+					++m_pCurrent;
+			}
+
+			void SkipLine()
+			{
+				while (m_pCurrent < m_pEnd && *m_pCurrent != '\n')
+					++m_pCurrent;
+				if (m_pCurrent < m_pEnd)
+					++m_pCurrent;
+			}
+
+			bool IsAtLineEnd()
+			{
+				SkipSpaces();
+				return m_pCurrent >= m_pEnd || *m_pCurrent == '\n' || *m_pCurrent == '#';
+			}
+
+			std::string_view ReadWord()
+			{
+				SkipSpaces();
+				const char* pWordBegin{ m_pCurrent };
+				while (m_pCurrent < m_pEnd && *m_pCurrent != ' ' && *m_pCurrent != '\t' && *m_pCurrent != '\r' && *m_pCurrent != '\n')
+					++m_pCurrent;
+				return { pWordBegin, size_t(m_pCurrent - pWordBegin) };
+			}
+
+			bool ReadFloat(float& value)
+			{
+				SkipSpaces();
+				if (m_pCurrent < m_pEnd && *m_pCurrent == '+')
+					++m_pCurrent;
+
+				const auto [pNext, error] { std::from_chars(m_pCurrent, m_pEnd, value) };
+				m_pCurrent = pNext;
+				return error == std::errc{};
+			}
+
+			bool ReadIndex(int64_t& value)
+			{
+				const auto [pNext, error] { std::from_chars(m_pCurrent, m_pEnd, value) };
+				m_pCurrent = pNext;
+				return error == std::errc{} && value != 0;
+			}
+
+			bool TryRead(char character)
+			{
+				if (m_pCurrent >= m_pEnd || *m_pCurrent != character)
+					return false;
+				++m_pCurrent;
+				return true;
+			}
+
+		private:
+			const char* m_pCurrent{};
+			const char* m_pEnd{};
+		};
+
+		bool ParseFaceCorner(ObjTokenizer& tokenizer, const ObjChunk& chunk, FaceCorner& corner, uint8_t& relativeMask)
+		{
+			// v, v/vt, v//vn or v/vt/vn
+			if (!tokenizer.ReadIndex(corner.indices[0]))
+				return false;
+
+			if (tokenizer.TryRead('/'))
+			{
+				if (!tokenizer.TryRead('/'))
+				{
+					if (!tokenizer.ReadIndex(corner.indices[1]))
+						return false;
+					if (tokenizer.TryRead('/') && !tokenizer.ReadIndex(corner.indices[2]))
+						return false;
+				}
+				else if (!tokenizer.ReadIndex(corner.indices[2]))
+				{
+					return false;
+				}
+			}
+
+			// -1 is the last element read so far
+			const size_t counts[3]{ chunk.positions.size(), chunk.UVs.size(), chunk.normals.size() };
+			relativeMask = 0;
+			for (int i{}; i < 3; ++i)
+			{
+				if (corner.indices[i] < 0)
+				{
+					corner.indices[i] += int64_t(counts[i]) + 1;
+					relativeMask |= 1 << i;
+				}
+			}
+			return true;
+		}
+
+		void ParseChunk(const char* pBegin, const char* pEnd, ObjChunk& chunk)
+		{
+			ObjTokenizer tokenizer{ pBegin, pEnd };
+			FaceCorner polygon[3]{};
+			uint8_t polygonMasks[3]{};
+
+			for (; !tokenizer.IsAtEnd() && chunk.isValid; tokenizer.SkipLine())
+			{
+				const std::string_view command{ tokenizer.ReadWord() };
+				if (command == "v")
+				{
+					//Vertex
+					Vector3 position{};
+					chunk.isValid = tokenizer.ReadFloat(position.x) && tokenizer.ReadFloat(position.y) && tokenizer.ReadFloat(position.z);
+					chunk.positions.emplace_back(position);
+				}
+				else if (command == "vt")
+				{
+					// Vertex TexCoord
+					float u{};
+					float v{};
+					chunk.isValid = tokenizer.ReadFloat(u) && tokenizer.ReadFloat(v);
+					chunk.UVs.emplace_back(u, 1 - v);
+				}
+				else if (command == "vn")
+				{
+					// Vertex Normal
+					Vector3 normal{};
+					chunk.isValid = tokenizer.ReadFloat(normal.x) && tokenizer.ReadFloat(normal.y) && tokenizer.ReadFloat(normal.z);
+					chunk.normals.emplace_back(normal);
+				}
+				else if (command == "f")
+				{
+					// Faces with more than 3 corners are split into a fan around the first one
+					int nrCorners{};
+					while (chunk.isValid && !tokenizer.IsAtLineEnd())
+					{
+						const int slot{ std::min(nrCorners, 2) };
+						polygon[slot] = {};
+						chunk.isValid = ParseFaceCorner(tokenizer, chunk, polygon[slot], polygonMasks[slot]);
+						++nrCorners;
+
+						if (chunk.isValid && nrCorners >= 3)
+						{
+							chunk.corners.insert(chunk.corners.end(), std::begin(polygon), std::end(polygon));
+							chunk.relativeMasks.insert(chunk.relativeMasks.end(), std::begin(polygonMasks), std::end(polygonMasks));
+							polygon[1] = polygon[2];
+							polygonMasks[1] = polygonMasks[2];
+						}
+					}
+					chunk.isValid = chunk.isValid && nrCorners >= 3;
+				}
+			}
+		}
+	}
+
+	namespace Utils
+	{
+		bool ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding, ThreadPool* pThreadPool)
+		{
+			const uint64_t startTime{ SDL_GetPerformanceCounter() };
+
+			const MappedFile file{ filename };
+			if (!file.IsOpen())
+				return false;
+
+			vertices.clear();
+			indices.clear();
+
+			// Chunks end on a line break, small files or a load without a pool are parsed by the calling thread alone
+			constexpr size_t minChunkSize{ 256 * 1024 };
+			const std::string_view data{ file.GetData() };
+			const size_t maxChunks{ pThreadPool ? pThreadPool->GetThreadCount() : 1u };
+			const size_t nrChunks{ std::clamp(data.size() / minChunkSize, size_t(1), maxChunks) };
+
+			std::vector<size_t> chunkStarts(nrChunks + 1, data.size());
+			chunkStarts[0] = 0;
+			for (size_t chunkIdx{ 1 }; chunkIdx < nrChunks; ++chunkIdx)
+			{
+				const size_t lineBreak{ data.find('\n', std::max(data.size() * chunkIdx / nrChunks, chunkStarts[chunkIdx - 1])) };
+				chunkStarts[chunkIdx] = lineBreak == std::string_view::npos ? data.size() : lineBreak + 1;
+			}
+
+			std::vector<ObjChunk> chunks(nrChunks);
+			if (nrChunks == 1)
+			{
+				ParseChunk(data.data(), data.data() + data.size(), chunks[0]);
+			}
+			else
+			{
+				pThreadPool->ParallelFor(uint32_t(nrChunks), [&](uint32_t chunkIdx)
+					{
+						ParseChunk(data.data() + chunkStarts[chunkIdx], data.data() + chunkStarts[chunkIdx + 1], chunks[chunkIdx]);
+					});
+			}
+
+			// Merge the chunks in file order, relative indices get the amount of elements of the chunks before
+			std::vector<Vector3> positions{};
+			std::vector<Vector3> normals{};
+			std::vector<Vector2> UVs{};
+			std::vector<FaceCorner> corners{};
+			for (ObjChunk& chunk : chunks)
+			{
+				if (!chunk.isValid)
+					return false;
+
+				const int64_t offsets[3]{ int64_t(positions.size()), int64_t(UVs.size()), int64_t(normals.size()) };
+				for (size_t cornerIdx{}; cornerIdx < chunk.corners.size(); ++cornerIdx)
+				{
+					FaceCorner corner{ chunk.corners[cornerIdx] };
+					for (int i{}; i < 3; ++i)
+					{
+						if (chunk.relativeMasks[cornerIdx] & (1 << i))
+							corner.indices[i] += offsets[i];
+					}
+					corners.emplace_back(corner);
+				}
+
+				positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+				UVs.insert(UVs.end(), chunk.UVs.begin(), chunk.UVs.end());
+				normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+			}
+
+			// Weld the corners into vertices
+			std::unordered_map<FaceCorner, uint32_t, FaceCornerHash> cornerVertices{};
+			cornerVertices.reserve(corners.size());
+			const int64_t counts[3]{ int64_t(positions.size()), int64_t(UVs.size()), int64_t(normals.size()) };
+			for (size_t triangleIdx{}; triangleIdx < corners.size() / 3; ++triangleIdx)
+			{
+				uint32_t tempIndices[3];
+				for (size_t iFace = 0; iFace < 3; iFace++)
+				{
+					const FaceCorner& corner{ corners[triangleIdx * 3 + iFace] };
+					for (int i{}; i < 3; ++i)
+					{
+						if (corner.indices[i] < 0 || corner.indices[i] > counts[i] || (i == 0 && corner.indices[i] == 0))
+							return false;
+					}
+
+					const auto [it, isNew] { cornerVertices.try_emplace(corner, uint32_t(vertices.size())) };
+					if (isNew)
+					{
+						Vertex vertex{};
+						vertex.position = positions[corner.indices[0] - 1];
+						if (corner.indices[1] != 0)
+							vertex.uv = UVs[corner.indices[1] - 1];
+						if (corner.indices[2] != 0)
+							vertex.normal = normals[corner.indices[2] - 1];
+
+						vertices.push_back(vertex);
+					}
+					tempIndices[iFace] = it->second;
+				}
+
+				indices.push_back(tempIndices[0]);
+				if (flipAxisAndWinding)
+				{
+					indices.push_back(tempIndices[2]);
+					indices.push_back(tempIndices[1]);
+				}
+				else
+				{
+					indices.push_back(tempIndices[1]);
+					indices.push_back(tempIndices[2]);
+				}
+			}
+
+			const double parseMs{ (SDL_GetPerformanceCounter() - startTime) * 1000.0 / SDL_GetPerformanceFrequency() };
+			const double megabytes{ data.size() / (1024.0 * 1024.0) };
+			std::cout << filename << ": parsed " << megabytes << "MB in " << parseMs << "ms";
+			if (parseMs > 0.0)
+				std::cout << " (" << megabytes * 1000.0 / parseMs << "MB/s)";
+			std::cout << " on " << nrChunks << " threads, welded " << corners.size() << " face corners into " << vertices.size() << " vertices\n";
+
+			if (flipAxisAndWinding)
+			{
+				for (Vertex& vertex : vertices)
+				{
+					vertex.position.z *= -1.f;
+					vertex.normal.z *= -1.f;
+				}
+			}
+
+			return true;
+		}
+	}
+}
@@ -0,0 +1,83 @@
+#include "pch.h"
+#include "Benchmarks.h"
+#include "Camera.h"
+#include "VertexKernels.h"
+#include "Utils.h"
+
+namespace dae
+{
+	namespace
+	{
+		// A flat grid of 1000x1000 vertices in front of the camera, bigger than any cache
+		std::vector<Vertex> CreateGridVertices()
+		{
+			constexpr int gridSize{ 1000 };
+			std::vector<Vertex> vertices{};
+			vertices.reserve(gridSize * gridSize);
+			for (int y{}; y < gridSize; ++y)
+			{
+				for (int x{}; x < gridSize; ++x)
+				{
+					const float u{ float(x) / (gridSize - 1) };
+					const float v{ float(y) / (gridSize - 1) };
+					vertices.push_back(Vertex{ { u * 40.f - 20.f, v * 40.f - 20.f, 0.f }, { u, v }, { 0.f, 0.f, -1.f }, { 1.f, 0.f, 0.f, 1.f } });
+				}
+			}
+			return vertices;
+		}
+
+		// Every supported kernel on one thread, so the numbers compare the instruction sets and not the thread count
+		void TransformVertices(const char* pName, const std::vector<Vertex>& vertices, int nrRepeats)
+		{
+			VertexStreams streams{};
+			streams.Assign(vertices);
+			std::vector<Vertex_Out> verticesOut(vertices.size());
+
+			// The mesh 50 units in front of the start view of the renderer
+			Camera camera{};
+			camera.Initialize(640.f / 480.f, 45.f, { 0.f, 0.f, 0.f });
+			const Timer timer{};
+			camera.Update(&timer);
+			const Matrix world{ Matrix::CreateTranslation(0.f, 0.f, 50.f) };
+			const Matrix worldViewProjection{ world * camera.GetViewMatrix() * camera.GetProjectionMatrix() };
+
+			double scalarVerticesPerSecond{};
+			for (const RasterKernelType type : { RasterKernelType::Scalar, RasterKernelType::SSE41, RasterKernelType::AVX2 })
+			{
+				if (!RasterKernels::IsSupported(type))
+					continue;
+
+				const VertexKernel kernel{ VertexKernels::GetKernel(type) };
+				kernel.pTransformVertices(streams, worldViewProjection, world, verticesOut.data(), 0, vertices.size());
+
+				const uint64_t startCounter{ SDL_GetPerformanceCounter() };
+				for (int repeatIdx{}; repeatIdx < nrRepeats; ++repeatIdx)
+				{
+					kernel.pTransformVertices(streams, worldViewProjection, world, verticesOut.data(), 0, vertices.size());
+				}
+				const double ms{ Benchmarks::GetMilliseconds(startCounter) };
+
+				const double verticesPerSecond{ double(vertices.size()) * nrRepeats / ms * 1000.0 };
+				if (type == RasterKernelType::Scalar)
+					scalarVerticesPerSecond = verticesPerSecond;
+
+				std::cout << pName << ", " << RasterKernels::GetName(type) << ": " << verticesPerSecond / 1e6 << "M vertices/s"
+					<< " (" << verticesPerSecond / scalarVerticesPerSecond << "x the scalar kernel)\n";
+			}
+		}
+	}
+
+	void Benchmarks::RunVertexTransform(SDL_Window*)
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		if (!Utils::ParseOBJ("Resources/vehicle.obj", vertices, indices))
+		{
+			std::cout << "Could not load Resources/vehicle.obj\n";
+			return;
+		}
+
+		TransformVertices("vehicle.obj", vertices, 200);
+		TransformVertices("1M vertex grid", CreateGridVertices(), 10);
+	}
+}
@@ -0,0 +1,363 @@
+#include "pch.h"
+#include "VertexKernels.h"
+#include "VertexQuantization.h"
+
+#include <cstring>
+#include <immintrin.h>
+
+namespace dae
+{
+	void VertexStreams::Assign(const std::vector<Vertex>& vertices)
+	{
+		nrVertices = vertices.size();
+		const size_t paddedSize{ (nrVertices + MaxLanes - 1) / MaxLanes * MaxLanes };
+
+		std::vector<float>* pStreams[]{ &positionX, &positionY, &positionZ, &normalX, &normalY, &normalZ, &tangentX, &tangentY, &tangentZ };
+		for (std::vector<float>* pStream : pStreams)
+		{
+			pStream->assign(paddedSize, 0.f);
+		}
+		uvs.assign(paddedSize, Vector2{});
+		tangentSigns.assign(paddedSize, 1);
+
+		for (size_t vertexIdx{}; vertexIdx < nrVertices; ++vertexIdx)
+		{
+			const Vertex& vertex{ vertices[vertexIdx] };
+			positionX[vertexIdx] = vertex.position.x;
+			positionY[vertexIdx] = vertex.position.y;
+			positionZ[vertexIdx] = vertex.position.z;
+			normalX[vertexIdx] = vertex.normal.x;
+			normalY[vertexIdx] = vertex.normal.y;
+			normalZ[vertexIdx] = vertex.normal.z;
+			tangentX[vertexIdx] = vertex.tangent.x;
+			tangentY[vertexIdx] = vertex.tangent.y;
+			tangentZ[vertexIdx] = vertex.tangent.z;
+			tangentSigns[vertexIdx] = vertex.tangent.w < 0.f ? -1 : 1;
+			uvs[vertexIdx] = vertex.uv;
+		}
+	}
+
+	size_t VertexStreams::GetMemorySize() const
+	{
+		return 9 * positionX.size() * sizeof(float) + uvs.size() * sizeof(Vector2) + tangentSigns.size() * sizeof(int8_t);
+	}
+
+	void QuantizedVertexStreams::Assign(const std::vector<Vertex>& vertices, const MeshBounds& bounds)
+	{
+		nrVertices = vertices.size();
+		const size_t paddedSize{ (nrVertices + VertexStreams::MaxLanes - 1) / VertexStreams::MaxLanes * VertexStreams::MaxLanes };
+
+		const VertexQuantization::PositionQuantization quantization{ VertexQuantization::GetPositionQuantization(bounds) };
+		positionOffset = quantization.offset;
+		positionScale = quantization.scale;
+
+		std::vector<uint16_t>* pUnsignedStreams[]{ &positionX, &positionY, &positionZ, &uvU, &uvV };
+		for (std::vector<uint16_t>* pStream : pUnsignedStreams)
+		{
+			pStream->assign(paddedSize, 0);
+		}
+		std::vector<int16_t>* pSignedStreams[]{ &normalU, &normalV, &tangentU, &tangentV };
+		for (std::vector<int16_t>* pStream : pSignedStreams)
+		{
+			pStream->assign(paddedSize, 0);
+		}
+		tangentSigns.assign(paddedSize, 1);
+
+		for (size_t vertexIdx{}; vertexIdx < nrVertices; ++vertexIdx)
+		{
+			const Vertex& vertex{ vertices[vertexIdx] };
+
+			uint16_t position[3]{};
+			VertexQuantization::EncodePosition(quantization, vertex.position, position);
+			positionX[vertexIdx] = position[0];
+			positionY[vertexIdx] = position[1];
+			positionZ[vertexIdx] = position[2];
+
+			int16_t direction[2]{};
+			VertexQuantization::EncodeOctahedral(vertex.normal, direction);
+			normalU[vertexIdx] = direction[0];
+			normalV[vertexIdx] = direction[1];
+			VertexQuantization::EncodeOctahedral(vertex.tangent.GetXYZ(), direction);
+			tangentU[vertexIdx] = direction[0];
+			tangentV[vertexIdx] = direction[1];
+			tangentSigns[vertexIdx] = vertex.tangent.w < 0.f ? -1 : 1;
+
+			uvU[vertexIdx] = VertexQuantization::FloatToHalf(vertex.uv.x);
+			uvV[vertexIdx] = VertexQuantization::FloatToHalf(vertex.uv.y);
+		}
+	}
+
+	size_t QuantizedVertexStreams::GetMemorySize() const
+	{
+		return 9 * positionX.size() * sizeof(uint16_t) + tangentSigns.size() * sizeof(int8_t);
+	}
+
+	namespace
+	{
+		// A half moved into the low bits of a float exponent and mantissa is 2^112 too small, exact for every finite half
+		constexpr uint32_t HalfMagnitudeMask{ 0x7FFF };
+		constexpr uint32_t HalfSignMask{ 0x8000 };
+		constexpr float HalfExponentScale{ 0x1p112f };
+
+		// The handful of operations the transform needs, for one vertex or a whole register of them
+		struct ScalarLanes final
+		{
+			using Type = float;
+			static constexpr int NrLanes{ 1 };
+
+			static Type Load(const float* pValues) { return *pValues; }
+			static Type Set(float value) { return value; }
+			static Type Add(Type a, Type b) { return a + b; }
+			static Type Mul(Type a, Type b) { return a * b; }
+			static Type Div(Type a, Type b) { return a / b; }
+			static Type Sqrt(Type a) { return sqrtf(a); }
+			static void Store(float* pValues, Type a) { *pValues = a; }
+
+			static Type LoadUnorm16(const uint16_t* pValues) { return float(*pValues); }
+			static Type LoadSnorm16(const int16_t* pValues) { return float(*pValues); }
+			static Type LoadHalf(const uint16_t* pValues)
+			{
+				const uint32_t bits{ ((*pValues & HalfMagnitudeMask) << 13) | ((*pValues & HalfSignMask) << 16) };
+				float value{};
+				std::memcpy(&value, &bits, sizeof(value));
+				return value * HalfExponentScale;
+			}
+			static Type Sub(Type a, Type b) { return a - b; }
+			static Type Max(Type a, Type b) { return a > b ? a : b; }
+			static Type Abs(Type a) { return fabsf(a); }
+			static Type CopySign(Type magnitude, Type sign) { return copysignf(magnitude, sign); }
+		};
+
+		struct SSE41Lanes final
+		{
+			using Type = __m128;
+			static constexpr int NrLanes{ 4 };
+
+			static Type Load(const float* pValues) { return _mm_loadu_ps(pValues); }
+			static Type Set(float value) { return _mm_set1_ps(value); }
+			static Type Add(Type a, Type b) { return _mm_add_ps(a, b); }
+			static Type Mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+			static Type Div(Type a, Type b) { return _mm_div_ps(a, b); }
+			static Type Sqrt(Type a) { return _mm_sqrt_ps(a); }
+			static void Store(float* pValues, Type a) { _mm_store_ps(pValues, a); }
+
+			static Type LoadUnorm16(const uint16_t* pValues) { return _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pValues)))); }
+			static Type LoadSnorm16(const int16_t* pValues) { return _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pValues)))); }
+			static Type LoadHalf(const uint16_t* pValues)
+			{
+				const __m128i half{ _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pValues))) };
+				const __m128i magnitude{ _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(HalfMagnitudeMask)), 13) };
+				const __m128i sign{ _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(HalfSignMask)), 16) };
+				return _mm_mul_ps(_mm_castsi128_ps(_mm_or_si128(magnitude, sign)), _mm_set1_ps(HalfExponentScale));
+			}
+			static Type Sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+			static Type Max(Type a, Type b) { return _mm_max_ps(a, b); }
+			static Type Abs(Type a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+			static Type CopySign(Type magnitude, Type sign) { return _mm_or_ps(Abs(magnitude), _mm_and_ps(_mm_set1_ps(-0.f), sign)); }
+		};
+
+		struct AVX2Lanes final
+		{
+			using Type = __m256;
+			static constexpr int NrLanes{ 8 };
+
+			static Type Load(const float* pValues) { return _mm256_loadu_ps(pValues); }
+			static Type Set(float value) { return _mm256_set1_ps(value); }
+			static Type Add(Type a, Type b) { return _mm256_add_ps(a, b); }
+			static Type Mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+			static Type Div(Type a, Type b) { return _mm256_div_ps(a, b); }
+			static Type Sqrt(Type a) { return _mm256_sqrt_ps(a); }
+			static void Store(float* pValues, Type a) { _mm256_store_ps(pValues, a); }
+
+			static Type LoadUnorm16(const uint16_t* pValues) { return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pValues)))); }
+			static Type LoadSnorm16(const int16_t* pValues) { return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pValues)))); }
+			static Type LoadHalf(const uint16_t* pValues)
+			{
+				const __m256i half{ _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pValues))) };
+				const __m256i magnitude{ _mm256_slli_epi32(_mm256_and_si256(half, _mm256_set1_epi32(HalfMagnitudeMask)), 13) };
+				const __m256i sign{ _mm256_slli_epi32(_mm256_and_si256(half, _mm256_set1_epi32(HalfSignMask)), 16) };
+				return _mm256_mul_ps(_mm256_castsi256_ps(_mm256_or_si256(magnitude, sign)), _mm256_set1_ps(HalfExponentScale));
+			}
+			static Type Sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+			static Type Max(Type a, Type b) { return _mm256_max_ps(a, b); }
+			static Type Abs(Type a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+			static Type CopySign(Type magnitude, Type sign) { return _mm256_or_ps(Abs(magnitude), _mm256_and_ps(_mm256_set1_ps(-0.f), sign)); }
+		};
+
+		// The object space attributes of a register of vertices
+		template<typename Lanes>
+		struct VertexLanes final
+		{
+			using Type = typename Lanes::Type;
+			Type positionX, positionY, positionZ;
+			Type normalX, normalY, normalZ;
+			Type tangentX, tangentY, tangentZ;
+		};
+
+		template<typename Lanes>
+		VertexLanes<Lanes> LoadVertices(const VertexStreams& streams, size_t first)
+		{
+			return {
+				Lanes::Load(&streams.positionX[first]), Lanes::Load(&streams.positionY[first]), Lanes::Load(&streams.positionZ[first]),
+				Lanes::Load(&streams.normalX[first]), Lanes::Load(&streams.normalY[first]), Lanes::Load(&streams.normalZ[first]),
+				Lanes::Load(&streams.tangentX[first]), Lanes::Load(&streams.tangentY[first]), Lanes::Load(&streams.tangentZ[first]) };
+		}
+
+		// Inverse of VertexQuantization::EncodeOctahedral without branches: unfolds the lower half and normalizes
+		template<typename Lanes>
+		void DecodeOctahedral(const int16_t* pEncodedU, const int16_t* pEncodedV,
+			typename Lanes::Type& x, typename Lanes::Type& y, typename Lanes::Type& z)
+		{
+			using Type = typename Lanes::Type;
+			const Type minusOne{ Lanes::Set(-1.f) };
+			const Type toSnorm{ Lanes::Set(1.f / 32767.f) };
+
+			x = Lanes::Max(Lanes::Mul(Lanes::LoadSnorm16(pEncodedU), toSnorm), minusOne);
+			y = Lanes::Max(Lanes::Mul(Lanes::LoadSnorm16(pEncodedV), toSnorm), minusOne);
+			z = Lanes::Sub(Lanes::Sub(Lanes::Set(1.f), Lanes::Abs(x)), Lanes::Abs(y));
+
+			// Only the lower half got folded, there -z is positive
+			const Type fold{ Lanes::Max(Lanes::Sub(Lanes::Set(0.f), z), Lanes::Set(0.f)) };
+			x = Lanes::Sub(x, Lanes::CopySign(fold, x));
+			y = Lanes::Sub(y, Lanes::CopySign(fold, y));
+
+			const Type invLength{ Lanes::Div(Lanes::Set(1.f), Lanes::Sqrt(Lanes::Add(Lanes::Add(Lanes::Mul(x, x), Lanes::Mul(y, y)), Lanes::Mul(z, z)))) };
+			x = Lanes::Mul(x, invLength);
+			y = Lanes::Mul(y, invLength);
+			z = Lanes::Mul(z, invLength);
+		}
+
+		template<typename Lanes>
+		VertexLanes<Lanes> LoadVertices(const QuantizedVertexStreams& streams, size_t first)
+		{
+			const auto decodePosition{ [](const uint16_t* pEncoded, float offset, float scale)
+				{
+					return Lanes::Add(Lanes::Mul(Lanes::LoadUnorm16(pEncoded), Lanes::Set(scale)), Lanes::Set(offset));
+				} };
+
+			VertexLanes<Lanes> vertices{};
+			vertices.positionX = decodePosition(&streams.positionX[first], streams.positionOffset.x, streams.positionScale.x);
+			vertices.positionY = decodePosition(&streams.positionY[first], streams.positionOffset.y, streams.positionScale.y);
+			vertices.positionZ = decodePosition(&streams.positionZ[first], streams.positionOffset.z, streams.positionScale.z);
+			DecodeOctahedral<Lanes>(&streams.normalU[first], &streams.normalV[first], vertices.normalX, vertices.normalY, vertices.normalZ);
+			DecodeOctahedral<Lanes>(&streams.tangentU[first], &streams.tangentV[first], vertices.tangentX, vertices.tangentY, vertices.tangentZ);
+			return vertices;
+		}
+
+		// The uvs of a register of vertices, the float ones are only copied
+		template<typename Lanes>
+		void LoadUVs(const VertexStreams& streams, size_t first, Vector2* pUVs)
+		{
+			std::copy_n(&streams.uvs[first], Lanes::NrLanes, pUVs);
+		}
+
+		template<typename Lanes>
+		void LoadUVs(const QuantizedVertexStreams& streams, size_t first, Vector2* pUVs)
+		{
+			alignas(32) float u[Lanes::NrLanes]{};
+			alignas(32) float v[Lanes::NrLanes]{};
+			Lanes::Store(u, Lanes::LoadHalf(&streams.uvU[first]));
+			Lanes::Store(v, Lanes::LoadHalf(&streams.uvV[first]));
+			for (int lane{}; lane < Lanes::NrLanes; ++lane)
+			{
+				pUVs[lane] = Vector2{ u[lane], v[lane] };
+			}
+		}
+
+		// Same order of operations as Matrix::TransformPoint, TransformVector and Vector3::Normalize,
+		// without FMA, so every kernel matches the scalar path bit for bit
+		template<typename Lanes, typename Streams>
+		void TransformVertices(const Streams& streams, const Matrix& worldViewProjection, const Matrix& world,
+			Vertex_Out* pVerticesOut, size_t first, size_t last)
+		{
+			using Type = typename Lanes::Type;
+			constexpr int NrLanes{ Lanes::NrLanes };
+
+			// Every matrix element broadcast to all lanes once
+			Type worldViewProjectionLanes[4][4]{};
+			Type worldLanes[3][3]{};
+			for (int i{}; i < 4; ++i)
+			{
+				for (int j{}; j < 4; ++j)
+				{
+					worldViewProjectionLanes[i][j] = Lanes::Set(worldViewProjection[i][j]);
+					if (i < 3 && j < 3)
+						worldLanes[i][j] = Lanes::Set(world[i][j]);
+				}
+			}
+
+			const auto transformPoint{ [&](int row, Type x, Type y, Type z)
+				{
+					const Type(&m)[4][4]{ worldViewProjectionLanes };
+					return Lanes::Add(Lanes::Add(Lanes::Add(Lanes::Mul(m[0][row], x), Lanes::Mul(m[1][row], y)), Lanes::Mul(m[2][row], z)), m[3][row]);
+				} };
+			const auto transformVector{ [&](int row, Type x, Type y, Type z)
+				{
+					const Type(&m)[3][3]{ worldLanes };
+					return Lanes::Add(Lanes::Add(Lanes::Mul(m[0][row], x), Lanes::Mul(m[1][row], y)), Lanes::Mul(m[2][row], z));
+				} };
+
+			// Clip position, view direction, normal and tangent of every lane, written out per vertex afterwards
+			// The tangent handedness does not change with the transform, it is copied from the streams
+			alignas(32) float out[13][NrLanes]{};
+			Vector2 uvs[NrLanes]{};
+
+			for (size_t blockIdx{ first }; blockIdx < last; blockIdx += NrLanes)
+			{
+				const auto [positionX, positionY, positionZ, normalX, normalY, normalZ, tangentX, tangentY, tangentZ] { LoadVertices<Lanes>(streams, blockIdx) };
+
+				// to Clip-Space, the renderer clips the triangles before the perspective divide
+				const Type clipX{ transformPoint(0, positionX, positionY, positionZ) };
+				const Type clipY{ transformPoint(1, positionX, positionY, positionZ) };
+				const Type clipZ{ transformPoint(2, positionX, positionY, positionZ) };
+				const Type clipW{ transformPoint(3, positionX, positionY, positionZ) };
+
+				// The viewdirection is just the normalized xyz of the transformed position
+				const Type length{ Lanes::Sqrt(Lanes::Add(Lanes::Add(Lanes::Mul(clipX, clipX), Lanes::Mul(clipY, clipY)), Lanes::Mul(clipZ, clipZ))) };
+
+				Lanes::Store(out[0], clipX);
+				Lanes::Store(out[1], clipY);
+				Lanes::Store(out[2], clipZ);
+				Lanes::Store(out[3], clipW);
+				Lanes::Store(out[4], Lanes::Div(clipX, length));
+				Lanes::Store(out[5], Lanes::Div(clipY, length));
+				Lanes::Store(out[6], Lanes::Div(clipZ, length));
+				Lanes::Store(out[7], transformVector(0, normalX, normalY, normalZ));
+				Lanes::Store(out[8], transformVector(1, normalX, normalY, normalZ));
+				Lanes::Store(out[9], transformVector(2, normalX, normalY, normalZ));
+				Lanes::Store(out[10], transformVector(0, tangentX, tangentY, tangentZ));
+				Lanes::Store(out[11], transformVector(1, tangentX, tangentY, tangentZ));
+				Lanes::Store(out[12], transformVector(2, tangentX, tangentY, tangentZ));
+
+				LoadUVs<Lanes>(streams, blockIdx, uvs);
+
+				const int nrLanes{ int(std::min(last - blockIdx, size_t(NrLanes))) };
+				for (int lane{}; lane < nrLanes; ++lane)
+				{
+					Vertex_Out& vertexOut{ pVerticesOut[blockIdx + lane] };
+					vertexOut.position = Vector4{ out[0][lane], out[1][lane], out[2][lane], out[3][lane] };
+					vertexOut.viewDirection = Vector3{ out[4][lane], out[5][lane], out[6][lane] };
+					vertexOut.uv = uvs[lane];
+					vertexOut.normal = Vector3{ out[7][lane], out[8][lane], out[9][lane] };
+					vertexOut.tangent = Vector4{ out[10][lane], out[11][lane], out[12][lane], float(streams.tangentSigns[blockIdx + lane]) };
+				}
+			}
+		}
+	}
+
+	namespace VertexKernels
+	{
+		VertexKernel GetKernel(RasterKernelType type)
+		{
+			switch (type)
+			{
+			case RasterKernelType::SSE41:
+				return { type, &TransformVertices<SSE41Lanes, VertexStreams>, &TransformVertices<SSE41Lanes, QuantizedVertexStreams> };
+			case RasterKernelType::AVX2:
+				return { type, &TransformVertices<AVX2Lanes, VertexStreams>, &TransformVertices<AVX2Lanes, QuantizedVertexStreams> };
+			default:
+				return { RasterKernelType::Scalar, &TransformVertices<ScalarLanes, VertexStreams>, &TransformVertices<ScalarLanes, QuantizedVertexStreams> };
+			}
+		}
+	}
+}
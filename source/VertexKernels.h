@@ -0,0 +1,71 @@
+#pragma once
+#include "DataTypes.h"
+#include "RasterKernels.h"
+
+namespace dae
+{
+	// The mesh vertices in structure of arrays form, so a kernel loads the same component of several vertices at once
+	// Every stream is padded to a whole number of MaxLanes, the padding gets transformed but is never written out
+	struct VertexStreams final
+	{
+		static constexpr int MaxLanes{ 8 };
+
+		void Assign(const std::vector<Vertex>& vertices);
+
+		size_t nrVertices{};
+		std::vector<float> positionX{};
+		std::vector<float> positionY{};
+		std::vector<float> positionZ{};
+		std::vector<float> normalX{};
+		std::vector<float> normalY{};
+		std::vector<float> normalZ{};
+		std::vector<float> tangentX{};
+		std::vector<float> tangentY{};
+		std::vector<float> tangentZ{};
+		// The tangent handedness, -1 or 1
+		std::vector<int8_t> tangentSigns{};
+		std::vector<Vector2> uvs{};
+
+		size_t GetMemorySize() const;
+	};
+
+	// The compact variant: positions as 16 bit unorms over the mesh bounds, octahedral 16 bit normals and tangents
+	// and half float uvs, 19 bytes per vertex instead of 45
+	struct QuantizedVertexStreams final
+	{
+		void Assign(const std::vector<Vertex>& vertices, const MeshBounds& bounds);
+
+		size_t nrVertices{};
+		Vector3 positionOffset{};
+		Vector3 positionScale{};
+		std::vector<uint16_t> positionX{};
+		std::vector<uint16_t> positionY{};
+		std::vector<uint16_t> positionZ{};
+		std::vector<int16_t> normalU{};
+		std::vector<int16_t> normalV{};
+		std::vector<int16_t> tangentU{};
+		std::vector<int16_t> tangentV{};
+		std::vector<int8_t> tangentSigns{};
+		std::vector<uint16_t> uvU{};
+		std::vector<uint16_t> uvV{};
+
+		size_t GetMemorySize() const;
+	};
+
+	struct VertexKernel final
+	{
+		RasterKernelType type{ RasterKernelType::Scalar };
+		// Transforms the vertices [first, last[ to clip space, first has to be a multiple of MaxLanes
+		void(*pTransformVertices)(const VertexStreams& streams, const Matrix& worldViewProjection, const Matrix& world,
+			Vertex_Out* pVerticesOut, size_t first, size_t last) { nullptr };
+		// Same for the quantized streams, decoded while they get loaded
+		void(*pTransformQuantizedVertices)(const QuantizedVertexStreams& streams, const Matrix& worldViewProjection, const Matrix& world,
+			Vertex_Out* pVerticesOut, size_t first, size_t last) { nullptr };
+	};
+
+	namespace VertexKernels
+	{
+		// Uses the same instruction sets as the raster kernels, all kernels produce bit-identical results
+		VertexKernel GetKernel(RasterKernelType type);
+	}
+}
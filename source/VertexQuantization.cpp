@@ -0,0 +1,73 @@
+#include "pch.h"
+#include "VertexQuantization.h"
+
+#include <cstring>
+
+namespace dae
+{
+	namespace VertexQuantization
+	{
+		PositionQuantization GetPositionQuantization(const MeshBounds& bounds)
+		{
+			const Vector3 extent{ bounds.max - bounds.min };
+			return { bounds.min, extent / 65535.f };
+		}
+
+		void EncodePosition(const PositionQuantization& quantization, const Vector3& position, uint16_t encoded[3])
+		{
+			for (int i{}; i < 3; ++i)
+			{
+				// A flat axis has no scale, everything sits on the offset
+				const float normalized{ quantization.scale[i] > 0.f ? (position[i] - quantization.offset[i]) / (quantization.scale[i] * 65535.f) : 0.f };
+				encoded[i] = uint16_t(std::lround(std::clamp(normalized, 0.f, 1.f) * 65535.f));
+			}
+		}
+
+		void EncodeOctahedral(const Vector3& direction, int16_t encoded[2])
+		{
+			const float length{ fabsf(direction.x) + fabsf(direction.y) + fabsf(direction.z) };
+			if (!(length > 0.f))
+			{
+				// No direction at all, decodes to +z
+				encoded[0] = encoded[1] = 0;
+				return;
+			}
+
+			float x{ direction.x / length };
+			float y{ direction.y / length };
+			if (direction.z < 0.f)
+			{
+				// The lower half gets folded over the diagonals
+				const float foldedX{ (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f) };
+				const float foldedY{ (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f) };
+				x = foldedX;
+				y = foldedY;
+			}
+
+			encoded[0] = int16_t(std::lround(std::clamp(x, -1.f, 1.f) * 32767.f));
+			encoded[1] = int16_t(std::lround(std::clamp(y, -1.f, 1.f) * 32767.f));
+		}
+
+		uint16_t FloatToHalf(float value)
+		{
+			uint32_t bits{};
+			std::memcpy(&bits, &value, sizeof(bits));
+			const uint16_t sign{ uint16_t((bits >> 16) & 0x8000) };
+			bits &= 0x7FFFFFFF;
+
+			// Infinity and NaN, NaN keeps a mantissa bit
+			if (bits >= 0x7F800000)
+				return uint16_t(sign | 0x7C00 | (bits > 0x7F800000 ? 0x200 : 0));
+			// Everything from 65520 on rounds to infinity
+			if (bits >= 0x477FF000)
+				return uint16_t(sign | 0x7C00);
+			// Below the smallest normal half, in steps of 2^-24
+			if (bits < 0x38800000)
+				return uint16_t(sign | uint16_t(std::nearbyint(fabsf(value) * 16777216.f)));
+
+			// Rebias the exponent from 127 to 15 and round the 13 dropped mantissa bits to nearest even
+			bits += 0xC8000FFF + ((bits >> 13) & 1);
+			return uint16_t(sign | (bits >> 13));
+		}
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "DataTypes.h"
+
+namespace dae
+{
+	// Encodings of the compact vertex format, the decoding happens in the vertex kernels and the vertex shader
+	namespace VertexQuantization
+	{
+		// Positions are stored as 16 bit unorms over the mesh bounds: position = offset + quantized * scale
+		struct PositionQuantization final
+		{
+			Vector3 offset{};
+			Vector3 scale{};
+		};
+		PositionQuantization GetPositionQuantization(const MeshBounds& bounds);
+		void EncodePosition(const PositionQuantization& quantization, const Vector3& position, uint16_t encoded[3]);
+
+		// Unit vectors folded onto an octahedron and stored as two 16 bit snorms
+		void EncodeOctahedral(const Vector3& direction, int16_t encoded[2]);
+
+		// IEEE half floats, rounded to nearest even
+		uint16_t FloatToHalf(float value);
+	}
+}
@@ -85,13 +85,14 @@ int main(int argc, char* args[])
 							std::cout << "Stopped FPS printing\n";
 						break;
 
+					case SDL_SCANCODE_F4:
+						pRenderer->ToggleFilteringMethod();
+						break;
+
 					//HARDWARE ONLY
 					case SDL_SCANCODE_F3:
 						pRenderer->ToggleFireRendering();
 						break;
-					case SDL_SCANCODE_F4:
-						pRenderer->ToggleFilteringMethod();
-						break;
 
 					//SOFTWARE ONLY
 					case SDL_SCANCODE_F5:
@@ -106,6 +107,45 @@ int main(int argc, char* args[])
 					case SDL_SCANCODE_F8:
 						pRenderer->ToggleBoundingBoxVisualization();
 						break;
+					case SDL_SCANCODE_C:
+						pRenderer->ToggleCameraFlyThrough();
+						break;
+					case SDL_SCANCODE_T:
+						pRenderer->CycleThreadCount();
+						break;
+					case SDL_SCANCODE_K:
+						pRenderer->CycleRasterKernel();
+						break;
+					case SDL_SCANCODE_V:
+						pRenderer->ToggleRasterizerValidation();
+						break;
+					case SDL_SCANCODE_H:
+						pRenderer->ToggleHierarchicalDepth();
+						break;
+					case SDL_SCANCODE_G:
+						pRenderer->ToggleDeferredShading();
+						break;
+					case SDL_SCANCODE_P:
+						pRenderer->ToggleFixedPointRasterization();
+						break;
+					case SDL_SCANCODE_L:
+						pRenderer->ToggleFramebufferLayout();
+						break;
+					case SDL_SCANCODE_X:
+						pRenderer->ToggleTexelLayout();
+						break;
+					case SDL_SCANCODE_I:
+						pRenderer->ToggleStatistics();
+						break;
+					case SDL_SCANCODE_N:
+						pRenderer->ToggleQuantizedVertices();
+						break;
+					case SDL_SCANCODE_M:
+						pRenderer->ToggleMeshletCulling();
+						break;
+					case SDL_SCANCODE_O:
+						pRenderer->CycleLodMode();
+						break;
 				}
 				break;
 			default:;
@@ -127,6 +167,7 @@ int main(int argc, char* args[])
 			{
 				printTimer = 0.f;
 				std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
+				pRenderer->PrintStatistics();
 			}
 		}
 	}